@@ -0,0 +1,413 @@
+#include "BT.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+// Trees are tiny, so it takes a fair few agents per chunk before handing them out is worth it
+static size_t const AGENT_GRAIN = 32;
+
+BT::Agent::Agent(Tree const* tree_, int type)
+{
+	tree = tree_;
+	isBoss = (type == 0);
+	isVertical = (type == 2);
+}
+
+uint16_t BT::Builder::begin(Op op)
+{
+	uint16_t at = leaf(op);
+	open.push_back(at);
+	return at;
+}
+
+void BT::Builder::end()
+{
+	assert(!open.empty());
+	tree.nodes[open.back()].end = (uint16_t)tree.nodes.size();
+	open.pop_back();
+}
+
+uint16_t BT::Builder::leaf(Op op, bool negate, float min, float max)
+{
+	uint16_t at = (uint16_t)tree.nodes.size();
+	Node n;
+	n.op = op;
+	n.negate = negate;
+	n.end = at + 1;
+	n.min = min;
+	n.max = max;
+	tree.nodes.push_back(n);
+
+	if(op == PLAYER_IN_RANGE)
+	{
+		for(float t : {min, max})
+		{
+			if(std::find(tree.thresholds.begin(), tree.thresholds.end(), t) == tree.thresholds.end())
+			{
+				assert(tree.thresholds.size() < MAX_THRESHOLDS);
+				tree.thresholds.push_back(t);
+			}
+		}
+	}
+	if(op == TOOK_HIT)
+	{
+		tree.watchesHits = true;
+	}
+	return at;
+}
+
+uint16_t BT::Builder::action(Op op, float cooldown)
+{
+	assert(tree.timers < MAX_TIMERS);
+	uint16_t at = leaf(op, false, 0.0f, cooldown);
+	tree.cooldowns[tree.timers] = cooldown;
+	tree.nodes[at].timer = tree.timers++;
+	return at;
+}
+
+// Soldier: nothing to do without a player, otherwise close in from up to 20 away and swing once within 4.5
+static void build_soldier(BT::Builder& b)
+{
+	b.tree.root = b.begin(BT::SELECTOR);
+		b.leaf(BT::PLAYER_EXISTS, true);
+		b.begin(BT::SELECTOR);
+			b.begin(BT::SEQUENCE);
+				b.leaf(BT::PLAYER_IN_RANGE, false, 4.5f, 20.0f);
+				b.leaf(BT::WALK_TO_PLAYER, false, 4.0f);
+			b.end();
+			b.begin(BT::SEQUENCE);
+				b.leaf(BT::PLAYER_IN_RANGE, false, 0.0f, 4.5f);
+				b.action(BT::ATTACK, 5.0f);
+			b.end();
+		b.end();
+	b.end();
+}
+
+BT::Tree const& BT::Tree::soldier()
+{
+	static Tree const tree = []() -> Tree
+		{
+			Builder b;
+			build_soldier(b);
+			return b.tree;
+		}();
+	return tree;
+}
+
+BT::Tree const& BT::Tree::boss()
+{
+	// Fights like a soldier, but parries anything the player swings at it up close
+	static Tree const tree = []() -> Tree
+		{
+			Builder b;
+			build_soldier(b);
+			b.tree.interrupt = b.begin(SEQUENCE);
+				b.leaf(PLAYER_IN_RANGE, false, 0.0f, 4.5f);
+				b.action(PARRY, 0.0f);
+			b.end();
+			return b.tree;
+		}();
+	return tree;
+}
+
+// The doing part of an action, what run and react's quiet path share
+static bool act(BT::Agent& agent, BT::Node const& n, SimClock const& clock)
+{
+	switch(n.op)
+	{
+	case BT::WALK_TO_PLAYER:
+		if(agent.distanceToPlayer > n.min)
+		{
+			float const EnemySpeed = 2.0f;
+			agent.move = glm::normalize(agent.toPlayer) * EnemySpeed;
+			agent.rotate = agent.bearingToPlayer;
+		}
+		return true;
+	case BT::ATTACK:
+		if(!agent.timers[n.timer].ready(clock, n.max)) return false;
+		if(agent.isBoss)
+		{
+			agent.attacks++;
+			agent.attack = (agent.attacks % 2 == 0) ? 1 : 2;
+		}
+		else
+		{
+			agent.attack = agent.isVertical ? 1 : 2;
+		}
+		agent.timers[n.timer].start(clock);
+		return true;
+	case BT::PARRY:
+		if(!agent.timers[n.timer].ready(clock, n.max)) return false;
+		agent.parry = 1;
+		agent.timers[n.timer].start(clock);
+		return true;
+	default:
+		return false;
+	}
+}
+
+static bool run(BT::Agent& agent, std::vector<BT::Node> const& nodes, uint16_t at, SimClock const& clock)
+{
+	BT::Node const& n = nodes[at];
+	switch(n.op)
+	{
+	case BT::SEQUENCE:
+		for(uint16_t child = at + 1; child < n.end; child = nodes[child].end)
+		{
+			if(!run(agent, nodes, child, clock)) return false;
+		}
+		return true;
+	case BT::SELECTOR:
+		for(uint16_t child = at + 1; child < n.end; child = nodes[child].end)
+		{
+			if(run(agent, nodes, child, clock)) return true;
+		}
+		return false;
+	case BT::PLAYER_EXISTS:
+		return agent.hasPlayer != n.negate;
+	case BT::PLAYER_IN_RANGE:
+		return (agent.distanceToPlayer < n.max && agent.distanceToPlayer > n.min) != n.negate;
+	case BT::TOOK_HIT:
+		return agent.tookHit != n.negate;
+	case BT::WALK_TO_PLAYER:
+	case BT::ATTACK:
+	case BT::PARRY:
+		{
+			// Remembers enough for react to know when running the whole tree again could come out differently
+			bool cooling = (n.timer != BT::NONE && n.max > 0.0f);
+			if(!act(agent, n, clock))
+			{
+				agent.waiting |= (uint8_t)(1u << n.timer);
+				return false;
+			}
+			if(cooling || agent.runningCount == BT::MAX_RUNNING)
+			{
+				// Its cooldown just started, so next time this goes differently
+				agent.settled = false;
+			}
+			else
+			{
+				agent.running[agent.runningCount++] = at;
+			}
+			return true;
+		}
+	}
+	return false;
+}
+
+static void evaluate(BT::Agent& agent, SimClock const& clock)
+{
+	BT::Tree const& tree = *agent.tree;
+	agent.settled = true;
+	agent.waiting = 0;
+	agent.runningCount = 0;
+	if(tree.interrupt != BT::NONE && agent.playerAttacking)
+	{
+		run(agent, tree.nodes, tree.interrupt, clock);
+	}
+	else if(tree.root != BT::NONE)
+	{
+		run(agent, tree.nodes, tree.root, clock);
+	}
+}
+
+// Everything the tree's conditions could possibly read, boiled down to the answers they'd get
+static uint64_t listen(BT::Agent const& agent)
+{
+	BT::Tree const& tree = *agent.tree;
+	uint64_t heard = (uint64_t)agent.hasPlayer;
+	if(tree.interrupt != BT::NONE)
+	{
+		heard |= (uint64_t)agent.playerAttacking << 1;
+	}
+	if(tree.watchesHits)
+	{
+		heard |= (uint64_t)agent.tookHit << 2;
+	}
+	for(size_t i = 0; i < tree.thresholds.size(); i++)
+	{
+		heard |= (uint64_t)(agent.distanceToPlayer > tree.thresholds[i]) << (4 + 2 * i);
+		heard |= (uint64_t)(agent.distanceToPlayer < tree.thresholds[i]) << (5 + 2 * i);
+	}
+	return heard;
+}
+
+void BT::tick(Agent& agent, SimClock const& clock)
+{
+	evaluate(agent, clock);
+	agent.settled = false; // Nothing listened for, so react can't trust any of it
+	agent.tookHit = false;
+}
+
+void BT::react(Agent& agent, SimClock const& clock)
+{
+	Tree const& tree = *agent.tree;
+	uint64_t heard = listen(agent);
+
+	bool woken = false;
+	for(uint16_t t = 0; t < tree.timers; t++)
+	{
+		if((agent.waiting & (1u << t)) && agent.timers[t].ready(clock, tree.cooldowns[t]))
+		{
+			woken = true;
+		}
+	}
+
+	if(!agent.settled || woken || heard != agent.heard)
+	{
+		agent.heard = heard;
+		evaluate(agent, clock);
+	}
+	else
+	{
+		// Nothing the conditions read moved, so the same actions would win again, just keep them going
+		for(uint8_t i = 0; i < agent.runningCount; i++)
+		{
+			act(agent, tree.nodes[agent.running[i]], clock);
+		}
+	}
+	agent.tookHit = false;
+}
+
+void BT::Crowd::clear()
+{
+	x.clear();
+	y.clear();
+	z.clear();
+	present.clear();
+}
+
+void BT::Crowd::add(glm::vec3 const& position, bool isPresent)
+{
+	x.push_back(position.x);
+	y.push_back(position.y);
+	z.push_back(position.z);
+	present.push_back(isPresent ? 1 : 0);
+}
+
+static uint64_t cell_key(int32_t x, int32_t y)
+{
+	return ((uint64_t)(uint32_t)x << 32) | (uint64_t)(uint32_t)y;
+}
+
+void BT::Crowd::sense(glm::vec3 const& player, WorkerPool& pool)
+{
+	size_t count = size();
+	playerX.resize(count);
+	playerY.resize(count);
+	playerZ.resize(count);
+	playerDistance.resize(count);
+	playerBearing.resize(count);
+	ally.resize(count);
+	allyDistance.resize(count);
+
+	// Anyone within allyRange of an agent is in one of the 3x3 cells around it, so with everyone sorted by cell the
+	// nearest ally search only looks there instead of at the whole crowd. Enemies stay on the ground, so x and y will do
+	// (the distances are still 3d)
+	float const range = allyRange;
+	auto cell_of = [range](float v) -> int32_t { return (int32_t)std::floor(v / range); };
+	cells.clear();
+	if(range > 0.0f)
+	{
+		for(uint32_t i = 0; i < (uint32_t)count; i++)
+		{
+			if(present[i])
+			{
+				cells.emplace_back(cell_key(cell_of(x[i]), cell_of(y[i])), i);
+			}
+		}
+		std::sort(cells.begin(), cells.end());
+	}
+
+	pool.parallel_for(count, AGENT_GRAIN, [this, &player, range, &cell_of](size_t begin, size_t end)
+		{
+			// Straight passes over the packed axes, nothing in here chases a pointer
+			for(size_t i = begin; i < end; i++)
+			{
+				playerX[i] = player.x - x[i];
+				playerY[i] = player.y - y[i];
+				playerZ[i] = player.z - z[i];
+			}
+			for(size_t i = begin; i < end; i++)
+			{
+				playerDistance[i] = std::sqrt(playerX[i] * playerX[i] + playerY[i] * playerY[i] + playerZ[i] * playerZ[i]);
+			}
+			for(size_t i = begin; i < end; i++)
+			{
+				playerBearing[i] = std::atan2(playerY[i], playerX[i]);
+			}
+
+			for(size_t i = begin; i < end; i++)
+			{
+				float best = range * range;
+				uint32_t bestAt = (uint32_t)i;
+				if(present[i] && range > 0.0f)
+				{
+					int32_t cx = cell_of(x[i]);
+					int32_t cy = cell_of(y[i]);
+					for(int32_t dx = -1; dx <= 1; dx++)
+					{
+						for(int32_t dy = -1; dy <= 1; dy++)
+						{
+							uint64_t key = cell_key(cx + dx, cy + dy);
+							auto it = std::lower_bound(cells.begin(), cells.end(), std::make_pair(key, (uint32_t)0));
+							for(; it != cells.end() && it->first == key; it++)
+							{
+								uint32_t j = it->second;
+								if(j == i) continue;
+								float ax = x[j] - x[i];
+								float ay = y[j] - y[i];
+								float az = z[j] - z[i];
+								float d2 = ax * ax + ay * ay + az * az;
+								// Ties go to the lowest index, so the answer doesn't depend on how the cells are laid out
+								if(d2 < best || (d2 == best && (bestAt == i || j < bestAt)))
+								{
+									best = d2;
+									bestAt = j;
+								}
+							}
+						}
+					}
+				}
+				ally[i] = bestAt;
+				allyDistance[i] = (bestAt == i) ? std::numeric_limits<float>::infinity() : std::sqrt(best);
+			}
+		});
+}
+
+void BT::Crowd::apply(size_t i, Agent& agent) const
+{
+	agent.toPlayer = glm::vec3(playerX[i], playerY[i], playerZ[i]);
+	agent.distanceToPlayer = playerDistance[i];
+	agent.bearingToPlayer = playerBearing[i];
+	uint32_t j = ally[i];
+	agent.toAlly = glm::vec3(x[j] - x[i], y[j] - y[i], z[j] - z[i]);
+	agent.distanceToAlly = allyDistance[i];
+}
+
+void BT::think(Crowd const& crowd, std::vector<Agent*> const& agents, bool hasPlayer, bool playerAttacking, SimClock const& clock, WorkerPool& pool, bool reactive)
+{
+	pool.parallel_for(agents.size(), AGENT_GRAIN, [&crowd, &agents, hasPlayer, playerAttacking, &clock, reactive](size_t begin, size_t end)
+		{
+			for(size_t i = begin; i < end; i++)
+			{
+				if(!agents[i]) continue;
+				Agent& agent = *agents[i];
+				agent.hasPlayer = hasPlayer;
+				agent.playerAttacking = playerAttacking;
+				if(hasPlayer)
+				{
+					crowd.apply(i, agent);
+				}
+				if(reactive)
+				{
+					react(agent, clock);
+				}
+				else
+				{
+					tick(agent, clock);
+				}
+			}
+		});
+}
@@ -0,0 +1,169 @@
+#ifndef BT_HPP
+#define BT_HPP
+
+#include "SimClock.hpp"
+#include "WorkerPool.hpp"
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+// Compiled behavior trees: a tree is one flat array of nodes shared by every enemy of that kind, and each enemy only
+// carries an Agent (what it knows, what it decided, its cooldowns)
+namespace BT
+{
+	static uint16_t const NONE = std::numeric_limits<uint16_t>::max();
+
+	enum Op : uint8_t
+	{
+		// Composites, children are the nodes right after them up to end
+		SEQUENCE, // Runs children until one fails
+		SELECTOR, // Runs children until one succeeds
+
+		// Conditions
+		PLAYER_EXISTS,
+		PLAYER_IN_RANGE, // Distance to the player in (min, max)
+		TOOK_HIT, // Got hit since the last tick
+
+		// Actions
+		WALK_TO_PLAYER, // Heads for the player unless already closer than min, always succeeds
+		ATTACK, // Fails while cooling down (max simulated seconds), bosses alternate swings
+		PARRY // Fails while cooling down (max simulated seconds)
+	};
+
+	struct Node
+	{
+		Op op = SEQUENCE;
+		bool negate = false; // Conditions only, succeed when the test fails
+		uint16_t end = 0; // One past this node's last descendant, a parent gets to its next child through this
+		uint16_t timer = NONE; // Which of the agent's cooldown timers an action uses
+		float min = 0.0f;
+		float max = 0.0f;
+	};
+
+	static size_t const MAX_TIMERS = 4;
+	static size_t const MAX_THRESHOLDS = 30; // Two bits apiece in what react listens for, next to the yes/no senses
+	static size_t const MAX_RUNNING = 4;
+
+	// Nodes are depth first, so every subtree is a contiguous run starting at its root
+	struct Tree
+	{
+		std::vector<Node> nodes;
+		uint16_t root = NONE;
+		uint16_t interrupt = NONE; // Runs instead of root while the player is attacking, if there is one
+		uint16_t timers = 0;
+		std::array<float, MAX_TIMERS> cooldowns = {}; // Per timer, so a waiting agent can tell when one runs out
+
+		// Every distance some PLAYER_IN_RANGE compares against, react only wakes up when one of those comparisons flips
+		std::vector<float> thresholds;
+		bool watchesHits = false;
+
+		// Built the first time they're asked for, then shared
+		static Tree const& soldier();
+		static Tree const& boss();
+	};
+
+	// One enemy's side of things, small and flat so a whole crowd of them is cheap to keep and walk
+	struct Agent
+	{
+		Tree const* tree = nullptr;
+
+		bool isBoss = false;
+		bool isVertical = false; // Soldiers always swing the same way, this says which
+
+		// Senses, filled in before every tick
+		bool hasPlayer = false;
+		bool playerAttacking = false;
+		glm::vec3 toPlayer = glm::vec3(0.0f);
+		float distanceToPlayer = 100.0f;
+		float bearingToPlayer = 0.0f; // Heading (about z) that faces the player
+		glm::vec3 toAlly = glm::vec3(0.0f); // Toward the closest other agent
+		float distanceToAlly = std::numeric_limits<float>::infinity(); // Infinite when there isn't one within the crowd's allyRange
+		bool tookHit = false; // Set whenever this agent's pawn gets hit, the next tick uses it up
+
+		// Decisions, taken (and reset) by whoever applies them to the pawn
+		glm::vec3 move = glm::vec3(0.0f);
+		float rotate = 0.0f;
+		uint8_t attack = 0;
+		uint8_t parry = 0;
+
+		// Cooldowns for the tree's actions, indexed by Node::timer
+		std::array<SimTimer, MAX_TIMERS> timers;
+		uint32_t attacks = 0;
+
+		// What react remembers from the last full evaluation:
+		bool settled = false; // False forces the next react all the way through the tree
+		uint64_t heard = 0; // Everything the tree's conditions depended on
+		uint8_t waiting = 0; // Timers (as bits) whose cooldown turned an action down
+		std::array<uint16_t, MAX_RUNNING> running; // Actions that went through and keep going until something changes
+		uint8_t runningCount = 0;
+
+		Agent() = default;
+		Agent(Tree const* tree_, int type); // 0 is boss, 1 soldier swinging horizontally, 2 soldier swinging vertically
+	};
+
+	// Runs the agent's tree once, from the interrupt if it applies and from the root otherwise
+	void tick(Agent& agent, SimClock const& clock);
+
+	// Same decisions tick would make, but only goes through the tree when something its conditions read has changed:
+	// the player showing up or leaving, the distance crossing one of the tree's ranges, the player starting or stopping
+	// an attack, a hit, or a cooldown that turned an action down running out
+	// Otherwise it just keeps the actions from last time running, so an enemy with nothing going on costs a compare
+	void react(Agent& agent, SimClock const& clock);
+
+	// Works out everyone's senses in one go, over positions packed one axis per array
+	// Fill it with add (in whatever order the agents are kept), sense, then copy each agent's results over with apply
+	struct Crowd
+	{
+		// In:
+		std::vector<float> x, y, z;
+		std::vector<uint8_t> present; // Zero for a slot nobody's standing in (an agent without a pawn), it's nobody's ally
+
+		// Nobody further than this counts as an ally, it's also how big the cells are that sense sorts everyone into
+		float allyRange = 20.0f;
+
+		// Out, same order as in:
+		std::vector<float> playerX, playerY, playerZ; // Offset to the player
+		std::vector<float> playerDistance, playerBearing;
+		std::vector<uint32_t> ally; // Index of the closest other agent within allyRange, or the agent's own when there's none
+		std::vector<float> allyDistance;
+
+		// (cell, index) of everyone present, sorted so each cell is a contiguous run, kept to save reallocating it
+		std::vector<std::pair<uint64_t, uint32_t>> cells;
+
+		void clear();
+		void add(glm::vec3 const& position, bool isPresent = true);
+		size_t size() const { return x.size(); }
+
+		// The player is the same for everyone, so only its position goes in
+		// Every agent's results only depend on the positions, so splitting it over the pool doesn't change them
+		void sense(glm::vec3 const& player, WorkerPool& pool);
+		void apply(size_t i, Agent& agent) const;
+	};
+
+	// Hands each agent its senses from the crowd and ticks it, agents[i] goes with the crowd's i-th position (null ones
+	// are skipped, and the crowd is left alone when there's no player)
+	// An agent only reads the crowd and its own tree and only writes itself, so running them all at once on the pool gives
+	// exactly what running them one by one does
+	// Ticks with react, or with tick when reactive is off
+	void think(Crowd const& crowd, std::vector<Agent*> const& agents, bool hasPlayer, bool playerAttacking, SimClock const& clock, WorkerPool& pool, bool reactive = true);
+
+	// Mostly for making more trees like soldier and boss
+	// begin/end bracket a composite, everything added in between is its children
+	struct Builder
+	{
+		Tree tree;
+		std::vector<uint16_t> open;
+
+		uint16_t begin(Op op);
+		void end();
+		uint16_t leaf(Op op, bool negate = false, float min = 0.0f, float max = 0.0f);
+		uint16_t action(Op op, float cooldown);
+	};
+}
+
+#endif
@@ -11,52 +11,66 @@ Load< BarTextureProgram > bar_texture_program(LoadTagEarly, []() -> BarTexturePr
 	return ret;
 });
 
+//fragment shader shared by the screen-space and world-anchored programs:
+static char const *bar_texture_fragment_shader =
+	"#version 330\n"
+	"uniform sampler2D TEX;\n"
+	"in vec2 texCoord;\n"
+	"in float val;\n"
+	"in float percent;\n"
+	"in float alpha;\n"
+	"in vec3 fullColor;\n"
+	"in vec3 emptyColor;\n"
+	"out vec4 fragColor;\n"
+	"void main() {\n"
+	"   vec4 co = texture(TEX, texCoord);\n"
+	"   if(co.rgb == vec3(0, 0, 0) && co.a > 0)\n"
+	"   {\n"
+	"      if(val <= percent)\n"
+	"      {\n"
+	"         fragColor = vec4(fullColor * percent + emptyColor * (1.0 - percent), co.a * alpha);"
+	"      }\n"
+	"      else\n"
+	"      {\n"
+	"	      fragColor = vec4(co.rgb, co.a * alpha); \n"
+	"      }\n"
+	"   }\n"
+	"   else\n"
+	"   {\n"
+	"	      fragColor = vec4(co.rgb, co.a * alpha); \n"
+	"   }\n"
+	"}\n";
+
 BarTextureProgram::BarTextureProgram() {
 	//Compile vertex and fragment shaders using the convenient 'gl_compile_program' helper function:
 	program = gl_compile_program(
 		//vertex shader:
 		"#version 330\n"
-		"uniform vec4 CLIPPOS;\n"
-		"uniform vec2 SCALE;\n"
 		"in vec4 Position;\n"
 		"in vec2 TexCoord;\n"
 		"in float Val;\n"
+		"in float Percent;\n"
+		"in float Alpha;\n"
+		"in vec3 FullColor;\n"
+		"in vec3 EmptyColor;\n"
 		"out vec2 texCoord;\n"
 		"out float val;\n"
+		"out float percent;\n"
+		"out float alpha;\n"
+		"out vec3 fullColor;\n"
+		"out vec3 emptyColor;\n"
 		"void main() {\n"
-		"	gl_Position = vec4(Position.x * SCALE.x, Position.y * SCALE.y, Position.zw) + CLIPPOS;\n"
+		"	gl_Position = Position;\n"
 		"	texCoord = TexCoord;\n"
 		"   val = Val;\n"
+		"   percent = Percent;\n"
+		"   alpha = Alpha;\n"
+		"   fullColor = FullColor;\n"
+		"   emptyColor = EmptyColor;\n"
 		"}\n"
 	,
 		//fragment shader:
-		"#version 330\n"
-		"uniform sampler2D TEX;\n"
-		"uniform float PERCENT; \n"
-		"uniform float ALPHA; \n"
-		"uniform vec3 FULLCO; \n"
-		"uniform vec3 EMPTYCO; \n"
-		"in vec2 texCoord;\n"
-		"in float val;\n"
-		"out vec4 fragColor;\n"
-		"void main() {\n"
-		"   vec4 co = texture(TEX, texCoord);\n"
-		"   if(co.rgb == vec3(0, 0, 0) && co.a > 0)\n"
-		"   {\n"
-		"      if(val <= PERCENT)\n"
-		"      {\n"
-		"         fragColor = vec4(FULLCO * PERCENT + EMPTYCO * (1.0 - PERCENT), co.a * ALPHA);"
-		"      }\n"
-		"      else\n"
-		"      {\n"
-		"	      fragColor = vec4(co.rgb, co.a * ALPHA); \n"
-		"      }\n"
-		"   }\n"
-		"   else\n"
-		"   {\n"
-		"	      fragColor = vec4(co.rgb, co.a * ALPHA); \n"
-		"   }\n"
-		"}\n"
+		bar_texture_fragment_shader
 	);
 	//As you can see above, adjacent strings in C/C++ are concatenated.
 	// this is very useful for writing long shader programs inline.
@@ -65,14 +79,10 @@ BarTextureProgram::BarTextureProgram() {
 	Position_vec4 = glGetAttribLocation(program, "Position");
 	TexCoord_vec2 = glGetAttribLocation(program, "TexCoord");
 	Val_f = glGetAttribLocation(program, "Val");
-
-	//look up the locations of uniforms:
-	PERCENT_float = glGetUniformLocation(program, "PERCENT");
-	ALPHA_float = glGetUniformLocation(program, "ALPHA");
-	FULLCO_vec3 = glGetUniformLocation(program, "FULLCO");
-	EMPTYCO_vec3 = glGetUniformLocation(program, "EMPTYCO");
-	CLIPPOS_vec4 = glGetUniformLocation(program, "CLIPPOS");
-	SCALE_vec2 = glGetUniformLocation(program, "SCALE");
+	Percent_f = glGetAttribLocation(program, "Percent");
+	Alpha_f = glGetAttribLocation(program, "Alpha");
+	FullColor_vec3 = glGetAttribLocation(program, "FullColor");
+	EmptyColor_vec3 = glGetAttribLocation(program, "EmptyColor");
 
 	GLuint TEX_sampler2D = glGetUniformLocation(program, "TEX");
 
@@ -82,9 +92,69 @@ BarTextureProgram::BarTextureProgram() {
 	glUniform1i(TEX_sampler2D, 0); //set TEX to sample from GL_TEXTURE0
 
 	glUseProgram(0); //unbind program -- glUniform* calls refer to ??? now
+
+	//World-anchored variant: one instance per bar, projected to the anchor in the vertex shader
+	anchored_program = gl_compile_program(
+		//vertex shader:
+		"#version 330\n"
+		"uniform mat4 WORLD_TO_CLIP;\n"
+		"in vec4 Position;\n" //unit quad corner, per-vertex
+		"in vec2 TexCoord;\n"
+		"in float Side;\n" //0 on the left corners, 1 on the right
+		"in vec3 Anchor;\n" //everything below is per-instance
+		"in vec2 Scale;\n"
+		"in vec2 Values;\n" //val at the left and right edges
+		"in float Percent;\n"
+		"in float Alpha;\n"
+		"in vec3 FullColor;\n"
+		"in vec3 EmptyColor;\n"
+		"out vec2 texCoord;\n"
+		"out float val;\n"
+		"out float percent;\n"
+		"out float alpha;\n"
+		"out vec3 fullColor;\n"
+		"out vec3 emptyColor;\n"
+		"void main() {\n"
+		"	vec4 clip = WORLD_TO_CLIP * vec4(Anchor, 1.0);\n"
+		"	if (clip.w <= 0.0) {\n"
+		"		gl_Position = vec4(2.0, 2.0, 2.0, 1.0);\n" //behind the camera, collapse to a point outside the view volume
+		"	} else {\n"
+		"		gl_Position = vec4(Position.xy * Scale + clip.xy / clip.w, Position.z, 1.0);\n"
+		"	}\n"
+		"	texCoord = TexCoord;\n"
+		"   val = mix(Values.x, Values.y, Side);\n"
+		"   percent = Percent;\n"
+		"   alpha = Alpha;\n"
+		"   fullColor = FullColor;\n"
+		"   emptyColor = EmptyColor;\n"
+		"}\n"
+	,
+		//fragment shader:
+		bar_texture_fragment_shader
+	);
+
+	anchored_Position_vec4 = glGetAttribLocation(anchored_program, "Position");
+	anchored_TexCoord_vec2 = glGetAttribLocation(anchored_program, "TexCoord");
+	anchored_Side_f = glGetAttribLocation(anchored_program, "Side");
+	Anchor_vec3 = glGetAttribLocation(anchored_program, "Anchor");
+	Scale_vec2 = glGetAttribLocation(anchored_program, "Scale");
+	Values_vec2 = glGetAttribLocation(anchored_program, "Values");
+	anchored_Percent_f = glGetAttribLocation(anchored_program, "Percent");
+	anchored_Alpha_f = glGetAttribLocation(anchored_program, "Alpha");
+	anchored_FullColor_vec3 = glGetAttribLocation(anchored_program, "FullColor");
+	anchored_EmptyColor_vec3 = glGetAttribLocation(anchored_program, "EmptyColor");
+
+	anchored_WORLD_TO_CLIP_mat4 = glGetUniformLocation(anchored_program, "WORLD_TO_CLIP");
+	GLuint anchored_TEX_sampler2D = glGetUniformLocation(anchored_program, "TEX");
+
+	glUseProgram(anchored_program);
+	glUniform1i(anchored_TEX_sampler2D, 0);
+	glUseProgram(0);
 }
 
 BarTextureProgram::~BarTextureProgram() {
+	glDeleteProgram(anchored_program);
+	anchored_program = 0;
 	glDeleteProgram(program);
 	program = 0;
 }
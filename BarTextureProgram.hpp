@@ -14,17 +14,33 @@ struct BarTextureProgram {
 	GLuint program = 0;
 
 	//Attribute (per-vertex variable) locations:
-	GLuint Position_vec4 = -1U;
+	// (everything that used to be a per-bar uniform is a per-vertex attribute, so many bars can share one draw call)
+	GLuint Position_vec4 = -1U; //already scaled + offset into clip space
 	GLuint TexCoord_vec2 = -1U;
 	GLuint Val_f = -1U;
-
-	//Uniform (per-invocation variable) locations:
-	GLuint PERCENT_float = -1U;
-	GLuint ALPHA_float = -1U;
-	GLuint FULLCO_vec3 = -1U;
-	GLuint EMPTYCO_vec3 = -1U;
-	GLuint CLIPPOS_vec4 = -1U;
-	GLuint SCALE_vec2 = -1U;
+	GLuint Percent_f = -1U;
+	GLuint Alpha_f = -1U;
+	GLuint FullColor_vec3 = -1U;
+	GLuint EmptyColor_vec3 = -1U;
+
+	//World-anchored variant, drawn instanced over a shared unit quad; projects Anchor itself
+	GLuint anchored_program = 0;
+
+	//Attribute locations (per-vertex):
+	GLuint anchored_Position_vec4 = -1U;
+	GLuint anchored_TexCoord_vec2 = -1U;
+	GLuint anchored_Side_f = -1U;
+	//Attribute locations (per-instance):
+	GLuint Anchor_vec3 = -1U;
+	GLuint Scale_vec2 = -1U;
+	GLuint Values_vec2 = -1U;
+	GLuint anchored_Percent_f = -1U;
+	GLuint anchored_Alpha_f = -1U;
+	GLuint anchored_FullColor_vec3 = -1U;
+	GLuint anchored_EmptyColor_vec3 = -1U;
+
+	//Uniform locations:
+	GLuint anchored_WORLD_TO_CLIP_mat4 = -1U;
 
 	//Textures:
 	//TEXTURE0 - texture that is accessed by TexCoord
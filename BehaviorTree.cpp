@@ -1,6 +0,0 @@
-#include "BehaviorTree.hpp"
-#include<iostream>
-
-void BehaviorTreeTestCase(){
-
-}
@@ -1,12 +1,26 @@
 #include "Collisions.hpp"
 
 #include "glm/geometric.hpp"
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtx/norm.hpp>
 #include "read_write_chunk.hpp"
 
 #include <limits>
 #include <iostream>
 #include <fstream>
+#include <initializer_list>
 #include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <tuple>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define COLLISIONS_X86_64
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
 
 // Code in this file is very "stupid code" and should be refactored after
 // prototype phase
@@ -17,308 +31,2051 @@
 // Breaking concave meshes into convex meshes is hard and I'm not gonna do it
 // here, we can do that in blender or something.
 
-// I used https://www.youtube.com/watch?v=ajv46BSqcK4 to help visualize this algorithm
-bool GJK(Collider& a, Collider& b)
-{	
-	glm::mat4x3 altw = a.transform->make_local_to_world();
-	glm::mat4x3 bltw = b.transform->make_local_to_world();
-
-	glm::vec3 d = bltw * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f) - altw * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+// One point of the Minkowski difference A - B, along with the points of A and B that made it
+// (those are what EPA turns back into contact points)
+struct SupportPoint
+{
+	glm::vec3 p; // a - b
+	glm::vec3 a;
+	glm::vec3 b;
+};
 
-	if(glm::length(d) > (a.broadRadius + b.broadRadius))
-	{
-		return false;
-	}
+// Support mapping of A - B in world space, farthest point of A along d minus farthest point of B along -d
+// Matrices are passed in (rather than built from the transforms here) since the broad phase
+// already computed them once per collider, and the bounding sphere rejection happens there too
+// hintA and hintB are the support vertices to start climbing from, and get left on the last ones found
+struct MinkowskiPair
+{
+	Collider const& a;
+	glm::mat4x3 const& altw;
+	glm::mat4x3 const& awtl;
+	uint32_t* hintA;
+	Collider const& b;
+	glm::mat4x3 const& bltw;
+	glm::mat4x3 const& bwtl;
+	uint32_t* hintB;
 
-	glm::normalize(d);
-	
-	glm::mat4x3 awtl = a.transform->make_world_to_local();
-	glm::mat4x3 bwtl = b.transform->make_world_to_local();
+	SupportPoint support(glm::vec3 const& d) const
+		{
+			glm::vec3 da = awtl * glm::vec4(d, 0.0f);
+			glm::vec3 db = bwtl * glm::vec4(-d, 0.0f);
+			SupportPoint s;
+			s.a = altw * glm::vec4(a.farthest(da, hintA), 1.0f);
+			s.b = bltw * glm::vec4(b.farthest(db, hintB), 1.0f);
+			s.p = s.a - s.b;
+			return s;
+		}
+};
 
-	glm::vec3 da = awtl * glm::vec4(d, 0.0f);
-	glm::vec3 db = bwtl * glm::vec4(-d, 0.0f);
+// Simplex is kept with the newest point last, the usual GJK case analysis relies on that
+// (the origin can't be past anything but the newest point, we just searched toward it from the rest)
+struct Simplex
+{
+	SupportPoint pts[4];
+	uint8_t count = 0;
+};
 
-	glm::vec3 simplex[4] = {};
+static glm::vec3 cross_toward(glm::vec3 const& edge, glm::vec3 const& to)
+{
+	// Perpendicular to edge, pointing at to
+	return glm::cross(glm::cross(edge, to), edge);
+}
 
-	uint8_t simpType = 1;
-	simplex[0] = (altw * glm::vec4(a.farthest(da), 1.0f)) - (bltw * glm::vec4(b.farthest(db), 1.0f));
+static bool do_line(Simplex& s, glm::vec3& d)
+{
+	SupportPoint const A = s.pts[1];
+	SupportPoint const B = s.pts[0];
+	glm::vec3 AB = B.p - A.p;
+	glm::vec3 AO = -A.p;
 
-	d = glm::vec3(0.0f) - simplex[0];
+	if(glm::dot(AB, AO) > 0.0f)
+	{
+		d = cross_toward(AB, AO);
+		if(glm::length2(d) < 1e-12f)
+		{
+			// Origin is on the segment, so they're just touching
+			return true;
+		}
+	}
+	else
+	{
+		s.pts[0] = A;
+		s.count = 1;
+		d = AO;
+	}
+	return false;
+}
 
-	const int max_iterations = 100;
-	int iterations = 0;
+static bool do_triangle(Simplex& s, glm::vec3& d)
+{
+	SupportPoint const A = s.pts[2];
+	SupportPoint const B = s.pts[1];
+	SupportPoint const C = s.pts[0];
+	glm::vec3 AB = B.p - A.p;
+	glm::vec3 AC = C.p - A.p;
+	glm::vec3 AO = -A.p;
+	glm::vec3 ABC = glm::cross(AB, AC);
 
-	while(true)
+	if(glm::dot(glm::cross(ABC, AC), AO) > 0.0f)
 	{
-		if(iterations >= max_iterations)
+		if(glm::dot(AC, AO) > 0.0f)
 		{
+			// Past edge AC
+			s.pts[0] = C;
+			s.pts[1] = A;
+			s.count = 2;
+			d = cross_toward(AC, AO);
 			return false;
 		}
-		iterations++;
-		da = awtl * glm::vec4(d, 0.0f);
-		db = bwtl * glm::vec4(-d, 0.0f);
-		
-		glm::vec3 next = (altw * glm::vec4(a.farthest(da), 1.0f)) - (bltw * glm::vec4(b.farthest(db), 1.0f));
+		s.pts[0] = B;
+		s.pts[1] = A;
+		s.count = 2;
+		return do_line(s, d);
+	}
+	if(glm::dot(glm::cross(AB, ABC), AO) > 0.0f)
+	{
+		s.pts[0] = B;
+		s.pts[1] = A;
+		s.count = 2;
+		return do_line(s, d);
+	}
+
+	// Over or under the triangle, keep the winding so the next point is always on the ABC side
+	float side = glm::dot(ABC, AO);
+	if(side > 0.0f)
+	{
+		d = ABC;
+	}
+	else if(side < 0.0f)
+	{
+		s.pts[0] = B;
+		s.pts[1] = C;
+		d = -ABC;
+	}
+	else
+	{
+		// Origin is in the triangle
+		return true;
+	}
+	return false;
+}
+
+static bool do_tetrahedron(Simplex& s, glm::vec3& d)
+{
+	SupportPoint const A = s.pts[3];
+	SupportPoint const B = s.pts[2];
+	SupportPoint const C = s.pts[1];
+	SupportPoint const D = s.pts[0];
+	glm::vec3 AO = -A.p;
 
-		if(glm::dot(next, d) < 0)
+	// The three faces touching A, each with the point that's left out
+	SupportPoint const faces[3][3] = {{C, B, A}, {D, C, A}, {B, D, A}};
+	SupportPoint const opposite[3] = {D, B, C};
+	for(size_t f = 0; f < 3; f++)
+	{
+		glm::vec3 n = glm::cross(faces[f][1].p - A.p, faces[f][0].p - A.p);
+		if(glm::dot(n, opposite[f].p - A.p) > 0.0f)
 		{
-			return false;
+			n = -n;
 		}
-
-		simplex[simpType] = next;
-		
-		if(simpType == 1)
+		if(glm::dot(n, AO) > 0.0f)
 		{
-			// Line case, we assume origin not on line
-			simpType = 2;
-
-			glm::vec3 B = simplex[0];
-			glm::vec3 A = simplex[1];
+			// Origin is outside this face, drop the other point and carry on from the triangle
+			s.pts[0] = faces[f][0];
+			s.pts[1] = faces[f][1];
+			s.pts[2] = faces[f][2];
+			s.count = 3;
+			return do_triangle(s, d);
+		}
+	}
+	return true;
+}
 
-			glm::vec3 AB = B - A;
-			glm::vec3 AO = glm::vec3(0.0f) - A;
+// I used https://www.youtube.com/watch?v=ajv46BSqcK4 to help visualize this algorithm
+// Leaves the last simplex in simplex, which encloses the origin when this returns true (unless they're only touching)
+// If axis is given and not zero GJK starts looking along it, and when this returns false it's left on a separating axis
+static bool GJK(MinkowskiPair const& m, Simplex& simplex, glm::vec3* axis = nullptr)
+{	
+	glm::vec3 d = (axis && glm::length2(*axis) > 1e-12f) ? *axis : m.bltw[3] - m.altw[3];
+	if(glm::length2(d) < 1e-12f)
+	{
+		d = glm::vec3(1.0f, 0.0f, 0.0f);
+	}
 
-			d = glm::normalize(glm::cross(AB, glm::cross(AO, AB)));
+	simplex.pts[0] = m.support(d);
+	simplex.count = 1;
+	if(glm::dot(simplex.pts[0].p, d) < 0)
+	{
+		// Nothing of A - B reaches the origin along d, so d still separates them
+		if(axis) *axis = d;
+		return false;
+	}
+	d = -simplex.pts[0].p;
 
-			continue;
+	const int max_iterations = 100;
+	for(int iterations = 0; iterations < max_iterations; iterations++)
+	{
+		if(glm::length2(d) < 1e-12f)
+		{
+			// The origin is on the simplex
+			return true;
 		}
-		else if(simpType == 2)
+
+		SupportPoint next = m.support(d);
+		if(glm::dot(next.p, d) < 0)
 		{
-			// Triangle case, we assume origin not on triangle
-			simpType = 3;
+			if(axis) *axis = d;
+			return false;
+		}
 
-			glm::vec3 C = simplex[0];
-			glm::vec3 B = simplex[1];
-			glm::vec3 A = simplex[2];
+		simplex.pts[simplex.count++] = next;
+
+		bool contains = false;
+		if(simplex.count == 2)
+		{
+			contains = do_line(simplex, d);
+		}
+		else if(simplex.count == 3)
+		{
+			contains = do_triangle(simplex, d);
+		}
+		else
+		{
+			contains = do_tetrahedron(simplex, d);
+		}
+		if(contains)
+		{
+			return true;
+		}
+	}
+	return false;
+}
 
-			glm::vec3 AB = B - A;
-			glm::vec3 AC = C - A;
-			glm::vec3 AO = glm::vec3(0.0f) - A;
+// GJK can stop on a point, segment or triangle when the origin lands right on it (shapes just touching,
+// or lined up exactly, which boxes love doing), EPA needs a tetrahedron so push out along whatever is free
+// Returns false if A - B really is that flat
+static bool complete_simplex(MinkowskiPair const& m, Simplex& s)
+{
+	static glm::vec3 const axes[6] = {
+		glm::vec3( 1.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f),
+		glm::vec3( 0.0f, 1.0f, 0.0f), glm::vec3( 0.0f,-1.0f, 0.0f),
+		glm::vec3( 0.0f, 0.0f, 1.0f), glm::vec3( 0.0f, 0.0f,-1.0f)};
+	float const eps = 1e-6f;
 
-			d = glm::normalize(glm::cross(AC, glm::cross(AB, glm::vec3(0.0f))));
-			if(glm::dot(d, AO) < 0)
+	if(s.count == 1)
+	{
+		for(glm::vec3 const& axis : axes)
+		{
+			SupportPoint p = m.support(axis);
+			if(glm::length2(p.p - s.pts[0].p) > eps)
 			{
-				d *= -1.0f;
+				s.pts[s.count++] = p;
+				break;
 			}
-			
-			continue;
 		}
-		else
+		if(s.count == 1) return false;
+	}
+	if(s.count == 2)
+	{
+		glm::vec3 line = s.pts[1].p - s.pts[0].p;
+		for(glm::vec3 const& axis : axes)
+		{
+			glm::vec3 dir = glm::cross(line, axis);
+			if(glm::length2(dir) < eps) continue;
+			SupportPoint p = m.support(dir);
+			if(glm::length2(glm::cross(p.p - s.pts[0].p, line)) > eps * glm::length2(line))
+			{
+				s.pts[s.count++] = p;
+				break;
+			}
+		}
+		if(s.count == 2) return false;
+	}
+	if(s.count == 3)
+	{
+		glm::vec3 n = glm::normalize(glm::cross(s.pts[1].p - s.pts[0].p, s.pts[2].p - s.pts[0].p));
+		SupportPoint p = m.support(n);
+		if(std::abs(glm::dot(p.p - s.pts[0].p, n)) < eps)
 		{
-			// This is the actual tetra case, where we can contain the origin
+			p = m.support(-n);
+		}
+		if(std::abs(glm::dot(p.p - s.pts[0].p, n)) < eps) return false;
+		s.pts[s.count++] = p;
+	}
+	return true;
+}
 
-			glm::vec3 AD = simplex[3] - simplex[0];
-			glm::vec3 AC = simplex[3] - simplex[1];
-			glm::vec3 AB = simplex[3] - simplex[2];
-			glm::vec3 AO = simplex[3] - glm::vec3(0.0f);
+// Expanding polytope: grows GJK's tetrahedron out toward the boundary of A - B until the face closest to
+// the origin stops moving, that face's normal and distance are the penetration normal and depth
+// Normal points from A toward B
+static Contact EPA(MinkowskiPair const& m, Simplex const& simplex)
+{
+	Contact contact;
+	contact.normal = m.bltw[3] - m.altw[3];
+	contact.normal = (glm::length2(contact.normal) > 1e-12f) ? glm::normalize(contact.normal) : glm::vec3(1.0f, 0.0f, 0.0f);
 
-			glm::vec3 triABC = glm::cross(AB, AC);
-			if(glm::dot(triABC, AD) > 0) { triABC = -triABC; }
+	Simplex start = simplex;
+	if(!complete_simplex(m, start))
+	{
+		// No volume to expand, so they're only touching
+		contact.point = start.pts[0].a;
+		contact.otherPoint = start.pts[0].b;
+		return contact;
+	}
 
-			glm::vec3 triABD = glm::cross(AB, AD);
-			if(glm::dot(triABD, AC) > 0) { triABD = -triABD; }
+	struct Face
+	{
+		uint32_t v[3];
+		glm::vec3 n;
+		float dist;
+	};
 
-			glm::vec3 triACD = glm::cross(AC, AD);
-			if(glm::dot(triACD, AB) > 0) { triACD = -triACD; }
+	std::vector<SupportPoint> verts(start.pts, start.pts + 4);
+	std::vector<Face> faces;
+	std::vector<std::pair<uint32_t, uint32_t>> horizon;
 
-			if(glm::dot(triACD, AO) < 0)
-			{
-				simplex[2] = simplex[3];
-				d = glm::normalize(triACD);
-			}
-			else if(glm::dot(triABD, AO) < 0)
+	glm::vec3 center = (verts[0].p + verts[1].p + verts[2].p + verts[3].p) * 0.25f;
+	auto add_face = [&verts, &faces, &center](uint32_t a, uint32_t b, uint32_t c) -> void
+		{
+			glm::vec3 n = glm::cross(verts[b].p - verts[a].p, verts[c].p - verts[a].p);
+			if(glm::dot(n, verts[a].p - center) < 0.0f)
 			{
-				simplex[1] = simplex[2];
-				simplex[2] = simplex[3];
-				d = glm::normalize(triABD);
+				std::swap(b, c);
+				n = -n;
 			}
-			else if(glm::dot(triABC, AO) < 0)
+			float len = glm::length(n);
+			if(len < 1e-12f) return; // Sliver, no use to anyone
+			n /= len;
+			faces.push_back(Face{{a, b, c}, n, glm::dot(n, verts[a].p)});
+		};
+	add_face(0, 1, 2);
+	add_face(0, 3, 1);
+	add_face(0, 2, 3);
+	add_face(1, 3, 2);
+
+	const int max_iterations = 64;
+	size_t closest = 0;
+	for(int iterations = 0; iterations < max_iterations && !faces.empty(); iterations++)
+	{
+		closest = 0;
+		for(size_t f = 1; f < faces.size(); f++)
+		{
+			if(faces[f].dist < faces[closest].dist) closest = f;
+		}
+
+		Face const best = faces[closest];
+		SupportPoint s = m.support(best.n);
+		if(glm::dot(s.p, best.n) - best.dist < 1e-4f)
+		{
+			break;
+		}
+
+		// New point is outside the polytope, so knock out every face it can see and patch the hole
+		// The hole's rim is the edges that only one removed face had
+		uint32_t si = (uint32_t)verts.size();
+		verts.push_back(s);
+		horizon.clear();
+		for(size_t f = 0; f < faces.size();)
+		{
+			if(glm::dot(faces[f].n, s.p - verts[faces[f].v[0]].p) > 0.0f)
 			{
-				simplex[0] = simplex[1];
-				simplex[1] = simplex[2];
-				simplex[2] = simplex[3];
-				d = glm::normalize(triABC);
+				for(size_t e = 0; e < 3; e++)
+				{
+					std::pair<uint32_t, uint32_t> edge(faces[f].v[e], faces[f].v[(e + 1) % 3]);
+					auto twin = std::find(horizon.begin(), horizon.end(), std::make_pair(edge.second, edge.first));
+					if(twin != horizon.end())
+					{
+						horizon.erase(twin);
+					}
+					else
+					{
+						horizon.push_back(edge);
+					}
+				}
+				faces[f] = faces.back();
+				faces.pop_back();
 			}
 			else
 			{
-				return true;
+				f++;
 			}
 		}
+		for(auto const& edge : horizon)
+		{
+			// Same winding as the face the edge came from, so the normal still points out
+			glm::vec3 n = glm::cross(verts[edge.second].p - verts[edge.first].p, s.p - verts[edge.first].p);
+			float len = glm::length(n);
+			if(len < 1e-12f) continue;
+			n /= len;
+			faces.push_back(Face{{edge.first, edge.second, si}, n, glm::dot(n, s.p)});
+		}
+		closest = 0;
+		for(size_t f = 1; f < faces.size(); f++)
+		{
+			if(faces[f].dist < faces[closest].dist) closest = f;
+		}
 	}
-}
 
-CollideMesh::CollideMesh(std::vector<glm::vec3> const& vertices_,  float cr)
-	: vertices(vertices_), containingRadius(cr) {}
-
-CollideMeshes::CollideMeshes(std::string const& filename)
-{
-	std::ifstream file(filename, std::ios::binary);
+	if(faces.empty())
+	{
+		contact.point = start.pts[3].a;
+		contact.otherPoint = start.pts[3].b;
+		return contact;
+	}
 
-	std::vector<glm::vec3> vertices;
-	read_chunk(file, "p...", &vertices);
+	// Where the origin projects onto the closest face, in barycentric coordinates of that face,
+	// gives the matching points on A and B
+	Face const& face = faces[closest];
+	SupportPoint const& a = verts[face.v[0]];
+	SupportPoint const& b = verts[face.v[1]];
+	SupportPoint const& c = verts[face.v[2]];
+	glm::vec3 p = face.n * face.dist;
+	glm::vec3 v0 = b.p - a.p;
+	glm::vec3 v1 = c.p - a.p;
+	glm::vec3 v2 = p - a.p;
+	float d00 = glm::dot(v0, v0);
+	float d01 = glm::dot(v0, v1);
+	float d11 = glm::dot(v1, v1);
+	float d20 = glm::dot(v2, v0);
+	float d21 = glm::dot(v2, v1);
+	float denom = d00 * d11 - d01 * d01;
+	float v = 1.0f / 3.0f;
+	float w = 1.0f / 3.0f;
+	if(std::abs(denom) > 1e-12f)
+	{
+		v = (d11 * d20 - d01 * d21) / denom;
+		w = (d00 * d21 - d01 * d20) / denom;
+	}
+	float u = 1.0f - v - w;
 
-	std::vector<char> names;
-	read_chunk(file, "str0", &names);
+	contact.normal = face.n;
+	contact.depth = std::max(face.dist, 0.0f);
+	contact.point = u * a.a + v * b.a + w * c.a;
+	contact.otherPoint = u * a.b + v * b.b + w * c.b;
+	return contact;
+}
 
-	// TODO: SEE THE BELOW TODO ABOUT MAKING THE SCRIPT WORK
-	// std::vector<float> containingRads;
-	// read_chunk(file, "rad0", &containingRads);
+// Closest point to the origin on the simplex, as weights on its points
+// Drops the points that don't contribute, so the simplex stays as small as it can
+// Returns false if the origin is inside the (tetrahedron) simplex
+static bool closest_on_simplex(Simplex& s, float w[4])
+{
+	auto keep = [&s, w](std::initializer_list<uint8_t> which, std::initializer_list<float> weights) -> void
+		{
+			SupportPoint pts[4];
+			uint8_t n = 0;
+			for(uint8_t i : which) pts[n++] = s.pts[i];
+			n = 0;
+			for(float f : weights) w[n++] = f;
+			for(uint8_t i = 0; i < n; i++) s.pts[i] = pts[i];
+			s.count = n;
+		};
 
-	struct IndexEntry
+	if(s.count == 1)
 	{
-		uint32_t name_begin, name_end;
-		uint32_t vertex_begin, vertex_end;
-		float containingRad;
-	};
-
-	std::vector<IndexEntry> index;
-	read_chunk(file, "idxA", &index);
-
-	if(file.peek() != EOF)
+		w[0] = 1.0f;
+		return true;
+	}
+	if(s.count == 2)
 	{
-		std::cerr << "WARNING: trailing data in collidemesh file '" << filename << "'" << std::endl;
+		glm::vec3 a = s.pts[0].p;
+		glm::vec3 ab = s.pts[1].p - a;
+		float len2 = glm::length2(ab);
+		float t = (len2 > 0.0f) ? glm::dot(-a, ab) / len2 : 0.0f;
+		if(t <= 0.0f) keep({0}, {1.0f});
+		else if(t >= 1.0f) keep({1}, {1.0f});
+		else keep({0, 1}, {1.0f - t, t});
+		return true;
 	}
+	if(s.count == 3)
+	{
+		// Voronoi regions of the triangle, as in Ericson's Real-Time Collision Detection
+		glm::vec3 a = s.pts[0].p;
+		glm::vec3 b = s.pts[1].p;
+		glm::vec3 c = s.pts[2].p;
+		glm::vec3 ab = b - a;
+		glm::vec3 ac = c - a;
+		glm::vec3 ap = -a;
+		float d1 = glm::dot(ab, ap);
+		float d2 = glm::dot(ac, ap);
+		if(d1 <= 0.0f && d2 <= 0.0f) { keep({0}, {1.0f}); return true; }
 
-	//-----------------
+		glm::vec3 bp = -b;
+		float d3 = glm::dot(ab, bp);
+		float d4 = glm::dot(ac, bp);
+		if(d3 >= 0.0f && d4 <= d3) { keep({1}, {1.0f}); return true; }
 
-	for(auto const& e : index)
-	{
-		if(!(e.name_begin <= e.name_end && e.name_end <= names.size()))
+		float vc = d1 * d4 - d3 * d2;
+		if(vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
 		{
-			throw std::runtime_error("Invalid name indices in index of '" + filename + "'");
+			float v = d1 / (d1 - d3);
+			keep({0, 1}, {1.0f - v, v});
+			return true;
 		}
-		if(!(e.vertex_begin <= e.vertex_end && e.vertex_end <= vertices.size()))
+
+		glm::vec3 cp = -c;
+		float d5 = glm::dot(ab, cp);
+		float d6 = glm::dot(ac, cp);
+		if(d6 >= 0.0f && d5 <= d6) { keep({2}, {1.0f}); return true; }
+
+		float vb = d5 * d2 - d1 * d6;
+		if(vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
 		{
-			throw std::runtime_error("Invalid vertex indices in index of '" + filename + "'");
+			float v = d2 / (d2 - d6);
+			keep({0, 2}, {1.0f - v, v});
+			return true;
 		}
-		
-		//copy vertices/normals:
-		std::vector<glm::vec3> wm_vertices(vertices.begin() + e.vertex_begin, vertices.begin() + e.vertex_end);		
-		std::string name(names.begin() + e.name_begin, names.begin() + e.name_end);
-
-		// TODO: I HAVEN'T ACTUALLY MODIFIED THE SCRIPT FOR GENERATING THE SCENE TO ACTUALLY CALCULATE THE CONTAINING RADIUS
-		// SO I AM DOING IT HERE
-		// IN A WAY THAT IS EASY TO CHANGE INTO WORKING WHEN WE HAVE THE SCRIPT WORKING
 
-		// auto ret = meshes.emplace(name, CollideMesh(wm_vertices, wm_normals, wm_triangles, containingRads[e.containingRadsAt]));
-		auto ret = meshes.emplace(name, CollideMesh(wm_vertices, e.containingRad));
-		if (!ret.second) {
-			throw std::runtime_error("CollideMesh with duplicated name '" + name + "' in '" + filename + "'");
+		float va = d3 * d6 - d5 * d4;
+		if(va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+		{
+			float v = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+			keep({1, 2}, {1.0f - v, v});
+			return true;
 		}
 
-		std::cout << "Collide Mesh Name: " << name << " radius: " << e.containingRad << std::endl;
+		float denom = 1.0f / (va + vb + vc);
+		float v = vb * denom;
+		float u = vc * denom;
+		w[0] = 1.0f - v - u;
+		w[1] = v;
+		w[2] = u;
+		return true;
 	}
-}
 
-CollideMesh const& CollideMeshes::lookup(std::string const& name) const
-{
-	auto f = meshes.find(name);
-	if(f == meshes.end())
+	// Tetrahedron: closest point is on whichever face the origin is outside of (if any)
+	static uint8_t const faces[4][4] = {{0, 1, 2, 3}, {0, 3, 1, 2}, {0, 2, 3, 1}, {1, 3, 2, 0}};
+	Simplex const whole = s;
+	// A flat tetrahedron has nothing inside, and the side tests below can't tell which side of a face anything is on,
+	// so then it's just whichever face is closest
+	glm::vec3 e1 = whole.pts[1].p - whole.pts[0].p;
+	glm::vec3 e2 = whole.pts[2].p - whole.pts[0].p;
+	glm::vec3 e3 = whole.pts[3].p - whole.pts[0].p;
+	float scale = std::max(glm::length2(e1), std::max(glm::length2(e2), glm::length2(e3)));
+	float volume = glm::dot(glm::cross(e1, e2), e3);
+	bool flat = volume * volume <= 1e-10f * scale * scale * scale;
+	float bestDist = std::numeric_limits<float>::infinity();
+	Simplex best;
+	float bestW[4] = {};
+	for(auto const& f : faces)
 	{
-		throw std::runtime_error("CollideMesh with name '" + name + "' not found.");
-	}
-	return f->second;
-}
+		glm::vec3 a = whole.pts[f[0]].p;
+		glm::vec3 n = glm::cross(whole.pts[f[1]].p - a, whole.pts[f[2]].p - a);
+		float sideO = glm::dot(n, -a);
+		float sideD = glm::dot(n, whole.pts[f[3]].p - a);
+		if(!flat && sideO * sideD >= 0.0f) continue; // Origin on the same side as the rest of the tetrahedron
 
-glm::vec3 Collider::farthest(glm::vec3& d)
-{
-	float farthestSoFar = 0.0f;
-	glm::vec3 farthestSoFarPoint;
-	
-	for(glm::vec3 v : mesh->vertices)
-	{	
-		float dist = glm::dot(v, d);
-		if(dist > farthestSoFar)
+		Simplex tri;
+		tri.pts[0] = whole.pts[f[0]];
+		tri.pts[1] = whole.pts[f[1]];
+		tri.pts[2] = whole.pts[f[2]];
+		tri.count = 3;
+		float triW[4] = {};
+		closest_on_simplex(tri, triW);
+		glm::vec3 p = glm::vec3(0.0f);
+		for(uint8_t i = 0; i < tri.count; i++) p += triW[i] * tri.pts[i].p;
+		float dist = glm::length2(p);
+		if(dist < bestDist)
 		{
-			farthestSoFar = dist;
-			farthestSoFarPoint = v;
+			bestDist = dist;
+			best = tri;
+			std::copy(triW, triW + 4, bestW);
 		}
 	}
-
-	return farthestSoFarPoint;
+	if(bestDist == std::numeric_limits<float>::infinity())
+	{
+		return false;
+	}
+	s = best;
+	std::copy(bestW, bestW + 4, w);
+	return true;
 }
 
-////////////////////////////////////
-// CollisionEngine Implementation //
-////////////////////////////////////
-
-CollisionEngine::CollisionEngine() : nextID(0), colliders(), fromID() {}
-
-CollisionEngine::ID CollisionEngine::registerCollider(Game::CreatureID cid, Scene::Transform* t, CollideMesh const* m, float br, std::function<void(Game::CreatureID, Scene::Transform*)> c, CollisionEngine::Layer l)
+// Separation between A and B, and the closest points on each (normal points from A toward B)
+// Returns 0 if they overlap, then contact is left alone
+static float GJK_distance(MinkowskiPair const& m, Contact* contact)
 {
-	colliders[l].emplace_back(cid, t, m, br, c);
+	Simplex s;
+	glm::vec3 d = m.bltw[3] - m.altw[3];
+	if(glm::length2(d) < 1e-12f) d = glm::vec3(1.0f, 0.0f, 0.0f);
+	s.pts[0] = m.support(d); // Any point of A - B will do to start from
+	s.count = 1;
 
-	fromID.emplace(nextID, std::make_pair(l, colliders[l].size() - 1));
-	
-	return nextID++;
-}
+	float w[4] = {1.0f, 0.0f, 0.0f, 0.0f};
+	glm::vec3 v = s.pts[0].p;
 
-void CollisionEngine::unregisterCollider(CollisionEngine::ID id)
-{
-	auto toRemove = fromID.at(id);
-	// No bounds checking, whatever, if it works it works
+	const int max_iterations = 64;
+	for(int iterations = 0; iterations < max_iterations; iterations++)
+	{
+		if(!closest_on_simplex(s, w))
+		{
+			return 0.0f;
+		}
+		v = glm::vec3(0.0f);
+		for(uint8_t i = 0; i < s.count; i++) v += w[i] * s.pts[i].p;
 
-	std::vector<Collider>& onLayer = colliders[toRemove.first];
+		float vv = glm::length2(v);
+		if(vv < 1e-10f)
+		{
+			return 0.0f;
+		}
 
-	onLayer[toRemove.second].active = false;
-	
-	fromID.erase(id);
+		SupportPoint next = m.support(-v);
+		// Not getting any closer, v is as close as it gets
+		if(vv - glm::dot(v, next.p) <= 1e-6f * vv)
+		{
+			break;
+		}
+		bool duplicate = false;
+		for(uint8_t i = 0; i < s.count; i++)
+		{
+			if(glm::length2(s.pts[i].p - next.p) < 1e-12f) duplicate = true;
+		}
+		if(duplicate)
+		{
+			break;
+		}
+		s.pts[s.count++] = next;
+	}
+
+	float dist = glm::length(v);
+	contact->normal = -v / dist;
+	contact->depth = 0.0f;
+	contact->point = glm::vec3(0.0f);
+	contact->otherPoint = glm::vec3(0.0f);
+	for(uint8_t i = 0; i < s.count; i++)
+	{
+		contact->point += w[i] * s.pts[i].a;
+		contact->otherPoint += w[i] * s.pts[i].b;
+	}
+	return dist;
 }
 
-void CollisionEngine::update(float elapsed)
+// Rigid pose (plus uniform scale, which is all our transforms use) pulled out of a world matrix so it can be interpolated
+struct Pose
 {
-	struct CollisionOccurence
-	{
-		CollisionOccurence(size_t i, size_t j, Layer il, Layer jl) : a(i), b(j), al(il), bl(jl) {};
+	glm::quat rotation;
+	float scale;
+	glm::vec3 position;
 
-		size_t a;
-		size_t b;
+	Pose(glm::mat4x3 const& m)
+		{
+			scale = glm::length(m[0]);
+			float inv = (scale > 0.0f) ? 1.0f / scale : 1.0f;
+			rotation = glm::quat_cast(glm::mat3(m[0] * inv, m[1] * inv, m[2] * inv));
+			position = m[3];
+		}
 
-		Layer al;
-		Layer bl;
-	};
+	// Constant angular and linear speed from a at t = 0 to b at t = 1
+	static void between(Pose const& a, Pose const& b, float t, glm::mat4x3* ltw, glm::mat4x3* wtl)
+		{
+			glm::mat3 r = glm::mat3_cast(glm::slerp(a.rotation, b.rotation, t));
+			float s = glm::mix(a.scale, b.scale, t);
+			glm::vec3 p = glm::mix(a.position, b.position, t);
+			*ltw = glm::mat4x3(r[0] * s, r[1] * s, r[2] * s, p);
+			glm::mat3 rt = glm::transpose(r);
+			float invS = (s > 0.0f) ? 1.0f / s : 1.0f;
+			glm::mat3 inv = glm::mat3(rt[0] * invS, rt[1] * invS, rt[2] * invS);
+			*wtl = glm::mat4x3(inv[0], inv[1], inv[2], -(inv * p));
+		}
 
-	std::vector<CollisionOccurence> collisionOccurences;
+	// Farthest any point within radius of the origin travels going from a to b
+	static float motion_bound(Pose const& a, Pose const& b, float radius)
+		{
+			float cosHalf = std::min(std::abs(glm::dot(a.rotation, b.rotation)), 1.0f);
+			float angle = 2.0f * std::acos(cosHalf);
+			return glm::length(b.position - a.position) + angle * radius * std::max(a.scale, b.scale);
+		}
+};
 
-	// We split up checking for collisions and sending them out so that it's
-	// more amenable to parallelization in the future. Note that this also does
-	// a little bit to prevent segfaults (ie, if we delete the transform when handling a collision,
-	// then that's ok because it's not like we need to derefence it after that)
+// Conservative advancement: step time forward by the current gap over the fastest the gap can close,
+// which can never step past the first touch, until the gap is basically gone (hit) or we run out of step (miss)
+// Pairs already touching at the previous pose are left to the discrete test, they're separating, not tunnelling
+// If the iterations run out first that's a grazing pass at speed, so it counts as a hit at the last safe time
+static bool time_of_impact(Collider const& a, glm::mat4x3 const& a0, glm::mat4x3 const& a1, uint32_t* hintA,
+						   Collider const& b, glm::mat4x3 const& b0, glm::mat4x3 const& b1, uint32_t* hintB,
+						   float* toi, Contact* contact)
+{
+	Pose const pa0(a0), pa1(a1), pb0(b0), pb1(b1);
+	float bound = Pose::motion_bound(pa0, pa1, a.broadRadius) + Pose::motion_bound(pb0, pb1, b.broadRadius);
+	if(bound <= 0.0f)
+	{
+		return false;
+	}
 
-	for(size_t i = 0; i < colliders.size(); i++)
+	float const tolerance = 0.001f;
+	const int max_iterations = 32;
+	float t = 0.0f;
+	Contact last; // From the step before, in case we land exactly on the touch
+	for(int iterations = 0; iterations < max_iterations; iterations++)
 	{
-		for(size_t j = i; j < colliders.size(); j++)
+		glm::mat4x3 altw, awtl, bltw, bwtl;
+		Pose::between(pa0, pa1, t, &altw, &awtl);
+		Pose::between(pb0, pb1, t, &bltw, &bwtl);
+		MinkowskiPair m{a, altw, awtl, hintA, b, bltw, bwtl, hintB};
+
+		Contact at;
+		float dist = GJK_distance(m, &at);
+		if(dist < tolerance)
 		{
-			if(LayerMatrix[i][j])
+			if(iterations == 0)
 			{
-				for(size_t a = 0; a < colliders[i].size(); a++)
-				{
-					if(colliders[i][a].active)
-					{
-						for(size_t b = 0; b < colliders[j].size(); b++)
-						{
-							if(colliders[j][b].active)
-							{
-								if(i == j && a == b)
-								{
-									continue;
-								}
-
-								if(GJK(colliders[i][a], colliders[j][b]))
-								{
-									collisionOccurences.emplace_back(a, b, (Layer)i, (Layer)j);
-								}
-							}
-						}
-					}
-				}
+				return false;
+			}
+			*toi = t;
+			if(dist > 0.0f)
+			{
+				*contact = at;
+			}
+			else
+			{
+				// Overlapping, which advancing shouldn't get us into but rounding can, so EPA has the contact,
+				// unless it's an exact touch that GJK doesn't count
+				Simplex simplex;
+				*contact = GJK(m, simplex) ? EPA(m, simplex) : last;
 			}
+			return true;
+		}
+		last = at;
+
+		t += dist / bound;
+		if(t >= 1.0f)
+		{
+			return false;
 		}
 	}
+	// Still closing in, the next step would have touched or gone right past, which is what we're here to catch
+	*toi = t;
+	*contact = last;
+	return true;
+}
 
-	for(auto& c : collisionOccurences)
+// Primitive colliders: closed form tests for when both sides are a sphere, capsule or box
+// Spheres are capsules whose ends are the same point, so everything comes down to segment vs segment,
+// segment vs box, and box vs box
+
+// A primitive placed in the world
+struct WorldPrimitive
+{
+	CollidePrimitive::Kind kind;
+	// SPHERE and CAPSULE: the segment (a == b for a sphere) and radius
+	glm::vec3 a;
+	glm::vec3 b;
+	float radius;
+	// BOX: center is a, unit axes and half extents along each
+	glm::vec3 axes[3];
+	glm::vec3 half;
+};
+
+enum class PrimitiveResult
+{
+	APART,
+	TOUCHING,
+	NO_ANSWER // Something degenerate, let GJK deal with it
+};
+
+// Returns false if m would bend the primitive into something else (skew, or squashing a sphere or capsule)
+static bool place_primitive(CollidePrimitive const& p, glm::mat4x3 const& m, WorldPrimitive* out)
+{
+	glm::vec3 scale = glm::vec3(glm::length(m[0]), glm::length(m[1]), glm::length(m[2]));
+	if(!(scale.x > 0.0f && scale.y > 0.0f && scale.z > 0.0f))
 	{
-		colliders[c.al][c.a].callback(colliders[c.bl][c.b].cId, colliders[c.bl][c.b].transform);
-		colliders[c.bl][c.b].callback(colliders[c.al][c.a].cId, colliders[c.al][c.a].transform);
+		return false;
+	}
+	for(int i = 0; i < 3; i++)
+	{
+		out->axes[i] = m[i] / scale[i];
+	}
+	float const tolerance = 0.001f;
+	if(std::abs(glm::dot(out->axes[0], out->axes[1])) > tolerance ||
+	   std::abs(glm::dot(out->axes[1], out->axes[2])) > tolerance ||
+	   std::abs(glm::dot(out->axes[2], out->axes[0])) > tolerance)
+	{
+		return false;
+	}
+
+	out->kind = p.kind;
+	out->a = m * glm::vec4(p.a, 1.0f);
+	if(p.kind == CollidePrimitive::BOX)
+	{
+		out->b = out->a;
+		out->radius = 0.0f;
+		out->half = p.b * scale;
+		return true;
+	}
+
+	if(std::abs(scale.y - scale.x) > tolerance * scale.x || std::abs(scale.z - scale.x) > tolerance * scale.x)
+	{
+		return false;
+	}
+	out->b = (p.kind == CollidePrimitive::CAPSULE) ? glm::vec3(m * glm::vec4(p.b, 1.0f)) : out->a;
+	out->radius = p.radius * scale.x;
+	out->half = glm::vec3(0.0f);
+	return true;
+}
+
+// Closest points between segments p0-p1 and q0-q1 (Ericson, Real-Time Collision Detection 5.1.9)
+static void closest_on_segments(glm::vec3 const& p0, glm::vec3 const& p1, glm::vec3 const& q0, glm::vec3 const& q1,
+								glm::vec3* onP, glm::vec3* onQ)
+{
+	glm::vec3 d1 = p1 - p0;
+	glm::vec3 d2 = q1 - q0;
+	glm::vec3 r = p0 - q0;
+	float a = glm::dot(d1, d1);
+	float e = glm::dot(d2, d2);
+	float f = glm::dot(d2, r);
+	float const epsilon = 1e-12f;
+
+	float s, t;
+	if(a <= epsilon && e <= epsilon)
+	{
+		s = t = 0.0f;
+	}
+	else if(a <= epsilon)
+	{
+		s = 0.0f;
+		t = glm::clamp(f / e, 0.0f, 1.0f);
+	}
+	else
+	{
+		float c = glm::dot(d1, r);
+		if(e <= epsilon)
+		{
+			t = 0.0f;
+			s = glm::clamp(-c / a, 0.0f, 1.0f);
+		}
+		else
+		{
+			float b = glm::dot(d1, d2);
+			float denom = a * e - b * b;
+			// Parallel segments get any s, 0 is as good as any
+			s = (denom > epsilon) ? glm::clamp((b * f - c * e) / denom, 0.0f, 1.0f) : 0.0f;
+			t = (b * s + f) / e;
+			if(t < 0.0f)
+			{
+				t = 0.0f;
+				s = glm::clamp(-c / a, 0.0f, 1.0f);
+			}
+			else if(t > 1.0f)
+			{
+				t = 1.0f;
+				s = glm::clamp((b - c) / a, 0.0f, 1.0f);
+			}
+		}
+	}
+	*onP = p0 + d1 * s;
+	*onQ = q0 + d2 * t;
+}
+
+// Sphere or capsule against sphere or capsule: two round things touch if their cores come within both radii
+static PrimitiveResult round_round(WorldPrimitive const& a, WorldPrimitive const& b, Contact* contact)
+{
+	glm::vec3 onA, onB;
+	closest_on_segments(a.a, a.b, b.a, b.b, &onA, &onB);
+	glm::vec3 between = onB - onA;
+	float reach = a.radius + b.radius;
+	float dist2 = glm::length2(between);
+	if(dist2 > reach * reach)
+	{
+		return PrimitiveResult::APART;
+	}
+	float dist = std::sqrt(dist2);
+	if(dist < 1e-6f)
+	{
+		// Cores cross, no good normal to be had from here
+		return PrimitiveResult::NO_ANSWER;
+	}
+
+	contact->normal = between / dist;
+	contact->depth = reach - dist;
+	contact->point = onA + contact->normal * a.radius;
+	contact->otherPoint = onB - contact->normal * b.radius;
+	return PrimitiveResult::TOUCHING;
+}
+
+static glm::vec3 box_support(WorldPrimitive const& box, glm::vec3 const& d)
+{
+	glm::vec3 p = box.a;
+	for(int i = 0; i < 3; i++)
+	{
+		p += box.axes[i] * ((glm::dot(box.axes[i], d) >= 0.0f) ? box.half[i] : -box.half[i]);
+	}
+	return p;
+}
+
+static glm::vec3 round_support(WorldPrimitive const& round, glm::vec3 const& d)
+{
+	return ((glm::dot(round.b - round.a, d) > 0.0f) ? round.b : round.a) + d * round.radius;
+}
+
+// Separating axis test, projecting both onto each candidate and keeping the axis they overlap least on
+// Box vs box needs the 3 face axes of each and the 9 edge crosses, a segment vs a box just the box's faces
+// and the segment crossed with the box's edges (so this is only right for the segment itself, radius gets added after)
+// Returns false if some axis separates them, otherwise the least overlap and the axis, pointing from a to b
+static bool least_overlap(WorldPrimitive const& a, WorldPrimitive const& b, glm::vec3* normal, float* overlap)
+{
+	glm::vec3 candidates[15];
+	int count = 0;
+	int faces = (a.kind == CollidePrimitive::BOX) ? 6 : 3;
+	for(int i = 0; i < 3; i++)
+	{
+		candidates[count++] = b.axes[i];
+	}
+	if(a.kind == CollidePrimitive::BOX)
+	{
+		for(int i = 0; i < 3; i++)
+		{
+			candidates[count++] = a.axes[i];
+		}
+		for(int i = 0; i < 3; i++)
+		{
+			for(int j = 0; j < 3; j++)
+			{
+				candidates[count++] = glm::cross(a.axes[i], b.axes[j]);
+			}
+		}
+	}
+	else
+	{
+		for(int j = 0; j < 3; j++)
+		{
+			candidates[count++] = glm::cross(a.b - a.a, b.axes[j]);
+		}
+	}
+
+	glm::vec3 centerA = (a.kind == CollidePrimitive::BOX) ? a.a : 0.5f * (a.a + a.b);
+	glm::vec3 toB = b.a - centerA;
+	*overlap = std::numeric_limits<float>::max();
+	for(int c = 0; c < count; c++)
+	{
+		float length = glm::length(candidates[c]);
+		if(length < 1e-6f)
+		{
+			continue; // Parallel edges, one of the face axes covers it
+		}
+		glm::vec3 axis = candidates[c] / length;
+
+		float reachA = 0.0f;
+		float reachB = 0.0f;
+		for(int i = 0; i < 3; i++)
+		{
+			reachB += std::abs(glm::dot(b.axes[i], axis)) * b.half[i];
+		}
+		if(a.kind == CollidePrimitive::BOX)
+		{
+			for(int i = 0; i < 3; i++)
+			{
+				reachA += std::abs(glm::dot(a.axes[i], axis)) * a.half[i];
+			}
+		}
+		else
+		{
+			reachA = 0.5f * std::abs(glm::dot(a.b - a.a, axis));
+		}
+
+		float dist = glm::dot(toB, axis);
+		float o = reachA + reachB - std::abs(dist);
+		if(o < 0.0f)
+		{
+			return false;
+		}
+		// Edge axes have to win by a bit, otherwise boxes resting face to face flicker between normals
+		if(o < *overlap - ((c < faces) ? 0.0f : 1e-4f))
+		{
+			*overlap = o;
+			*normal = (dist < 0.0f) ? -axis : axis;
+		}
+	}
+	return true;
+}
+
+static PrimitiveResult box_box(WorldPrimitive const& a, WorldPrimitive const& b, Contact* contact)
+{
+	glm::vec3 normal;
+	float overlap;
+	if(!least_overlap(a, b, &normal, &overlap))
+	{
+		return PrimitiveResult::APART;
+	}
+	contact->normal = normal;
+	contact->depth = overlap;
+	contact->point = box_support(a, normal);
+	contact->otherPoint = box_support(b, -normal);
+	return PrimitiveResult::TOUCHING;
+}
+
+// Squared distance from p to the box
+static float box_distance2(WorldPrimitive const& box, glm::vec3 const& p, glm::vec3* closest)
+{
+	glm::vec3 q = box.a;
+	glm::vec3 rel = p - box.a;
+	for(int i = 0; i < 3; i++)
+	{
+		q += box.axes[i] * glm::clamp(glm::dot(rel, box.axes[i]), -box.half[i], box.half[i]);
+	}
+	*closest = q;
+	return glm::length2(p - q);
+}
+
+static PrimitiveResult round_box(WorldPrimitive const& a, WorldPrimitive const& b, Contact* contact)
+{
+	glm::vec3 normal;
+	float overlap;
+	if(least_overlap(a, b, &normal, &overlap))
+	{
+		// The core is in the box, the way out is whichever way the core is least in, plus the radius
+		contact->normal = normal;
+		contact->depth = overlap + a.radius;
+		contact->point = round_support(a, normal);
+		contact->otherPoint = box_support(b, -normal);
+		return PrimitiveResult::TOUCHING;
+	}
+
+	// Core is outside the box. Distance to a box is convex along the segment, so a golden section search
+	// lands on the closest point without any of the case by case clipping an exact answer needs
+	glm::vec3 closest;
+	auto at = [&a](float t) -> glm::vec3 { return glm::mix(a.a, a.b, t); };
+	float lo = 0.0f;
+	float hi = 1.0f;
+	float const ratio = 0.618034f;
+	float t1 = hi - ratio * (hi - lo);
+	float t2 = lo + ratio * (hi - lo);
+	float d1 = box_distance2(b, at(t1), &closest);
+	float d2 = box_distance2(b, at(t2), &closest);
+	for(int iterations = 0; iterations < 32 && hi - lo > 1e-5f; iterations++)
+	{
+		if(d1 < d2)
+		{
+			hi = t2;
+			t2 = t1;
+			d2 = d1;
+			t1 = hi - ratio * (hi - lo);
+			d1 = box_distance2(b, at(t1), &closest);
+		}
+		else
+		{
+			lo = t1;
+			t1 = t2;
+			d1 = d2;
+			t2 = lo + ratio * (hi - lo);
+			d2 = box_distance2(b, at(t2), &closest);
+		}
+	}
+	glm::vec3 onA = at(0.5f * (lo + hi));
+	float dist2 = box_distance2(b, onA, &closest);
+	if(dist2 > a.radius * a.radius)
+	{
+		return PrimitiveResult::APART;
+	}
+	float dist = std::sqrt(dist2);
+	if(dist < 1e-6f)
+	{
+		return PrimitiveResult::NO_ANSWER;
+	}
+
+	contact->normal = (closest - onA) / dist;
+	contact->depth = a.radius - dist;
+	contact->point = onA + contact->normal * a.radius;
+	contact->otherPoint = closest;
+	return PrimitiveResult::TOUCHING;
+}
+
+// Contact between two primitive colliders at their current poses, same conventions as EPA
+static PrimitiveResult primitive_contact(CollidePrimitive const& pa, glm::mat4x3 const& ma,
+										 CollidePrimitive const& pb, glm::mat4x3 const& mb, Contact* contact)
+{
+	WorldPrimitive a, b;
+	if(!place_primitive(pa, ma, &a) || !place_primitive(pb, mb, &b))
+	{
+		return PrimitiveResult::NO_ANSWER;
+	}
+
+	bool aBox = (a.kind == CollidePrimitive::BOX);
+	bool bBox = (b.kind == CollidePrimitive::BOX);
+	if(aBox && bBox)
+	{
+		return box_box(a, b, contact);
+	}
+	if(!aBox && !bBox)
+	{
+		return round_round(a, b, contact);
+	}
+	if(!aBox)
+	{
+		return round_box(a, b, contact);
+	}
+
+	// Box first, so do it the other way around and flip the contact
+	PrimitiveResult result = round_box(b, a, contact);
+	if(result == PrimitiveResult::TOUCHING)
+	{
+		contact->normal = -contact->normal;
+		std::swap(contact->point, contact->otherPoint);
+	}
+	return result;
+}
+
+CollideMesh::CollideMesh(std::vector<glm::vec3> const& vertices_,  float cr, std::vector<uint32_t> const& adjacencyStart_, std::vector<uint32_t> const& adjacency_, CollidePrimitive const& primitive_)
+	: vertices(vertices_), adjacencyStart(adjacencyStart_), adjacency(adjacency_), primitive(primitive_), containingRadius(cr)
+{
+	size_t padded = (vertices.size() + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH;
+	xs.reserve(padded);
+	ys.reserve(padded);
+	zs.reserve(padded);
+	for(size_t i = 0; i < padded; i++)
+	{
+		glm::vec3 const& v = vertices[(i < vertices.size()) ? i : 0];
+		xs.push_back(v.x);
+		ys.push_back(v.y);
+		zs.push_back(v.z);
+	}
+}
+
+uint32_t CollideMesh::climb(glm::vec3 const& d, uint32_t start) const
+{
+	uint32_t at = (start < vertices.size()) ? start : 0;
+	float best = glm::dot(vertices[at], d);
+
+	// Steepest ascent, every step strictly increases best so this always stops
+	bool tied = false;
+	while(true)
+	{
+		uint32_t next = at;
+		tied = false;
+		for(uint32_t i = adjacencyStart[at]; i < adjacencyStart[at + 1]; i++)
+		{
+			float dist = glm::dot(vertices[adjacency[i]], d);
+			if(dist > best)
+			{
+				best = dist;
+				next = adjacency[i];
+				tied = false;
+			}
+			else if(dist == best)
+			{
+				tied = true;
+			}
+		}
+		if(next == at)
+		{
+			break;
+		}
+		at = next;
+	}
+	if(!tied)
+	{
+		return at;
+	}
+
+	// We're on a face or edge square to d, the linear kernels take its lowest index vertex so go find that
+	// (the face is connected through its own edges, and it's only ever a handful of vertices)
+	std::vector<uint32_t> face(1, at);
+	uint32_t lowest = at;
+	for(size_t f = 0; f < face.size(); f++)
+	{
+		for(uint32_t i = adjacencyStart[face[f]]; i < adjacencyStart[face[f] + 1]; i++)
+		{
+			uint32_t n = adjacency[i];
+			if(glm::dot(vertices[n], d) == best && std::find(face.begin(), face.end(), n) == face.end())
+			{
+				face.push_back(n);
+				lowest = std::min(lowest, n);
+			}
+		}
+	}
+	return lowest;
+}
+
+CollideMeshes::CollideMeshes(std::string const& filename)
+{
+	std::ifstream file(filename, std::ios::binary);
+
+	std::vector<glm::vec3> vertices;
+	read_chunk(file, "p...", &vertices);
+
+	std::vector<char> names;
+	read_chunk(file, "str0", &names);
+
+	// TODO: SEE THE BELOW TODO ABOUT MAKING THE SCRIPT WORK
+	// std::vector<float> containingRads;
+	// read_chunk(file, "rad0", &containingRads);
+
+	struct IndexEntry
+	{
+		uint32_t name_begin, name_end;
+		uint32_t vertex_begin, vertex_end;
+		float containingRad;
+	};
+
+	std::vector<IndexEntry> index;
+	read_chunk(file, "idxA", &index);
+
+	// For every vertex in file order: neighbor count, then that many neighbors (indexed within the vertex's own mesh)
+	// Older files don't have this, those meshes just never climb
+	std::vector<uint32_t> adjacency;
+	if(file.peek() != EOF)
+	{
+		read_chunk(file, "adj0", &adjacency);
+	}
+
+	// One per index entry, for meshes that were tagged as a sphere, capsule or box in blender
+	// Older files don't have this either, then everything is a hull
+	struct PrimitiveEntry
+	{
+		uint32_t kind;
+		glm::vec3 a;
+		glm::vec3 b;
+		float radius;
+	};
+	static_assert(sizeof(PrimitiveEntry) == 32, "PrimitiveEntry is packed");
+
+	std::vector<PrimitiveEntry> primitives;
+	if(file.peek() != EOF)
+	{
+		read_chunk(file, "prm0", &primitives);
+		if(primitives.size() != index.size())
+		{
+			throw std::runtime_error("Primitive chunk doesn't match index in '" + filename + "'");
+		}
+	}
+
+	// Where each vertex's entry starts in adjacency
+	std::vector<uint32_t> adjacencyAt;
+	if(!adjacency.empty())
+	{
+		adjacencyAt.reserve(vertices.size());
+		size_t at = 0;
+		for(size_t v = 0; v < vertices.size(); v++)
+		{
+			if(at >= adjacency.size() || adjacency.size() - at - 1 < adjacency[at])
+			{
+				throw std::runtime_error("Adjacency chunk too short for vertices in '" + filename + "'");
+			}
+			adjacencyAt.push_back((uint32_t)at);
+			at += 1 + adjacency[at];
+		}
+	}
+
+	if(file.peek() != EOF)
+	{
+		std::cerr << "WARNING: trailing data in collidemesh file '" << filename << "'" << std::endl;
+	}
+
+	//-----------------
+
+	for(size_t m = 0; m < index.size(); m++)
+	{
+		IndexEntry const& e = index[m];
+		if(!(e.name_begin <= e.name_end && e.name_end <= names.size()))
+		{
+			throw std::runtime_error("Invalid name indices in index of '" + filename + "'");
+		}
+		if(!(e.vertex_begin <= e.vertex_end && e.vertex_end <= vertices.size()))
+		{
+			throw std::runtime_error("Invalid vertex indices in index of '" + filename + "'");
+		}
+		
+		//copy vertices/normals:
+		std::vector<glm::vec3> wm_vertices(vertices.begin() + e.vertex_begin, vertices.begin() + e.vertex_end);		
+		std::string name(names.begin() + e.name_begin, names.begin() + e.name_end);
+
+		std::vector<uint32_t> wm_adjacencyStart;
+		std::vector<uint32_t> wm_adjacency;
+		if(!adjacency.empty())
+		{
+			wm_adjacencyStart.reserve(wm_vertices.size() + 1);
+			for(uint32_t v = e.vertex_begin; v < e.vertex_end; v++)
+			{
+				wm_adjacencyStart.push_back((uint32_t)wm_adjacency.size());
+				uint32_t count = adjacency[adjacencyAt[v]];
+				for(uint32_t i = 0; i < count; i++)
+				{
+					uint32_t n = adjacency[adjacencyAt[v] + 1 + i];
+					if(n >= wm_vertices.size())
+					{
+						throw std::runtime_error("Invalid neighbor index in adjacency of '" + filename + "'");
+					}
+					wm_adjacency.push_back(n);
+				}
+			}
+			wm_adjacencyStart.push_back((uint32_t)wm_adjacency.size());
+		}
+
+		CollidePrimitive primitive;
+		if(!primitives.empty())
+		{
+			if(primitives[m].kind > CollidePrimitive::BOX)
+			{
+				throw std::runtime_error("Invalid primitive kind in '" + filename + "'");
+			}
+			primitive.kind = (CollidePrimitive::Kind)primitives[m].kind;
+			primitive.a = primitives[m].a;
+			primitive.b = primitives[m].b;
+			primitive.radius = primitives[m].radius;
+		}
+
+		// TODO: I HAVEN'T ACTUALLY MODIFIED THE SCRIPT FOR GENERATING THE SCENE TO ACTUALLY CALCULATE THE CONTAINING RADIUS
+		// SO I AM DOING IT HERE
+		// IN A WAY THAT IS EASY TO CHANGE INTO WORKING WHEN WE HAVE THE SCRIPT WORKING
+
+		// auto ret = meshes.emplace(name, CollideMesh(wm_vertices, wm_normals, wm_triangles, containingRads[e.containingRadsAt]));
+		auto ret = meshes.emplace(name, CollideMesh(wm_vertices, e.containingRad, wm_adjacencyStart, wm_adjacency, primitive));
+		if (!ret.second) {
+			throw std::runtime_error("CollideMesh with duplicated name '" + name + "' in '" + filename + "'");
+		}
+
+		std::cout << "Collide Mesh Name: " << name << " radius: " << e.containingRad << std::endl;
+	}
+}
+
+CollideMesh const& CollideMeshes::lookup(std::string const& name) const
+{
+	auto f = meshes.find(name);
+	if(f == meshes.end())
+	{
+		throw std::runtime_error("CollideMesh with name '" + name + "' not found.");
+	}
+	return f->second;
+}
+
+// Support kernels: index of the first vertex with the largest dot(v, d)
+// Every kernel gives exactly the same answer as the scalar one, the dot products are done in the same order and ties
+// go to the lowest index, they just look at more vertices at once
+typedef uint32_t (*SupportKernel)(CollideMesh const& m, glm::vec3 const& d);
+
+// Only picked where there is no SIMD kernel, but it is the reference the others have to agree with
+[[maybe_unused]] static uint32_t support_scalar(CollideMesh const& m, glm::vec3 const& d)
+{
+	float best = -std::numeric_limits<float>::infinity();
+	uint32_t bestIdx = 0;
+	for(uint32_t i = 0; i < (uint32_t)m.vertices.size(); i++)
+	{
+		float dist = m.xs[i] * d.x + m.ys[i] * d.y + m.zs[i] * d.z;
+		if(dist > best)
+		{
+			best = dist;
+			bestIdx = i;
+		}
+	}
+	return bestIdx;
+}
+
+#ifdef COLLISIONS_X86_64
+
+// Each lane keeps its own first strict max, so across lanes we want the biggest value and then the lowest index
+// (a lane that never beat -inf still holds its starting index, which only wins if every lane is stuck the same way)
+static uint32_t reduce_lanes(float const* best, int32_t const* bestIdx, size_t lanes)
+{
+	float b = best[0];
+	uint32_t bi = (uint32_t)bestIdx[0];
+	for(size_t l = 1; l < lanes; l++)
+	{
+		if(best[l] > b || (best[l] == b && (uint32_t)bestIdx[l] < bi))
+		{
+			b = best[l];
+			bi = (uint32_t)bestIdx[l];
+		}
+	}
+	return bi;
+}
+
+// SSE2 is always there on x86-64, so this one needs no checking
+static uint32_t support_sse2(CollideMesh const& m, glm::vec3 const& d)
+{
+	__m128 dx = _mm_set1_ps(d.x);
+	__m128 dy = _mm_set1_ps(d.y);
+	__m128 dz = _mm_set1_ps(d.z);
+	__m128 best = _mm_set1_ps(-std::numeric_limits<float>::infinity());
+	__m128i idx = _mm_setr_epi32(0, 1, 2, 3);
+	__m128i bestIdx = idx;
+	__m128i const step = _mm_set1_epi32(4);
+
+	for(size_t i = 0; i < m.xs.size(); i += 4)
+	{
+		__m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&m.xs[i]), dx),
+											_mm_mul_ps(_mm_loadu_ps(&m.ys[i]), dy)),
+								 _mm_mul_ps(_mm_loadu_ps(&m.zs[i]), dz));
+		__m128 gt = _mm_cmpgt_ps(dist, best);
+		__m128i gti = _mm_castps_si128(gt);
+		best = _mm_or_ps(_mm_and_ps(gt, dist), _mm_andnot_ps(gt, best));
+		bestIdx = _mm_or_si128(_mm_and_si128(gti, idx), _mm_andnot_si128(gti, bestIdx));
+		idx = _mm_add_epi32(idx, step);
+	}
+
+	float bestOut[4];
+	int32_t bestIdxOut[4];
+	_mm_storeu_ps(bestOut, best);
+	_mm_storeu_si128((__m128i*)bestIdxOut, bestIdx);
+	return reduce_lanes(bestOut, bestIdxOut, 4);
+}
+
+#ifdef _MSC_VER
+#define COLLISIONS_AVX2
+#else
+#define COLLISIONS_AVX2 __attribute__((target("avx2")))
+#endif
+
+// Only ever called if the cpu says it has AVX2, see pick_support_kernel
+COLLISIONS_AVX2 static uint32_t support_avx2(CollideMesh const& m, glm::vec3 const& d)
+{
+	__m256 dx = _mm256_set1_ps(d.x);
+	__m256 dy = _mm256_set1_ps(d.y);
+	__m256 dz = _mm256_set1_ps(d.z);
+	__m256 best = _mm256_set1_ps(-std::numeric_limits<float>::infinity());
+	__m256i idx = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	__m256i bestIdx = idx;
+	__m256i const step = _mm256_set1_epi32(8);
+
+	for(size_t i = 0; i < m.xs.size(); i += 8)
+	{
+		__m256 dist = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(&m.xs[i]), dx),
+												  _mm256_mul_ps(_mm256_loadu_ps(&m.ys[i]), dy)),
+									_mm256_mul_ps(_mm256_loadu_ps(&m.zs[i]), dz));
+		__m256 gt = _mm256_cmp_ps(dist, best, _CMP_GT_OQ);
+		best = _mm256_blendv_ps(best, dist, gt);
+		bestIdx = _mm256_blendv_epi8(bestIdx, idx, _mm256_castps_si256(gt));
+		idx = _mm256_add_epi32(idx, step);
+	}
+
+	float bestOut[8];
+	int32_t bestIdxOut[8];
+	_mm256_storeu_ps(bestOut, best);
+	_mm256_storeu_si256((__m256i*)bestIdxOut, bestIdx);
+	return reduce_lanes(bestOut, bestIdxOut, 8);
+}
+
+static bool cpu_has_avx2()
+{
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 1);
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+	if(!osxsave || !avx) return false;
+	if((_xgetbv(0) & 0x6) != 0x6) return false; // OS has to be saving the ymm registers too
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif
+
+static SupportKernel pick_support_kernel()
+{
+#ifdef COLLISIONS_X86_64
+	if(cpu_has_avx2())
+	{
+		return support_avx2;
+	}
+	return support_sse2;
+#else
+	return support_scalar;
+#endif
+}
+
+glm::vec3 Collider::farthest(glm::vec3 const& d, uint32_t* hint) const
+{
+	// Picked once, the first time anything collides
+	static SupportKernel const kernel = pick_support_kernel();
+
+	if(mesh->vertices.empty())
+	{
+		return glm::vec3(0.0f);
+	}
+
+	uint32_t i;
+	if(hint && mesh->can_climb())
+	{
+		i = mesh->climb(d, *hint);
+		*hint = i;
+	}
+	else
+	{
+		i = kernel(*mesh, d);
+	}
+	return mesh->vertices[i];
+}
+
+////////////////////////////////////
+// CollisionEngine Implementation //
+////////////////////////////////////
+
+CollisionEngine::CollisionEngine(WorkerPool& pool_) : nextID(0), pool(pool_), colliders(), fromID() {}
+
+CollisionEngine::ID CollisionEngine::registerCollider(Game::CreatureID cid, Scene::Transform* t, CollideMesh const* m, float br, CollisionCallback c, CollisionEngine::Layer l, bool continuous)
+{
+	ID id = nextID++;
+	Collider collider(cid, t, m, br, continuous);
+	collider.id = id;
+
+	if(sendingEvents)
+	{
+		pendingRegistrations.push_back(PendingRegistration{id, l, collider, c});
+	}
+	else
+	{
+		add_collider(id, l, collider, c);
+	}
+	
+	return id;
+}
+
+void CollisionEngine::unregisterCollider(CollisionEngine::ID id)
+{
+	if(!sendingEvents)
+	{
+		remove_collider(id);
+		return;
+	}
+
+	// Registered during this same round of events, so it never even made it in
+	for(auto it = pendingRegistrations.begin(); it != pendingRegistrations.end(); it++)
+	{
+		if(it->id == id)
+		{
+			pendingRegistrations.erase(it);
+			return;
+		}
+	}
+
+	auto found = fromID.find(id);
+	if(found == fromID.end())
+	{
+		return;
+	}
+	// Stops it getting any more events, update takes it out for real once it's done
+	colliders[found->second.first][found->second.second].active = false;
+	pendingUnregistrations.push_back(id);
+}
+
+void CollisionEngine::add_collider(CollisionEngine::ID id, CollisionEngine::Layer l, Collider const& c, CollisionCallback const& callback)
+{
+	colliders[l].push_back(c);
+	callbacks[l].push_back(callback);
+	fromID.emplace(id, std::make_pair(l, colliders[l].size() - 1));
+}
+
+void CollisionEngine::remove_collider(CollisionEngine::ID id)
+{
+	auto found = fromID.find(id);
+	if(found == fromID.end())
+	{
+		return; // Already gone
+	}
+	Layer l = found->second.first;
+	size_t i = found->second.second;
+	fromID.erase(found);
+
+	// Last one on the layer moves into the hole, and its id has to follow it
+	size_t last = colliders[l].size() - 1;
+	if(i != last)
+	{
+		colliders[l][i] = colliders[l][last];
+		callbacks[l][i] = std::move(callbacks[l][last]);
+		fromID[colliders[l][i].id].second = i;
+	}
+	colliders[l].pop_back();
+	callbacks[l].pop_back();
+}
+
+// Ids are handed out in order and never reused, so (unless somebody registers four billion colliders) the
+// low halves are enough to tell pairs apart. Either order gives the same key
+static uint64_t pair_key(CollisionEngine::ID a, CollisionEngine::ID b)
+{
+	if(b < a)
+	{
+		std::swap(a, b);
+	}
+	return (a << 32) | (b & 0xffffffffu);
+}
+
+// Pairs per narrow phase job, a GJK test is cheap enough that handing them out one at a time would be all overhead
+static size_t const NARROW_PHASE_GRAIN = 8;
+
+bool CollisionEngine::narrow_phase(CollisionOccurence& c) const
+{
+	BroadPhaseXform const& ax = broadPhaseXforms[c.axf];
+	BroadPhaseXform const& bx = broadPhaseXforms[c.bxf];
+	Collider const& a = colliders[c.al][c.a];
+	Collider const& b = colliders[c.bl][c.b];
+	PairState& pair = *c.pair;
+
+	// Two primitives have a closed form answer, everything else (or anything the closed form can't handle) gets GJK
+	PrimitiveResult result = PrimitiveResult::NO_ANSWER;
+	if(a.mesh->primitive.kind != CollidePrimitive::HULL && b.mesh->primitive.kind != CollidePrimitive::HULL)
+	{
+		result = primitive_contact(a.mesh->primitive, ax.localToWorld, b.mesh->primitive, bx.localToWorld, &c.contact);
+	}
+
+	bool hit = (result == PrimitiveResult::TOUCHING);
+	if(result == PrimitiveResult::NO_ANSWER)
+	{
+		MinkowskiPair m{a, ax.localToWorld, ax.worldToLocal, &pair.hintA,
+						b, bx.localToWorld, bx.worldToLocal, &pair.hintB};
+		Simplex simplex;
+		hit = GJK(m, simplex, &pair.axis);
+		if(hit)
+		{
+			c.contact = EPA(m, simplex);
+		}
+	}
+
+	if(!hit && (ax.swept || bx.swept) && !pair.touching)
+	{
+		// Not touching now, but if either is swept they might have passed through each other on the way
+		// (if they were touching last update they've just come apart, sweeping would only find that contact again)
+		hit = time_of_impact(a, ax.previousLocalToWorld, ax.localToWorld, &pair.hintA,
+							 b, bx.previousLocalToWorld, bx.localToWorld, &pair.hintB,
+							 &c.toi, &c.contact);
+	}
+
+	if(hit)
+	{
+		// Start next time from the contact normal, which points about the same way as the separating axis will
+		pair.axis = c.contact.normal;
+		pair.lastTouched = updateCount;
+	}
+	return hit;
+}
+
+void CollisionEngine::update(float elapsed)
+{
+	updateCount++;
+
+	std::vector<CollisionOccurence> collisionOccurences;
+
+	// We split up checking for collisions and sending them out so that the checking
+	// can run on the worker pool, callbacks only ever run on this thread. Note that this also does
+	// a little bit to prevent segfaults (ie, if we delete the transform when handling a collision,
+	// then that's ok because it's not like we need to derefence it after that)
+
+	// Broad phase: gather world space bounding spheres for every active collider
+	broadPhase.clear();
+	broadPhaseXforms.clear();
+	broadPhaseOwners.clear();
+	
+	glm::vec3 centerSum = glm::vec3(0.0f);
+	glm::vec3 centerSum2 = glm::vec3(0.0f);
+
+	for(size_t l = 0; l < colliders.size(); l++)
+	{
+		for(size_t i = 0; i < colliders[l].size(); i++)
+		{
+			// Everything in here is live, unregistering doesn't leave anything behind
+			Collider& c = colliders[l][i];
+
+			glm::mat4x3 localToWorld = c.transform->get_local_to_world();
+			bool swept = c.continuous && c.hasPrevious;
+			broadPhaseXforms.push_back(BroadPhaseXform{localToWorld, c.transform->get_world_to_local(),
+													   swept ? c.previousLocalToWorld : localToWorld, swept});
+			broadPhaseOwners.push_back(BroadPhaseOwner{c.id, c.cId, c.transform, c.mesh});
+			c.previousLocalToWorld = localToWorld;
+			c.hasPrevious = true;
+
+			// A swept collider's sphere has to cover it all the way from the previous pose, rotating
+			// about its origin stays inside the sphere so only the origin's movement matters
+			glm::vec3 center = localToWorld[3];
+			float radius = c.broadRadius;
+			if(swept)
+			{
+				glm::vec3 previous = broadPhaseXforms.back().previousLocalToWorld[3];
+				radius += 0.5f * glm::length(center - previous);
+				center = 0.5f * (center + previous);
+			}
+
+			centerSum += center;
+			centerSum2 += center * center;
+
+			broadPhase.push_back(BroadPhaseEntry{0.0f, 0.0f, center, radius, (Layer)l, i, broadPhaseXforms.size() - 1});
+		}
+	}
+
+	// Sweep along whichever horizontal axis the colliders are most spread out on
+	size_t axis = 0;
+	if(!broadPhase.empty())
+	{
+		glm::vec3 mean = centerSum / (float)broadPhase.size();
+		glm::vec3 variance = centerSum2 / (float)broadPhase.size() - mean * mean;
+		axis = (variance.y > variance.x) ? 1 : 0;
+	}
+
+	sweepAxis = axis;
+	widestEntry = 0.0f;
+	for(auto& e : broadPhase)
+	{
+		e.min = e.center[axis] - e.radius;
+		e.max = e.center[axis] + e.radius;
+		widestEntry = std::max(widestEntry, e.max - e.min);
+	}
+
+	std::sort(broadPhase.begin(), broadPhase.end(),
+			  [](BroadPhaseEntry const& x, BroadPhaseEntry const& y) -> bool { return x.min < y.min; });
+
+	// Sweep and prune: each entry only needs to look forward until the intervals stop overlapping
+	for(size_t i = 0; i < broadPhase.size(); i++)
+	{
+		for(size_t j = i + 1; j < broadPhase.size() && broadPhase[j].min <= broadPhase[i].max; j++)
+		{
+			// Lower layer first, then lower id. Not index, that changes whenever something else gets unregistered,
+			// and a pair flipping around would lose its cached state (and look like it stopped and started touching)
+			BroadPhaseEntry const* ea = &broadPhase[i];
+			BroadPhaseEntry const* eb = &broadPhase[j];
+			ID ida = broadPhaseOwners[ea->xform].id;
+			ID idb = broadPhaseOwners[eb->xform].id;
+			if(eb->layer < ea->layer || (eb->layer == ea->layer && idb < ida))
+			{
+				std::swap(ea, eb);
+				std::swap(ida, idb);
+			}
+
+			if(!LayerMatrix[ea->layer][eb->layer])
+			{
+				continue;
+			}
+
+			float reach = ea->radius + eb->radius;
+			if(glm::length2(eb->center - ea->center) > reach * reach)
+			{
+				continue;
+			}
+
+			collisionOccurences.emplace_back(ea->index, eb->index, ea->layer, eb->layer);
+			collisionOccurences.back().aid = ida;
+			collisionOccurences.back().bid = idb;
+			collisionOccurences.back().axf = ea->xform;
+			collisionOccurences.back().bxf = eb->xform;
+		}
+	}
+
+	// Keep the narrow phase (and therefore callback) order independent of where things are in the sweep,
+	// or in storage for that matter
+	std::sort(collisionOccurences.begin(), collisionOccurences.end(),
+			  [](CollisionOccurence const& x, CollisionOccurence const& y) -> bool
+			  {
+				  return std::tie(x.al, x.bl, x.aid, x.bid) < std::tie(y.al, y.bl, y.aid, y.bid);
+			  });
+
+	// Narrow phase: only candidates that survived the broad phase get the full GJK test,
+	// and only the ones that actually overlap go on to EPA for their contact
+	// Hints get looked up first, since the map can't be grown from the workers
+	for(auto& c : collisionOccurences)
+	{
+		c.pair = &pairs[pair_key(c.aid, c.bid)];
+		c.pair->lastUsed = updateCount;
+		c.pair->al = c.al;
+		c.pair->a = c.aid;
+		c.pair->bl = c.bl;
+		c.pair->b = c.bid;
+	}
+
+	size_t chunks = (collisionOccurences.size() + NARROW_PHASE_GRAIN - 1) / NARROW_PHASE_GRAIN;
+	if(narrowPhaseHits.size() < chunks)
+	{
+		narrowPhaseHits.resize(chunks);
+	}
+	for(size_t i = 0; i < chunks; i++)
+	{
+		narrowPhaseHits[i].clear();
+	}
+
+	pool.parallel_for(collisionOccurences.size(), NARROW_PHASE_GRAIN, [this, &collisionOccurences](size_t begin, size_t end)
+		{
+			std::vector<CollisionOccurence>& hits = narrowPhaseHits[begin / NARROW_PHASE_GRAIN];
+			for(size_t i = begin; i < end; i++)
+			{
+				CollisionOccurence& c = collisionOccurences[i];
+				if(narrow_phase(c))
+				{
+					hits.push_back(c);
+				}
+			}
+		});
+
+	// Chunks cover the sorted pairs in order, so stitching them back together gives the same event order
+	// no matter how many threads there are or who ran what
+	collisionOccurences.clear();
+	for(size_t i = 0; i < chunks; i++)
+	{
+		collisionOccurences.insert(collisionOccurences.end(), narrowPhaseHits[i].begin(), narrowPhaseHits[i].end());
+	}
+
+	// Callbacks can register and unregister from here on, see pendingRegistrations
+	sendingEvents = true;
+
+	auto send = [this](CollisionEvent::Phase phase, Layer al, size_t ai, Layer bl, size_t bi, Contact const& contact, float toi) -> void
+		{
+			Collider const& a = colliders[al][ai];
+			Collider const& b = colliders[bl][bi];
+			// Somebody unregistered one of them in an earlier callback
+			if(!a.active || !b.active)
+			{
+				return;
+			}
+
+			CollisionEvent toA;
+			toA.other = b.cId;
+			toA.otherTransform = b.transform;
+			toA.otherLayer = bl;
+			toA.phase = phase;
+			toA.contact = contact;
+			toA.toi = toi;
+
+			CollisionEvent toB;
+			toB.other = a.cId;
+			toB.otherTransform = a.transform;
+			toB.otherLayer = al;
+			toB.phase = phase;
+			toB.contact.normal = -contact.normal;
+			toB.contact.depth = contact.depth;
+			toB.contact.point = contact.otherPoint;
+			toB.contact.otherPoint = contact.point;
+			toB.toi = toi;
+
+			// a's callback could unregister b (or a), so check again before b hears about it
+			callbacks[al][ai](toA);
+			if(colliders[al][ai].active && colliders[bl][bi].active)
+			{
+				callbacks[bl][bi](toB);
+			}
+		};
+
+	// Pairs that were touching and aren't anymore, whether they failed the narrow phase or didn't even make
+	// the broad phase. Pairs where a collider is gone get dropped quietly, its transform may well be too
+	// Forget pairs that weren't tested this time while we're at it, they'd only be stale starting points anyway
+	std::vector<PairState> ended;
+	for(auto it = pairs.begin(); it != pairs.end();)
+	{
+		PairState& p = it->second;
+		if(p.touching && p.lastTouched != updateCount)
+		{
+			p.touching = false;
+			if(fromID.count(p.a) && fromID.count(p.b))
+			{
+				ended.push_back(p);
+			}
+		}
+		if(p.lastUsed != updateCount)
+		{
+			it = pairs.erase(it);
+		}
+		else
+		{
+			it++;
+		}
+	}
+	// Same order as everything else, not whatever order the map had them in
+	std::sort(ended.begin(), ended.end(),
+			  [](PairState const& x, PairState const& y) -> bool
+			  {
+				  return std::tie(x.al, x.bl, x.a, x.b) < std::tie(y.al, y.bl, y.a, y.b);
+			  });
+
+	// Ends go out before begins, so something moving from one collider straight into another reads in order
+	for(PairState const& p : ended)
+	{
+		// Looked up as we go, since nothing moves until the events are all out
+		send(CollisionEvent::END, p.al, fromID[p.a].second, p.bl, fromID[p.b].second, p.contact, p.toi);
+	}
+
+	for(auto& c : collisionOccurences)
+	{
+		CollisionEvent::Phase phase = c.pair->touching ? CollisionEvent::STAY : CollisionEvent::BEGIN;
+		c.pair->touching = true;
+		c.pair->contact = c.contact;
+		c.pair->toi = c.toi;
+		send(phase, c.al, c.a, c.bl, c.b, c.contact, c.toi);
+	}
+
+	// Now that nobody's holding indices, catch up on whatever the callbacks asked for
+	sendingEvents = false;
+	for(ID id : pendingUnregistrations)
+	{
+		remove_collider(id);
+	}
+	pendingUnregistrations.clear();
+	for(PendingRegistration const& r : pendingRegistrations)
+	{
+		add_collider(r.id, r.layer, r.collider, r.callback);
+	}
+	pendingRegistrations.clear();
+}
+
+/////////////
+// Queries //
+/////////////
+
+std::pair<size_t, size_t> CollisionEngine::broad_phase_range(float min, float max) const
+{
+	// Sorted by min, and nothing is wider than widestEntry, so anything starting before min - widestEntry ends before min
+	auto first = std::lower_bound(broadPhase.begin(), broadPhase.end(), min - widestEntry,
+								  [](BroadPhaseEntry const& e, float v) -> bool { return e.min < v; });
+	auto last = std::upper_bound(first, broadPhase.end(), max,
+								 [](float v, BroadPhaseEntry const& e) -> bool { return v < e.min; });
+	return std::make_pair((size_t)(first - broadPhase.begin()), (size_t)(last - broadPhase.begin()));
+}
+
+// Just a point at the origin, queries measure against one of these put wherever they're asking about
+static CollideMesh const& point_mesh()
+{
+	static CollideMesh const mesh(std::vector<glm::vec3>(1, glm::vec3(0.0f)), 0.0f);
+	return mesh;
+}
+
+// A ball of radius moving from origin along dir (unit) against a collider, conservative advancement again but
+// with a point instead of a second collider, so each step can go all the way to the plane GJK separated them with
+// Returns whether it touches within maxDistance, and if so how far along and where
+static bool sweep_against(Collider const& c, glm::mat4x3 const& ltw, glm::mat4x3 const& wtl,
+						  glm::vec3 const& origin, float radius, glm::vec3 const& dir, float maxDistance,
+						  float* distance, Contact* contact)
+{
+	Collider const probe(Game::CreatureID(), nullptr, &point_mesh(), 0.0f, false);
+
+	float const tolerance = 0.001f;
+	const int max_iterations = 32;
+	float t = 0.0f;
+	Contact last;
+	last.normal = -dir;
+	last.point = origin;
+	for(int iterations = 0; iterations < max_iterations; iterations++)
+	{
+		glm::vec3 at = origin + dir * t;
+		glm::mat4x3 pltw(1.0f);
+		pltw[3] = at;
+		glm::mat4x3 pwtl(1.0f);
+		pwtl[3] = -at;
+		// No hints, queries can't write anything
+		MinkowskiPair m{c, ltw, wtl, nullptr, probe, pltw, pwtl, nullptr};
+
+		Contact gap;
+		float dist = GJK_distance(m, &gap);
+		if(dist - radius < tolerance)
+		{
+			*distance = t;
+			// Normal points from the collider toward the probe, which is the way we want it
+			// Overlapping means we started inside (or stepped onto it exactly), then the last separated step is the best guess
+			*contact = (dist > 0.0f) ? gap : last;
+			return true;
+		}
+		last = gap;
+
+		// Everything of the collider is on the far side of the plane through its closest point, so we can go
+		// straight to where the ball meets that plane. Moving away from the plane means we never hit at all
+		float closing = -glm::dot(dir, gap.normal);
+		if(closing <= 0.0f)
+		{
+			return false;
+		}
+		t += (dist - radius) / closing;
+		if(t > maxDistance)
+		{
+			return false;
+		}
+	}
+	return false;
+}
+
+bool CollisionEngine::raycast(glm::vec3 const& origin, glm::vec3 const& direction, float maxDistance, LayerMask layers, QueryHit* hit) const
+{
+	return sweepSphere(origin, 0.0f, direction, maxDistance, layers, hit);
+}
+
+bool CollisionEngine::sweepSphere(glm::vec3 const& origin, float radius, glm::vec3 const& direction, float maxDistance, LayerMask layers, QueryHit* hit) const
+{
+	float length = glm::length(direction);
+	if(!(length > 0.0f) || maxDistance < 0.0f)
+	{
+		return false;
+	}
+	glm::vec3 dir = direction / length;
+	glm::vec3 end = origin + dir * maxDistance;
+
+	auto range = broad_phase_range(std::min(origin[sweepAxis], end[sweepAxis]) - radius,
+								   std::max(origin[sweepAxis], end[sweepAxis]) + radius);
+
+	bool found = false;
+	float best = maxDistance;
+	for(size_t i = range.first; i < range.second; i++)
+	{
+		BroadPhaseEntry const& e = broadPhase[i];
+		if(!(layers & layer_mask(e.layer)) || e.max < std::min(origin[sweepAxis], end[sweepAxis]) - radius)
+		{
+			continue;
+		}
+
+		// Bounding sphere against the part of the path that's still worth checking
+		float along = glm::clamp(glm::dot(e.center - origin, dir), 0.0f, best);
+		float reach = e.radius + radius;
+		if(glm::length2(origin + dir * along - e.center) > reach * reach)
+		{
+			continue;
+		}
+
+		BroadPhaseXform const& x = broadPhaseXforms[e.xform];
+		BroadPhaseOwner const& o = broadPhaseOwners[e.xform];
+		Collider const c(o.cId, o.transform, o.mesh, e.radius, false);
+		float distance;
+		Contact contact;
+		if(sweep_against(c, x.localToWorld, x.worldToLocal, origin, radius, dir, best, &distance, &contact))
+		{
+			found = true;
+			best = distance;
+			hit->id = o.id;
+			hit->cId = o.cId;
+			hit->transform = o.transform;
+			hit->layer = e.layer;
+			hit->distance = distance;
+			hit->point = contact.point;
+			hit->normal = contact.normal;
+		}
+	}
+	return found;
+}
+
+size_t CollisionEngine::overlapSphere(glm::vec3 const& center, float radius, LayerMask layers, std::vector<QueryHit>* hits) const
+{
+	Collider const probe(Game::CreatureID(), nullptr, &point_mesh(), 0.0f, false);
+	glm::mat4x3 pltw(1.0f);
+	pltw[3] = center;
+	glm::mat4x3 pwtl(1.0f);
+	pwtl[3] = -center;
+
+	size_t added = 0;
+	auto range = broad_phase_range(center[sweepAxis] - radius, center[sweepAxis] + radius);
+	for(size_t i = range.first; i < range.second; i++)
+	{
+		BroadPhaseEntry const& e = broadPhase[i];
+		float reach = e.radius + radius;
+		if(!(layers & layer_mask(e.layer)) || e.max < center[sweepAxis] - radius ||
+		   glm::length2(e.center - center) > reach * reach)
+		{
+			continue;
+		}
+
+		BroadPhaseXform const& x = broadPhaseXforms[e.xform];
+		BroadPhaseOwner const& o = broadPhaseOwners[e.xform];
+		Collider const c(o.cId, o.transform, o.mesh, e.radius, false);
+		MinkowskiPair m{c, x.localToWorld, x.worldToLocal, nullptr, probe, pltw, pwtl, nullptr};
+		Contact gap;
+		float dist = GJK_distance(m, &gap);
+		if(dist > radius)
+		{
+			continue;
+		}
+
+		QueryHit hit;
+		hit.id = o.id;
+		hit.cId = o.cId;
+		hit.transform = o.transform;
+		hit.layer = e.layer;
+		hit.distance = 0.0f;
+		// Center's inside it, so there's no closest point to speak of
+		hit.point = (dist > 0.0f) ? gap.point : center;
+		hit.normal = (dist > 0.0f) ? gap.normal : glm::vec3(0.0f);
+		hits->push_back(hit);
+		added++;
 	}
+	return added;
 }
@@ -8,18 +8,65 @@
 #include "Scene.hpp"
 #include "Game.hpp"
 #include "Slots.hpp"
+#include "WorkerPool.hpp"
 
 #include <array>
 #include <vector>
 
+// Closed form stand in for a collide mesh, for things that really are just a ball, a pill or a box
+// Two of these get tested against each other directly, anything against a plain hull still goes through GJK
+// (the mesh keeps its vertices either way, those are also what CCD sweeps)
+struct CollidePrimitive
+{
+	enum Kind : uint32_t
+	{
+		HULL = 0, // Not a primitive, just the vertices
+		SPHERE,
+		CAPSULE,
+		BOX
+	};
+
+	Kind kind = HULL;
+	// Mesh space. SPHERE: center a. CAPSULE: segment from a to b. BOX: center a, half extents b along the mesh's axes
+	glm::vec3 a = glm::vec3(0.0f);
+	glm::vec3 b = glm::vec3(0.0f);
+	float radius = 0.0f; // SPHERE and CAPSULE
+};
+
 struct CollideMesh
 {
 	// Same as walk mesh will keep track of triangles, vertices:
 	std::vector<glm::vec3> vertices;
 
+	// The vertices again as separate x/y/z arrays, for the support kernels in Collider::farthest
+	// Padded up to a multiple of SIMD_WIDTH with copies of the first vertex, so the kernels never need a tail loop
+	// (a copy can never beat the original since ties go to the lowest index)
+	static constexpr size_t SIMD_WIDTH = 8;
+	std::vector<float> xs;
+	std::vector<float> ys;
+	std::vector<float> zs;
+
+	// Edge graph of the hull, neighbors of vertex i are adjacency[adjacencyStart[i]] up to adjacency[adjacencyStart[i + 1]]
+	// Empty if the file had no adjacency chunk, then support queries always use the linear kernels
+	std::vector<uint32_t> adjacencyStart;
+	std::vector<uint32_t> adjacency;
+
+	// Below this many vertices a linear kernel is about as fast as climbing, so we don't bother
+	static constexpr size_t CLIMB_MIN_VERTICES = 32;
+
+	CollidePrimitive primitive;
+
 	float containingRadius;
 
-	CollideMesh(std::vector<glm::vec3> const& vertices_, float cr);
+	CollideMesh(std::vector<glm::vec3> const& vertices_, float cr, std::vector<uint32_t> const& adjacencyStart_ = {}, std::vector<uint32_t> const& adjacency_ = {},
+				CollidePrimitive const& primitive_ = CollidePrimitive());
+
+	bool can_climb() const { return !adjacency.empty() && vertices.size() >= CLIMB_MIN_VERTICES; }
+
+	// Walks uphill along d over the edge graph from start, returns the vertex where it can't go any higher
+	// On a convex hull a local max is the global max, so this finds the same vertex as a full scan
+	// (on a face square to d it looks over the face for the lowest index, like the kernels do)
+	uint32_t climb(glm::vec3 const& d, uint32_t start) const;
 };
 
 struct CollideMeshes
@@ -40,7 +87,7 @@ struct CollideMeshes
 
 // 	// Finds the farthest point in the direction d
 // 	// (This obviously is only guaranteed to be useful if we're convex)
-// 	// In a convex mesh, this is always guaranteed to be a vertex of a mesh
+// 	// In a convex mesh, this is always guaranteed to be a vertex of a mesh, the lowest index one if several tie
 // 	glm::vec3 farthest(glm::vec3& d);
 
 // 	Scene::Transform* transform;
@@ -50,23 +97,44 @@ struct CollideMeshes
 // 	std::function<void(Scene::Transform*)> callback;
 // }
 
+// Defined below CollisionEngine, since it says what layer the other collider was on
+struct CollisionEvent;
+typedef std::function<void(CollisionEvent const&)> CollisionCallback;
+
 // MUST BE CONVEX
+// The callback lives in CollisionEngine::callbacks, not in here, so the broad phase isn't walking over std::functions
 struct Collider
 {
-	Collider(Game::CreatureID cid, Scene::Transform* t, CollideMesh const* m, float br, std::function<void(Game::CreatureID, Scene::Transform*)> c) : cId(cid), transform(t), mesh(m), broadRadius(br), active(true), callback(c) {};
+	Collider(Game::CreatureID cid, Scene::Transform* t, CollideMesh const* m, float br, bool cont) : cId(cid), transform(t), mesh(m), broadRadius(br), active(true), continuous(cont) {};
 	
 	// Finds the farthest point in the direction d
 	// (This obviously is only guaranteed to be useful if we're convex)
-	// In a convex mesh, this is always guaranteed to be a vertex of a mesh
-	glm::vec3 farthest(glm::vec3& d);
+	// In a convex mesh, this is always guaranteed to be a vertex of a mesh, the lowest index one if several tie
+	// If hint is given (and the mesh has adjacency) this climbs from *hint and leaves the vertex it found there
+	glm::vec3 farthest(glm::vec3 const& d, uint32_t* hint = nullptr) const;
 
 	Game::CreatureID cId;
 	Scene::Transform* transform;
 	CollideMesh const* mesh;
 	float broadRadius;
-	bool active = false;;
+	bool active = false; // Only ever false while unregistered but waiting for update to finish sending events
+	uint64_t id = 0; // CollisionEngine::ID it was registered under
+
+	// Continuous colliders are also tested along the motion from last update's pose to this one,
+	// so something fast (a sword mid swing) can't skip over a thin target between two updates
+	bool continuous = false;
+	bool hasPrevious = false; // No previous pose yet, so nothing to sweep from
+	glm::mat4x3 previousLocalToWorld = glm::mat4x3(1.0f);
+};
 
-	std::function<void(Game::CreatureID, Scene::Transform*)> callback;
+// How far two colliders overlap, from EPA run on GJK's final simplex
+// Everything is world space, and seen from the collider the event is being sent to
+struct Contact
+{
+	glm::vec3 normal = glm::vec3(0.0f); // Unit, from this collider toward the other one. Moving the other one depth along it separates them
+	float depth = 0.0f;
+	glm::vec3 point = glm::vec3(0.0f); // Deepest point of this collider inside the other one
+	glm::vec3 otherPoint = glm::vec3(0.0f); // Deepest point of the other collider inside this one
 };
 
 struct CollisionEngine
@@ -93,7 +161,9 @@ public:
 		{true, true, false, false}
 	};
 	
-	CollisionEngine();
+	// The narrow phase gets split over pool (the caller always works too), a pool of 0 threads keeps it all on the caller
+	// There's meant to be one pool per process, so it's the owner's, and has to outlive the engine
+	CollisionEngine(WorkerPool& pool);
 	
 	// Register a collider so the engine can check for its collisions
 	// Requires a radius (for broad phase testing / acceleration structures)
@@ -101,22 +171,196 @@ public:
 	// A actual collider we can do full testing against
 	// And some meta information in the form of layers that describes what this collider should be tested against
 
+	// Continuous opts in to swept testing (see Collider::continuous), only worth it for fast or thin things
+
 	// Also note that this does not forward the arguments, so it can be slower than optimal, but I'll fix
 	// it if it's a problem
-	ID registerCollider(Game::CreatureID cid, Scene::Transform* t, CollideMesh const* m, float br, std::function<void(Game::CreatureID, Scene::Transform*)> c, Layer l);
+	ID registerCollider(Game::CreatureID cid, Scene::Transform* t, CollideMesh const* m, float br, CollisionCallback c, Layer l, bool continuous = false);
 
 	// Deregister a collider so the engine can forget about it
+	// Its slot gets filled by the last collider on the layer, so storage only ever holds live colliders
+	// Registering and unregistering are both fine from inside a collision callback, they just don't take effect
+	// until update is done sending events (an unregistered collider gets no more events in the meantime)
 	void unregisterCollider(ID id);
 	
 	// Checks for collisions and sends out collision events
 	// Makes a list and then sends out events
+	// Reads the cached world matrices of the collider transforms, so the owning scene's
+	// update_world_transforms() should be called right before this
 	void update(float elapsed);
+
+	// Queries: questions about the world as of the last update, answered from the same broad phase the
+	// collisions used. Nothing is written, so any number of threads can query at once, just not while update runs
+	// Colliders registered since then aren't in it, and unregistered ones still are (don't follow their transform)
+	typedef uint32_t LayerMask;
+	static constexpr LayerMask ALL_LAYERS = (1u << LAYER_COUNT) - 1;
+	static constexpr LayerMask layer_mask(Layer l) { return 1u << l; }
+
+	struct QueryHit
+	{
+		ID id = 0;
+		Game::CreatureID cId;
+		Scene::Transform* transform = nullptr;
+		Layer layer = LAYER_COUNT;
+		float distance = 0.0f; // Along the ray or sweep, 0 if it started out touching (and for overlaps)
+		glm::vec3 point = glm::vec3(0.0f); // World space, on the surface of what got hit
+		glm::vec3 normal = glm::vec3(0.0f); // Unit, out of what got hit back toward the query (zero if an overlap's center is inside it)
+	};
+
+	// Closest collider on layers that the ray from origin along direction hits within maxDistance
+	// Direction doesn't have to be unit, distances are in world units either way
+	bool raycast(glm::vec3 const& origin, glm::vec3 const& direction, float maxDistance, LayerMask layers, QueryHit* hit) const;
+	// Same, but a ball of radius instead of a point
+	bool sweepSphere(glm::vec3 const& origin, float radius, glm::vec3 const& direction, float maxDistance, LayerMask layers, QueryHit* hit) const;
+	// Adds every collider on layers within radius of center to hits, returns how many it added
+	size_t overlapSphere(glm::vec3 const& center, float radius, LayerMask layers, std::vector<QueryHit>* hits) const;
 	
 private:
 	ID nextID;
 
+	// Broad phase entry, one per active collider, rebuilt every update. We sweep these along
+	// one axis (sweep and prune) so only colliders whose world space bounding spheres overlap
+	// ever get handed to GJK
+	struct BroadPhaseEntry
+	{
+		float min; // Interval of the bounding sphere along the sweep axis
+		float max;
+		glm::vec3 center; // World space bounding sphere
+		float radius;
+		Layer layer;
+		size_t index; // Into colliders[layer]
+		size_t xform; // Into broadPhaseXforms
+	};
+
+	// World matrices for each entry, kept out of BroadPhaseEntry so that the sweep stays compact
+	struct BroadPhaseXform
+	{
+		glm::mat4x3 localToWorld;
+		glm::mat4x3 worldToLocal;
+		glm::mat4x3 previousLocalToWorld; // Same as localToWorld unless swept
+		bool swept;
+	};
+
+	// Who each entry belongs to, for queries, which can't go through colliders since that moves around
+	// whenever something is unregistered
+	struct BroadPhaseOwner
+	{
+		ID id;
+		Game::CreatureID cId;
+		Scene::Transform* transform;
+		CollideMesh const* mesh;
+	};
+
+	// Kept around between updates so we aren't reallocating these every frame
+	// They're also the snapshot that queries run against
+	std::vector<BroadPhaseEntry> broadPhase;
+	std::vector<BroadPhaseXform> broadPhaseXforms;
+	std::vector<BroadPhaseOwner> broadPhaseOwners; // Parallel to broadPhaseXforms
+	size_t sweepAxis = 0; // What broadPhase is sorted along
+	float widestEntry = 0.0f; // Largest max - min in broadPhase, so queries know how far back to start looking
+
+	// Range of broadPhase whose intervals could overlap [min, max] along sweepAxis
+	std::pair<size_t, size_t> broad_phase_range(float min, float max) const;
+
+	// What we remember about a pair from one update to the next, keyed by both collider ids
+	// Pairs barely move between frames, so last time's answer is usually this time's answer or close to it
+	struct PairState
+	{
+		// Support vertices each side ended on, so GJK can climb from there
+		uint32_t hintA = 0;
+		uint32_t hintB = 0;
+		// Where GJK starts looking, in A - B space. While they're apart this is the last separating axis,
+		// and if that still separates GJK is done after one support call
+		glm::vec3 axis = glm::vec3(0.0f);
+
+		bool touching = false; // As of the last update that tested this pair
+		Contact contact; // Last contact (seen from a), sent again with END
+		float toi = 1.0f;
+
+		// Who the pair is, for sending END. Ids and not indices, since indices move when colliders get removed
+		Layer al = LAYER_COUNT;
+		ID a = 0;
+		Layer bl = LAYER_COUNT;
+		ID b = 0;
+
+		uint64_t lastUsed = 0; // Dropped once the pair stops making it through the broad phase
+		uint64_t lastTouched = 0;
+	};
+	std::unordered_map<uint64_t, PairState> pairs;
+	uint64_t updateCount = 0;
+
+	// A pair that made it through the broad phase, and (if it survives the narrow phase) its contact
+	struct CollisionOccurence
+	{
+		CollisionOccurence(size_t i, size_t j, Layer il, Layer jl) : a(i), b(j), al(il), bl(jl) {};
+
+		size_t a;
+		size_t b;
+
+		Layer al;
+		Layer bl;
+
+		ID aid = 0; // What the pair is ordered and keyed by, a and b are only good until something's removed
+		ID bid = 0;
+
+		size_t axf = 0; // Broad phase matrices for a and b
+		size_t bxf = 0;
+
+		PairState* pair = nullptr; // Looked up before the narrow phase, the map can't be touched from workers
+
+		Contact contact; // Seen from a, filled in by the narrow phase
+		float toi = 1.0f;
+	};
+
+	// GJK (and EPA or CCD) for one pair, returns whether they touch
+	// Only reads engine state besides c and c.pair, so any number of these can run at once on different pairs
+	bool narrow_phase(CollisionOccurence& c) const;
+
+	WorkerPool& pool;
+	// Hits from each chunk of pairs, chunks are contiguous and in order so joining these keeps the pair order
+	std::vector<std::vector<CollisionOccurence>> narrowPhaseHits;
+
+	// Only live colliders, packed, and callbacks[l][i] goes with colliders[l][i]
 	std::array<std::vector<Collider>, LAYER_COUNT> colliders;
+	std::array<std::vector<CollisionCallback>, LAYER_COUNT> callbacks;
 	std::unordered_map<ID, std::pair<Layer, size_t>> fromID;
+
+	// While update is sending events, indices into colliders are held all over the place (and a callback
+	// might be running out of callbacks), so registering and unregistering wait in here until it's done
+	struct PendingRegistration
+	{
+		ID id;
+		Layer layer;
+		Collider collider;
+		CollisionCallback callback;
+	};
+	bool sendingEvents = false;
+	std::vector<PendingRegistration> pendingRegistrations;
+	std::vector<ID> pendingUnregistrations;
+
+	void add_collider(ID id, Layer l, Collider const& c, CollisionCallback const& callback);
+	void remove_collider(ID id);
+};
+
+struct CollisionEvent
+{
+	// Contacts come in one BEGIN, a STAY for every update after that they're still touching, then one END
+	// (no END if either collider got unregistered first)
+	enum Phase : uint8_t
+	{
+		BEGIN,
+		STAY,
+		END
+	};
+
+	Game::CreatureID other;
+	Scene::Transform* otherTransform = nullptr;
+	CollisionEngine::Layer otherLayer = CollisionEngine::LAYER_COUNT;
+	Phase phase = BEGIN;
+	Contact contact; // For END, the last contact they had
+	// When during the last update they first touched, 0 is the previous update's poses and 1 is the current ones
+	// Only ever below 1 when one of them is continuous, then contact is from that moment (and depth is about 0)
+	float toi = 1.0f;
 };
 
 #endif
@@ -0,0 +1,224 @@
+#ifndef ECS_HPP
+#define ECS_HPP
+
+#include "Scene.hpp"
+#include "Slots.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Entities are identified by their transform (see ecs.org), components live in one packed array per component type,
+// and systems are just functions run in order over typed queries
+namespace ECS
+{
+	typedef SlotID Entity;
+
+	static size_t const NONE = std::numeric_limits<size_t>::max();
+
+	struct PoolBase
+	{
+		virtual ~PoolBase() {};
+		virtual void remove(Entity e) = 0;
+	};
+
+	// Sparse set: entity idx -> dense index, with the components themselves packed in data
+	// Iterating data is a straight walk over memory, which is the whole point
+	template<typename T>
+	struct Pool : PoolBase
+	{
+		std::vector<size_t> sparse; // By entity idx, NONE if this entity doesn't have one
+		std::vector<Entity> entities; // Dense, parallel to data
+		std::vector<T> data; // Dense
+
+		size_t indexOf(Entity e) const
+			{
+				if(e.idx >= sparse.size()) return NONE;
+				size_t dense = sparse[e.idx];
+				if(dense == NONE || entities[dense] != e) return NONE; // Stale generation
+				return dense;
+			}
+
+		T* get(Entity e)
+			{
+				size_t dense = indexOf(e);
+				return (dense == NONE) ? nullptr : &data[dense];
+			}
+
+		// Replaces the component if the entity already has one
+		T& add(Entity e, T value)
+			{
+				size_t dense = indexOf(e);
+				if(dense != NONE)
+				{
+					data[dense] = std::move(value);
+					return data[dense];
+				}
+				if(e.idx >= sparse.size()) sparse.resize(e.idx + 1, NONE);
+				sparse[e.idx] = data.size();
+				entities.push_back(e);
+				data.push_back(std::move(value));
+				return data.back();
+			}
+
+		void remove(Entity e) override
+			{
+				size_t dense = indexOf(e);
+				if(dense == NONE) return;
+				size_t last = data.size() - 1;
+				if(dense != last)
+				{
+					data[dense] = std::move(data[last]);
+					entities[dense] = entities[last];
+					sparse[entities[dense].idx] = dense;
+				}
+				data.pop_back();
+				entities.pop_back();
+				sparse[e.idx] = NONE;
+			}
+	};
+
+	inline size_t next_component_type()
+	{
+		static size_t next = 0;
+		return next++;
+	}
+
+	// Small dense id per component type, assigned the first time it's asked for
+	template<typename T>
+	size_t component_type()
+	{
+		static size_t const id = next_component_type();
+		return id;
+	}
+
+	struct World
+	{
+		Entity spawn(Scene::Transform* transform)
+			{
+				Entity e = entities.spawn(transform);
+				byTransform[transform] = e;
+				return e;
+			}
+
+		// Drops every component the entity has
+		void destroy(Entity e)
+			{
+				Scene::Transform** t = entities.get(e);
+				if(!t) return;
+				for(auto& p : pools)
+				{
+					if(p) p->remove(e);
+				}
+				byTransform.erase(*t);
+				entities.destroy(e);
+			}
+
+		bool alive(Entity e) const { return entities.valid(e); }
+
+		Scene::Transform* transform(Entity e)
+			{
+				Scene::Transform** t = entities.get(e);
+				return t ? *t : nullptr;
+			}
+
+		// Default (invalid) entity if nobody owns this transform
+		Entity find(Scene::Transform const* transform) const
+			{
+				auto it = byTransform.find(transform);
+				return (it == byTransform.end()) ? Entity() : it->second;
+			}
+
+		template<typename T>
+		Pool<T>& pool()
+			{
+				size_t type = component_type<T>();
+				if(type >= pools.size()) pools.resize(type + 1);
+				if(!pools[type]) pools[type].reset(new Pool<T>());
+				return *static_cast<Pool<T>*>(pools[type].get());
+			}
+
+		template<typename T>
+		T& add(Entity e, T value) { return pool<T>().add(e, std::move(value)); }
+		template<typename T>
+		T* get(Entity e) { return pool<T>().get(e); }
+		template<typename T>
+		bool has(Entity e) { return pool<T>().indexOf(e) != NONE; }
+		template<typename T>
+		void remove(Entity e) { pool<T>().remove(e); }
+
+		// Calls f(entity, First&, Rest&...) for every entity that has all of them, in First's dense order
+		// Put the rarest component first, that's the one that gets walked
+		// Don't add or remove any of these component types from inside f
+		template<typename First, typename... Rest, typename F>
+		void each(F&& f)
+			{
+				Pool<First>& first = pool<First>();
+				for(size_t i = 0; i < first.data.size(); i++)
+				{
+					Entity e = first.entities[i];
+					each_with<Rest...>(e, f, first.data[i]);
+				}
+			}
+
+		Slots<Scene::Transform*> entities;
+		std::unordered_map<Scene::Transform const*, Entity> byTransform;
+		std::vector<std::unique_ptr<PoolBase>> pools; // By component_type
+
+	private:
+		template<typename... Rest, typename F, typename... Got>
+		typename std::enable_if<sizeof...(Rest) == 0>::type each_with(Entity e, F& f, Got&... got)
+			{
+				f(e, got...);
+			}
+		template<typename Next, typename... Rest, typename F, typename... Got>
+		void each_with(Entity e, F& f, Got&... got)
+			{
+				Next* next = pool<Next>().get(e);
+				if(!next) return;
+				each_with<Rest...>(e, f, got..., *next);
+			}
+	};
+
+	// Runs systems in the order they were added, each one is a full pass over whatever it queries
+	struct Scheduler
+	{
+		struct System
+		{
+			std::string name;
+			std::function<void(World&, float)> run;
+			bool enabled = true;
+		};
+
+		void add(std::string name, std::function<void(World&, float)> run)
+			{
+				systems.push_back(System{std::move(name), std::move(run), true});
+			}
+
+		System* find(std::string const& name)
+			{
+				for(System& s : systems)
+				{
+					if(s.name == name) return &s;
+				}
+				return nullptr;
+			}
+
+		void run(World& world, float elapsed)
+			{
+				for(System& s : systems)
+				{
+					if(s.enabled) s.run(world, elapsed);
+				}
+			}
+
+		std::vector<System> systems;
+	};
+}
+
+#endif
@@ -1,3 +1,270 @@
 #include "GUI.hpp"
 
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
 Gui::Element::~Element() {}
+
+// VAOs can't offset per draw in GL 3.3 (no base instance), so the instance attributes get re-pointed for each batch
+static void point_anchored_instances(size_t first)
+{
+	GLbyte* base = (GLbyte*)0 + first * sizeof(Gui::Batcher::Anchored);
+	GLsizei stride = sizeof(Gui::Batcher::Anchored);
+	glVertexAttribPointer(bar_texture_program->Anchor_vec3, 3, GL_FLOAT, GL_FALSE, stride, base + offsetof(Gui::Batcher::Anchored, anchor));
+	glVertexAttribPointer(bar_texture_program->Scale_vec2, 2, GL_FLOAT, GL_FALSE, stride, base + offsetof(Gui::Batcher::Anchored, scale));
+	glVertexAttribPointer(bar_texture_program->Values_vec2, 2, GL_FLOAT, GL_FALSE, stride, base + offsetof(Gui::Batcher::Anchored, values));
+	glVertexAttribPointer(bar_texture_program->anchored_Percent_f, 1, GL_FLOAT, GL_FALSE, stride, base + offsetof(Gui::Batcher::Anchored, percent));
+	glVertexAttribPointer(bar_texture_program->anchored_Alpha_f, 1, GL_FLOAT, GL_FALSE, stride, base + offsetof(Gui::Batcher::Anchored, alpha));
+	glVertexAttribPointer(bar_texture_program->anchored_FullColor_vec3, 3, GL_FLOAT, GL_FALSE, stride, base + offsetof(Gui::Batcher::Anchored, fullColor));
+	glVertexAttribPointer(bar_texture_program->anchored_EmptyColor_vec3, 3, GL_FLOAT, GL_FALSE, stride, base + offsetof(Gui::Batcher::Anchored, emptyColor));
+}
+
+Gui::Batcher::Batcher()
+{
+	glGenBuffers(1, &vbo);
+	glGenVertexArrays(ProgramCount, vaos);
+
+	// Both VAOs read the same buffer, they just pick out different attributes
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+
+	glBindVertexArray(vaos[Textured]);
+	glVertexAttribPointer(texture_program->Position_vec4, 3, GL_FLOAT, GL_FALSE, sizeof(Vert), (GLbyte*)0 + offsetof(Vert, position));
+	glEnableVertexAttribArray(texture_program->Position_vec4);
+	glVertexAttribPointer(texture_program->TexCoord_vec2, 2, GL_FLOAT, GL_FALSE, sizeof(Vert), (GLbyte*)0 + offsetof(Vert, texCoord));
+	glEnableVertexAttribArray(texture_program->TexCoord_vec2);
+
+	glBindVertexArray(vaos[BarTextured]);
+	glVertexAttribPointer(bar_texture_program->Position_vec4, 3, GL_FLOAT, GL_FALSE, sizeof(Vert), (GLbyte*)0 + offsetof(Vert, position));
+	glEnableVertexAttribArray(bar_texture_program->Position_vec4);
+	glVertexAttribPointer(bar_texture_program->TexCoord_vec2, 2, GL_FLOAT, GL_FALSE, sizeof(Vert), (GLbyte*)0 + offsetof(Vert, texCoord));
+	glEnableVertexAttribArray(bar_texture_program->TexCoord_vec2);
+	glVertexAttribPointer(bar_texture_program->Val_f, 1, GL_FLOAT, GL_FALSE, sizeof(Vert), (GLbyte*)0 + offsetof(Vert, val));
+	glEnableVertexAttribArray(bar_texture_program->Val_f);
+	glVertexAttribPointer(bar_texture_program->Percent_f, 1, GL_FLOAT, GL_FALSE, sizeof(Vert), (GLbyte*)0 + offsetof(Vert, percent));
+	glEnableVertexAttribArray(bar_texture_program->Percent_f);
+	glVertexAttribPointer(bar_texture_program->Alpha_f, 1, GL_FLOAT, GL_FALSE, sizeof(Vert), (GLbyte*)0 + offsetof(Vert, alpha));
+	glEnableVertexAttribArray(bar_texture_program->Alpha_f);
+	glVertexAttribPointer(bar_texture_program->FullColor_vec3, 3, GL_FLOAT, GL_FALSE, sizeof(Vert), (GLbyte*)0 + offsetof(Vert, fullColor));
+	glEnableVertexAttribArray(bar_texture_program->FullColor_vec3);
+	glVertexAttribPointer(bar_texture_program->EmptyColor_vec3, 3, GL_FLOAT, GL_FALSE, sizeof(Vert), (GLbyte*)0 + offsetof(Vert, emptyColor));
+	glEnableVertexAttribArray(bar_texture_program->EmptyColor_vec3);
+
+	// Same corners the screen space bars use, with the side (left 0, right 1) in val
+	Vert quad[4] = {
+		Vert(glm::vec3(-1.0f, -1.0f, 1.0f), glm::vec2(0.0f, 0.0f), 0.0f),
+		Vert(glm::vec3(-1.0f, 1.0f, 1.0f), glm::vec2(0.0f, 1.0f), 0.0f),
+		Vert(glm::vec3(1.0f, -1.0f, 0.0f), glm::vec2(1.0f, 0.0f), 1.0f),
+		Vert(glm::vec3(1.0f, 1.0f, 0.0f), glm::vec2(1.0f, 1.0f), 1.0f),
+	};
+	glGenBuffers(1, &quadVbo);
+	glBindBuffer(GL_ARRAY_BUFFER, quadVbo);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+
+	glBindVertexArray(vaos[AnchoredBar]);
+	glVertexAttribPointer(bar_texture_program->anchored_Position_vec4, 3, GL_FLOAT, GL_FALSE, sizeof(Vert), (GLbyte*)0 + offsetof(Vert, position));
+	glEnableVertexAttribArray(bar_texture_program->anchored_Position_vec4);
+	glVertexAttribPointer(bar_texture_program->anchored_TexCoord_vec2, 2, GL_FLOAT, GL_FALSE, sizeof(Vert), (GLbyte*)0 + offsetof(Vert, texCoord));
+	glEnableVertexAttribArray(bar_texture_program->anchored_TexCoord_vec2);
+	glVertexAttribPointer(bar_texture_program->anchored_Side_f, 1, GL_FLOAT, GL_FALSE, sizeof(Vert), (GLbyte*)0 + offsetof(Vert, val));
+	glEnableVertexAttribArray(bar_texture_program->anchored_Side_f);
+
+	glGenBuffers(1, &instanceVbo);
+	glBindBuffer(GL_ARRAY_BUFFER, instanceVbo);
+	point_anchored_instances(0);
+	for(GLuint attrib : {bar_texture_program->Anchor_vec3, bar_texture_program->Scale_vec2, bar_texture_program->Values_vec2,
+	                     bar_texture_program->anchored_Percent_f, bar_texture_program->anchored_Alpha_f,
+	                     bar_texture_program->anchored_FullColor_vec3, bar_texture_program->anchored_EmptyColor_vec3})
+	{
+		glEnableVertexAttribArray(attrib);
+		glVertexAttribDivisor(attrib, 1);
+	}
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	GL_ERRORS();
+}
+
+Gui::Batcher::~Batcher()
+{
+	glDeleteVertexArrays(ProgramCount, vaos);
+	glDeleteBuffers(1, &vbo);
+	glDeleteBuffers(1, &quadVbo);
+	glDeleteBuffers(1, &instanceVbo);
+}
+
+void Gui::Batcher::begin()
+{
+	for(size_t i = 0; i < batchCount; i++)
+	{
+		batches[i].verts.clear();
+		batches[i].instances.clear();
+	}
+	batchCount = 0;
+}
+
+Gui::Batcher::Batch& Gui::Batcher::findBatch(Program program, GLuint tex)
+{
+	// Only a handful of distinct textures ever show up, so a linear search is fine
+	for(size_t i = 0; i < batchCount; i++)
+	{
+		if(batches[i].program == program && batches[i].tex == tex)
+		{
+			return batches[i];
+		}
+	}
+	if(batchCount == batches.size())
+	{
+		batches.emplace_back();
+	}
+	Batch& batch = batches[batchCount++];
+	batch.program = program;
+	batch.tex = tex;
+	return batch;
+}
+
+void Gui::Batcher::quad(Program program, GLuint tex, Vert const (&corners)[4])
+{
+	assert(program != AnchoredBar && "Anchored bars go through anchored()");
+	Batch& batch = findBatch(program, tex);
+
+	// Strip 0,1,2,3 -> triangles 0,1,2 and 2,1,3
+	batch.verts.push_back(corners[0]);
+	batch.verts.push_back(corners[1]);
+	batch.verts.push_back(corners[2]);
+	batch.verts.push_back(corners[2]);
+	batch.verts.push_back(corners[1]);
+	batch.verts.push_back(corners[3]);
+}
+
+void Gui::Batcher::anchored(GLuint tex, Anchored const& instance)
+{
+	findBatch(AnchoredBar, tex).instances.push_back(instance);
+}
+
+void Gui::Batcher::flush(glm::mat4 const& world_to_clip)
+{
+	drawCalls = 0;
+	if(batchCount == 0) return;
+
+	size_t total = 0;
+	size_t totalInstances = 0;
+	for(size_t i = 0; i < batchCount; i++)
+	{
+		total += batches[i].verts.size();
+		totalInstances += batches[i].instances.size();
+	}
+
+	// Lay every batch out back to back, and only talk to the driver if something moved
+	bool changed = (total != uploaded) || (total > staging.size());
+	staging.resize(std::max(staging.size(), total));
+	size_t offset = 0;
+	for(size_t i = 0; i < batchCount; i++)
+	{
+		std::vector<Vert> const& verts = batches[i].verts;
+		size_t bytes = verts.size() * sizeof(Vert);
+		if(bytes == 0) continue;
+		if(!changed && std::memcmp(staging.data() + offset, verts.data(), bytes) != 0)
+		{
+			changed = true;
+		}
+		std::memcpy(staging.data() + offset, verts.data(), bytes);
+		offset += verts.size();
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	if(total > capacity)
+	{
+		capacity = std::max(total, capacity * 2);
+		glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(Vert), nullptr, GL_STREAM_DRAW);
+		changed = true;
+	}
+	if(changed && total > 0)
+	{
+		glBufferSubData(GL_ARRAY_BUFFER, 0, total * sizeof(Vert), staging.data());
+	}
+	uploaded = total;
+
+	// Anchors move every frame anyway, so no point comparing these
+	if(totalInstances > 0)
+	{
+		instanceStaging.clear();
+		for(size_t i = 0; i < batchCount; i++)
+		{
+			instanceStaging.insert(instanceStaging.end(), batches[i].instances.begin(), batches[i].instances.end());
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, instanceVbo);
+		if(totalInstances > instanceCapacity)
+		{
+			instanceCapacity = std::max(totalInstances, instanceCapacity * 2);
+		}
+		// Orphan so we don't stall on last frame's draw
+		glBufferData(GL_ARRAY_BUFFER, instanceCapacity * sizeof(Anchored), nullptr, GL_STREAM_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, totalInstances * sizeof(Anchored), instanceStaging.data());
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glDisable(GL_DEPTH_TEST);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	// Uniforms the elements don't provide
+	if(totalInstances > 0)
+	{
+		glUseProgram(bar_texture_program->anchored_program);
+		glUniformMatrix4fv(bar_texture_program->anchored_WORLD_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(world_to_clip));
+	}
+	glUseProgram(texture_program->program);
+	glUniformMatrix4fv(texture_program->OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(glm::mat4(1.0f)));
+
+	GLuint const programs[ProgramCount] = {texture_program->program, bar_texture_program->program, bar_texture_program->anchored_program};
+	GLuint boundProgram = texture_program->program;
+	int boundVao = -1;
+	GLuint boundTex = 0;
+	offset = 0;
+	size_t instanceOffset = 0;
+	for(size_t i = 0; i < batchCount; i++)
+	{
+		Batch const& batch = batches[i];
+		GLuint program = programs[batch.program];
+		if(program != boundProgram)
+		{
+			glUseProgram(program);
+			boundProgram = program;
+		}
+		if(boundVao != (int)batch.program)
+		{
+			glBindVertexArray(vaos[batch.program]);
+			boundVao = (int)batch.program;
+		}
+		if(batch.tex != boundTex)
+		{
+			glBindTexture(GL_TEXTURE_2D, batch.tex);
+			boundTex = batch.tex;
+		}
+		if(batch.program == AnchoredBar)
+		{
+			glBindBuffer(GL_ARRAY_BUFFER, instanceVbo);
+			point_anchored_instances(instanceOffset);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)batch.instances.size());
+			instanceOffset += batch.instances.size();
+		}
+		else
+		{
+			glDrawArrays(GL_TRIANGLES, (GLint)offset, (GLsizei)batch.verts.size());
+			offset += batch.verts.size();
+		}
+		drawCalls++;
+	}
+
+	glEnable(GL_DEPTH_TEST);
+	glDisable(GL_BLEND);
+
+	glBindVertexArray(0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glUseProgram(0);
+
+	GL_ERRORS();
+}
@@ -23,12 +23,79 @@ struct Gui
 
 	struct Vert
 	{
-		Vert() : position(0), texCoord(0), val(0) {};
-		Vert(glm::vec3 p, glm::vec2 t, float v) : position(p), texCoord(t), val(v) {};
+		Vert() : position(0), texCoord(0), val(0), percent(0), alpha(1), fullColor(0), emptyColor(0) {};
+		Vert(glm::vec3 p, glm::vec2 t, float v) : position(p), texCoord(t), val(v), percent(0), alpha(1), fullColor(0), emptyColor(0) {};
 		
 		glm::vec3 position;
 		glm::vec2 texCoord;
 		float val;
+		// Only read by bar_texture_program, these used to be per-bar uniforms
+		float percent;
+		float alpha;
+		glm::vec3 fullColor;
+		glm::vec3 emptyColor;
+	};
+
+	// Collects the quads of every visible element into one streaming vertex buffer,
+	// grouped by (program, texture), and draws each group with a single call.
+	// Groups are drawn in the order they were first seen this frame, and quads within a group keep their order.
+	struct Batcher
+	{
+		enum Program : uint8_t
+		{
+			Textured = 0, // texture_program, identity OBJECT_TO_CLIP
+			BarTextured = 1, // bar_texture_program
+			AnchoredBar = 2, // bar_texture_program->anchored_program, instanced
+			ProgramCount
+		};
+
+		// One world-anchored bar, the GPU does the projection
+		struct Anchored
+		{
+			glm::vec3 anchor; // World space
+			glm::vec2 scale;
+			glm::vec2 values; // Val at the left and right edge
+			float percent;
+			float alpha;
+			glm::vec3 fullColor;
+			glm::vec3 emptyColor;
+		};
+
+		Batcher();
+		~Batcher();
+		Batcher(Batcher const&) = delete;
+		Batcher& operator=(Batcher const&) = delete;
+
+		void begin();
+		// Corners are in the old triangle strip order: bottom left, top left, bottom right, top right
+		void quad(Program program, GLuint tex, Vert const (&corners)[4]);
+		void anchored(GLuint tex, Anchored const& instance);
+		void flush(glm::mat4 const& world_to_clip);
+
+		struct Batch
+		{
+			Program program;
+			GLuint tex;
+			std::vector<Vert> verts;
+			std::vector<Anchored> instances; // Only for AnchoredBar
+		};
+		Batch& findBatch(Program program, GLuint tex);
+		std::vector<Batch> batches; // Only the first batchCount are live, the rest keep their capacity around
+		size_t batchCount = 0;
+
+		std::vector<Vert> staging; // What got uploaded last, so an unchanged frame skips the upload
+		size_t uploaded = 0;
+		
+		GLuint vbo = 0;
+		size_t capacity = 0; // In verts
+		GLuint vaos[ProgramCount] = {0, 0, 0};
+
+		GLuint quadVbo = 0; // Unit quad the anchored bars are instanced over, val holds the side
+		std::vector<Anchored> instanceStaging;
+		GLuint instanceVbo = 0;
+		size_t instanceCapacity = 0; // In instances
+
+		uint32_t drawCalls = 0; // Last flush, for debugging
 	};
 
 	struct Element
@@ -37,7 +104,7 @@ struct Gui
 		virtual ~Element() = 0;
 		
 		virtual void update(float elapsed) = 0;
-		virtual void render(glm::mat4 const& world_to_clip) = 0;
+		virtual void render(Batcher& batcher, glm::mat4 const& world_to_clip) = 0;
 	};
 
 	struct MoveGraphic : Element
@@ -45,34 +112,13 @@ struct Gui
 		
 		MoveGraphic(GLuint t) : tex(t)
 			{
-				
-				corners.emplace_back(glm::vec3(popup_bottom_left.x, popup_bottom_left.y, 1.0f), glm::vec2(0.0f, 0.0f), 0.0f); // 1
-				corners.emplace_back(glm::vec3(popup_bottom_left.x, popup_top_right.y, 1.0f), glm::vec2(0.0f, 1.0f), 0.0f); // 2
-				corners.emplace_back(glm::vec3(popup_top_right.x, popup_bottom_left.y, 0.0f), glm::vec2(1.0f, 0.0f), 1.0f); // 4 
-				corners.emplace_back(glm::vec3(popup_top_right.x, popup_top_right.y, 0.0f), glm::vec2(1.0f, 1.0f), 1.0f); // 3
-				
-				glGenBuffers(1, &vbo);
-				glBindBuffer(GL_ARRAY_BUFFER, vbo);
-				glBufferData(GL_ARRAY_BUFFER, corners.size() * sizeof(Vert), corners.data(), GL_STATIC_DRAW);
-
-				glGenVertexArrays(1, &vao);
-				glBindVertexArray(vao);
-				
-				glVertexAttribPointer(texture_program->Position_vec4, 3, GL_FLOAT, GL_FALSE, sizeof(Vert), (GLbyte*)0 + offsetof(Vert, position));
-				glEnableVertexAttribArray(texture_program->Position_vec4);
-
-				glVertexAttribPointer(texture_program->TexCoord_vec2, 2, GL_FLOAT, GL_FALSE, sizeof(Vert), (GLbyte*)0 + offsetof(Vert, texCoord));
-				glEnableVertexAttribArray(texture_program->TexCoord_vec2);
-				
-				glBindBuffer(GL_ARRAY_BUFFER, 0);
-				glBindVertexArray(0);
+				corners[0] = Vert(glm::vec3(popup_bottom_left.x, popup_bottom_left.y, 1.0f), glm::vec2(0.0f, 0.0f), 0.0f); // 1
+				corners[1] = Vert(glm::vec3(popup_bottom_left.x, popup_top_right.y, 1.0f), glm::vec2(0.0f, 1.0f), 0.0f); // 2
+				corners[2] = Vert(glm::vec3(popup_top_right.x, popup_bottom_left.y, 0.0f), glm::vec2(1.0f, 0.0f), 1.0f); // 4 
+				corners[3] = Vert(glm::vec3(popup_top_right.x, popup_top_right.y, 0.0f), glm::vec2(1.0f, 1.0f), 1.0f); // 3
 			}
 
-		virtual ~MoveGraphic()
-			{
-				glDeleteVertexArrays(1, &vao);
-				glDeleteBuffers(1, &vbo);
-			}
+		virtual ~MoveGraphic() {}
 
 		void update(float elapsed) override
 			{
@@ -82,38 +128,17 @@ struct Gui
 			render_triggered = render_triggered_;
 		}
 		
-		void render(glm::mat4 const& world_to_clip) override
+		void render(Batcher& batcher, glm::mat4 const& world_to_clip) override
 			{
 				if (render_triggered){
-
-					glBindBuffer(GL_ARRAY_BUFFER, vbo);
-					glBufferData(GL_ARRAY_BUFFER, sizeof(Vert) * corners.size(), corners.data(), GL_STREAM_DRAW);
-					glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-					glUseProgram(texture_program->program);
-					glUniformMatrix4fv(texture_program->OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(glm::mat4(1.0f)));
-					glBindTexture(GL_TEXTURE_2D, tex);
-					glDisable(GL_DEPTH_TEST);
-					glEnable(GL_BLEND);
-					glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-					glBindVertexArray(vao);
-					glDrawArrays(GL_TRIANGLE_STRIP, 0, (GLsizei)corners.size());
-					glDisable(GL_BLEND);
-					
-					glBindVertexArray(0);
-					glBindTexture(GL_TEXTURE_2D, 0);
-					glUseProgram(0);
-
-					GL_ERRORS();
+					batcher.quad(Batcher::Textured, tex, corners);
 				}
 			}
 		
 		GLuint tex; // We have to give this
-		std::vector<Vert> corners;
-		GLuint vao; // It makes these
-		GLuint vbo;
 		glm::vec2 popup_bottom_left = glm::vec2(-0.1f, -0.4f);
 	    glm::vec2 popup_top_right = glm::vec2(0.1f,-0.3f);
+		Vert corners[4];
 		bool render_triggered = false;
 	};
 
@@ -126,26 +151,10 @@ struct Gui
 				visibility_triggered = initial_visibility;
 				display_interval = display_interval_;
 				
-				corners.emplace_back(glm::vec3(popup_bottom_left.x, popup_bottom_left.y, 1.0f), glm::vec2(0.0f, 0.0f), 0.0f); // 1
-				corners.emplace_back(glm::vec3(popup_bottom_left.x, popup_top_right.y, 1.0f), glm::vec2(0.0f, 1.0f), 0.0f); // 2
-				corners.emplace_back(glm::vec3(popup_top_right.x, popup_bottom_left.y, 0.0f), glm::vec2(1.0f, 0.0f), 1.0f); // 4 
-				corners.emplace_back(glm::vec3(popup_top_right.x, popup_top_right.y, 0.0f), glm::vec2(1.0f, 1.0f), 1.0f); // 3
-				
-				glGenBuffers(1, &vbo);
-				glBindBuffer(GL_ARRAY_BUFFER, vbo);
-				glBufferData(GL_ARRAY_BUFFER, corners.size() * sizeof(Vert), corners.data(), GL_STATIC_DRAW);
-
-				glGenVertexArrays(1, &vao);
-				glBindVertexArray(vao);
-				
-				glVertexAttribPointer(texture_program->Position_vec4, 3, GL_FLOAT, GL_FALSE, sizeof(Vert), (GLbyte*)0 + offsetof(Vert, position));
-				glEnableVertexAttribArray(texture_program->Position_vec4);
-
-				glVertexAttribPointer(texture_program->TexCoord_vec2, 2, GL_FLOAT, GL_FALSE, sizeof(Vert), (GLbyte*)0 + offsetof(Vert, texCoord));
-				glEnableVertexAttribArray(texture_program->TexCoord_vec2);
-				
-				glBindBuffer(GL_ARRAY_BUFFER, 0);
-				glBindVertexArray(0);
+				corners[0] = Vert(glm::vec3(popup_bottom_left.x, popup_bottom_left.y, 1.0f), glm::vec2(0.0f, 0.0f), 0.0f); // 1
+				corners[1] = Vert(glm::vec3(popup_bottom_left.x, popup_top_right.y, 1.0f), glm::vec2(0.0f, 1.0f), 0.0f); // 2
+				corners[2] = Vert(glm::vec3(popup_top_right.x, popup_bottom_left.y, 0.0f), glm::vec2(1.0f, 0.0f), 1.0f); // 4 
+				corners[3] = Vert(glm::vec3(popup_top_right.x, popup_top_right.y, 0.0f), glm::vec2(1.0f, 1.0f), 1.0f); // 3
 
 				if (initial_visibility){
 					previous_display_start_time = ((float)clock())/1000.0f;
@@ -153,11 +162,7 @@ struct Gui
 
 			}
 
-		virtual ~Popup()
-			{
-				glDeleteVertexArrays(1, &vao);
-				glDeleteBuffers(1, &vbo);
-			}
+		virtual ~Popup() {}
 
 		void update(float elapsed) override
 			{	
@@ -185,40 +190,18 @@ struct Gui
 			return visibility_triggered;
 		}
 		
-		void render(glm::mat4 const& world_to_clip) override
+		void render(Batcher& batcher, glm::mat4 const& world_to_clip) override
 			{
-				// std::cout << "render popup " << std::endl;
 				if (visibility_triggered){
-
-					glBindBuffer(GL_ARRAY_BUFFER, vbo);
-					glBufferData(GL_ARRAY_BUFFER, sizeof(Vert) * corners.size(), corners.data(), GL_STREAM_DRAW);
-					glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-					glUseProgram(texture_program->program);
-					glUniformMatrix4fv(texture_program->OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(glm::mat4(1.0f)));
-					glBindTexture(GL_TEXTURE_2D, tex);
-					glDisable(GL_DEPTH_TEST);
-					glEnable(GL_BLEND);
-					glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-					glBindVertexArray(vao);
-					glDrawArrays(GL_TRIANGLE_STRIP, 0, (GLsizei)corners.size());
-					glDisable(GL_BLEND);
-					
-					glBindVertexArray(0);
-					glBindTexture(GL_TEXTURE_2D, 0);
-					glUseProgram(0);
-
-					GL_ERRORS();
+					batcher.quad(Batcher::Textured, tex, corners);
 				}
 			}
 		
 		GLuint tex; // We have to give this
-		std::vector<Vert> corners;
-		GLuint vao; // It makes these
-		GLuint vbo;
 		bool visibility_triggered;
 		glm::vec2 popup_bottom_left = glm::vec2(-1.0f, -1.0f);
 	    glm::vec2 popup_top_right = glm::vec2(1.0f, 1.0f);
+		Vert corners[4];
 		float display_interval; 
 		float previous_display_start_time = 0.0f;
 	};
@@ -228,118 +211,126 @@ struct Gui
 		
 		Bar(std::function<float(float)> c, GLuint t, float leftValue, float rightValue) : calculateValue(c), tex(t)
 			{
-				std::vector<Vert> corners;
-
 				glm::vec2 hpbar_bottom_left = glm::vec2(-1.0f, -1.0f);
 				glm::vec2 hpbar_top_right = glm::vec2(1.0f, 1.0f);
 				
-				corners.emplace_back(glm::vec3(hpbar_bottom_left.x, hpbar_bottom_left.y, 1.0f), glm::vec2(0.0f, 0.0f), leftValue); // 1
-				corners.emplace_back(glm::vec3(hpbar_bottom_left.x, hpbar_top_right.y, 1.0f), glm::vec2(0.0f, 1.0f), leftValue); // 2
-				corners.emplace_back(glm::vec3(hpbar_top_right.x, hpbar_bottom_left.y, 0.0f), glm::vec2(1.0f, 0.0f), rightValue); // 4 
-				corners.emplace_back(glm::vec3(hpbar_top_right.x, hpbar_top_right.y, 0.0f), glm::vec2(1.0f, 1.0f), rightValue); // 3
-				
-				glGenBuffers(1, &vbo);
-				glBindBuffer(GL_ARRAY_BUFFER, vbo);
-				glBufferData(GL_ARRAY_BUFFER, corners.size() * sizeof(Vert), corners.data(), GL_STATIC_DRAW);
-
-				glGenVertexArrays(1, &vao);
-				glBindVertexArray(vao);
-				
-				glVertexAttribPointer(bar_texture_program->Position_vec4, 3, GL_FLOAT, GL_FALSE, sizeof(Vert), (GLbyte*)0 + offsetof(Vert, position));
-				glEnableVertexAttribArray(bar_texture_program->Position_vec4);
+				corners[0] = Vert(glm::vec3(hpbar_bottom_left.x, hpbar_bottom_left.y, 1.0f), glm::vec2(0.0f, 0.0f), leftValue); // 1
+				corners[1] = Vert(glm::vec3(hpbar_bottom_left.x, hpbar_top_right.y, 1.0f), glm::vec2(0.0f, 1.0f), leftValue); // 2
+				corners[2] = Vert(glm::vec3(hpbar_top_right.x, hpbar_bottom_left.y, 0.0f), glm::vec2(1.0f, 0.0f), rightValue); // 4 
+				corners[3] = Vert(glm::vec3(hpbar_top_right.x, hpbar_top_right.y, 0.0f), glm::vec2(1.0f, 1.0f), rightValue); // 3
+			}
 
-				glVertexAttribPointer(bar_texture_program->TexCoord_vec2, 2, GL_FLOAT, GL_FALSE, sizeof(Vert), (GLbyte*)0 + offsetof(Vert, texCoord));
-				glEnableVertexAttribArray(bar_texture_program->TexCoord_vec2);
+		virtual ~Bar() {}
 
-				glVertexAttribPointer(bar_texture_program->Val_f, 1, GL_FLOAT, GL_FALSE, sizeof(Vert), (GLbyte*)0 + offsetof(Vert, val));
-				glEnableVertexAttribArray(bar_texture_program->Val_f);
-				
-				glBindBuffer(GL_ARRAY_BUFFER, 0);
-				glBindVertexArray(0);
+		void update(float elapsed) override
+			{
+				value = calculateValue(elapsed);
 			}
+		void render(Batcher& batcher, glm::mat4 const& world_to_clip) override
+			{
+				// Scale + offset used to happen in the vertex shader, now it's done here so bars can share a draw
+				Vert placed[4];
+				for(size_t i = 0; i < 4; i++)
+				{
+					placed[i] = corners[i];
+					placed[i].position = glm::vec3(corners[i].position.x * scale.x, corners[i].position.y * scale.y, corners[i].position.z) + screenPos;
+					placed[i].percent = value;
+					placed[i].alpha = alpha;
+					placed[i].fullColor = fullColor;
+					placed[i].emptyColor = emptyColor;
+				}
+				batcher.quad(Batcher::BarTextured, tex, placed);
+			}
+		
+		std::function<float(float)> calculateValue; // Function that calculates the value for this bar
+		float value; // From 0 to 1, don't touch
+
+		GLuint tex; // We have to give this
+		
+		Vert corners[4]; // Unscaled, it makes these
 
-		virtual ~Bar()
+		glm::vec3 fullColor = glm::vec3(0.0f, 1.0f, 0.0f);
+		glm::vec3 emptyColor = glm::vec3(1.0f, 0.0f, 0.0f);
+		
+		glm::vec3 screenPos = glm::vec3(0.0f, 0.0f, 0.0f);
+		glm::vec2 scale = glm::vec2(1.0f, 1.0f);
+		float alpha = 1.0f;
+	};
+
+	// Bar that floats over a point in the world, projected in the vertex shader instead of by the caller
+	struct WorldBar : Element
+	{
+		
+		WorldBar(std::function<float(float)> c, GLuint t, float leftValue, float rightValue) : calculateValue(c), tex(t), values(leftValue, rightValue)
 			{
-				glDeleteVertexArrays(1, &vao);
-				glDeleteBuffers(1, &vbo);
 			}
 
+		virtual ~WorldBar() {}
+
 		void update(float elapsed) override
 			{
 				value = calculateValue(elapsed);
 			}
-		void render(glm::mat4 const& world_to_clip) override
+		void render(Batcher& batcher, glm::mat4 const& world_to_clip) override
 			{
-				glUseProgram(bar_texture_program->program);
-				glUniform1f(bar_texture_program->PERCENT_float, value);
-				glUniform1f(bar_texture_program->ALPHA_float, alpha);
-				glUniform4fv(bar_texture_program->CLIPPOS_vec4, 1, glm::value_ptr(glm::vec4(screenPos, 0.0f)));
-				glUniform2fv(bar_texture_program->SCALE_vec2, 1, glm::value_ptr(scale));
-				glUniform3fv(bar_texture_program->FULLCO_vec3, 1, glm::value_ptr(fullColor));
-				glUniform3fv(bar_texture_program->EMPTYCO_vec3, 1, glm::value_ptr(emptyColor));
-				glBindTexture(GL_TEXTURE_2D, tex);
-				
-				glDisable(GL_DEPTH_TEST);
-				glEnable(GL_BLEND);
-				glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-				
-				glBindVertexArray(vao);
-				glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-				
-				glEnable(GL_DEPTH_TEST);
-				glDisable(GL_BLEND);
-				
-				glBindVertexArray(0);
-				glBindTexture(GL_TEXTURE_2D, 0);
-				glUseProgram(0);
-
-				GL_ERRORS();
+				Batcher::Anchored instance;
+				// Transform's world matrix is cached, the scene refreshes it right before drawing
+				instance.anchor = (anchor != nullptr) ? anchor->get_local_to_world() * glm::vec4(anchorOffset, 1.0f) : worldPos;
+				instance.scale = scale;
+				instance.values = values;
+				instance.percent = value;
+				instance.alpha = alpha;
+				instance.fullColor = fullColor;
+				instance.emptyColor = emptyColor;
+				batcher.anchored(tex, instance);
 			}
 		
 		std::function<float(float)> calculateValue; // Function that calculates the value for this bar
 		float value; // From 0 to 1, don't touch
 
 		GLuint tex; // We have to give this
-		
-		GLuint vao; // It makes these
-		GLuint vbo;
+		glm::vec2 values; // Val at the left and right edges
 
 		glm::vec3 fullColor = glm::vec3(0.0f, 1.0f, 0.0f);
 		glm::vec3 emptyColor = glm::vec3(1.0f, 0.0f, 0.0f);
+
+		// If anchor is set the bar sits at anchorOffset in its local space, otherwise at worldPos
+		// Whoever owns the transform has to remove the bar before the transform goes away
+		Scene::Transform const* anchor = nullptr;
+		glm::vec3 anchorOffset = glm::vec3(0.0f, 0.0f, 0.0f);
+		glm::vec3 worldPos = glm::vec3(0.0f, 0.0f, 0.0f);
 		
-		glm::vec3 screenPos = glm::vec3(0.0f, 0.0f, 0.0f);
-		glm::vec2 scale = glm::vec2(1.0f, 1.0f);
+		glm::vec2 scale = glm::vec2(1.0f, 1.0f); // Clip space, so it stays the same size on screen
 		float alpha = 1.0f;
 
-		bool useCreatureID = false;
-		Game::CreatureID creatureIDForPos;
+		Game::CreatureID creatureID; // Just bookkeeping for whoever made this
 	};
 	
 	Gui() : elements() {};
 
-	~Gui() {} // Slots automatically handles deletion of the Element*
+	~Gui()
+		{
+			for(Element* elem : elements)
+			{
+				delete elem;
+			}
+		}
 	
 	void update(float elapsed)
 		{
-			for(auto e : elements.slots)
+			for(Element* elem : elements)
 			{
-				Element* elem = std::get<0>(e);
-				if(elem != nullptr)
-				{
-					elem->update(elapsed);
-				}
+				elem->update(elapsed);
 			}
 		}
 	void render(glm::mat4 const& world_to_clip)
 		{
-			for(auto e : elements.slots)
+			batcher.begin();
+			for(Element* elem : elements)
 			{
-				Element* elem = std::get<0>(e);
-				if(elem != nullptr)
-				{
-					elem->render(world_to_clip);
-				}
+				elem->render(batcher, world_to_clip);
 			}
+			batcher.flush(world_to_clip);
 		}
 
 	typedef SlotID GuiID;
@@ -350,14 +341,22 @@ struct Gui
 		}
 	bool removeElement(GuiID id)
 		{
+			Element** e = elements.get(id);
+			if(!e)
+			{
+				return false;
+			}
+			delete *e;
 			return elements.destroy(id);
 		}
 	Element* getElement(GuiID id)
 		{
-			return elements.get(id);
+			Element** e = elements.get(id);
+			return e ? *e : nullptr;
 		}
 	
-	Slots<Element*, 128> elements;
+	Slots<Element*> elements; // Packed, so draw order shifts when something is removed
+	Batcher batcher;
 };
 
 #endif
@@ -15,6 +15,9 @@ Load< LitColorTextureProgram > lit_color_texture_program(LoadTagEarly, []() -> L
 	lit_color_texture_program_pipeline.OBJECT_TO_LIGHT_mat4x3 = ret->OBJECT_TO_LIGHT_mat4x3;
 	lit_color_texture_program_pipeline.NORMAL_TO_LIGHT_mat3 = ret->NORMAL_TO_LIGHT_mat3;
 
+	lit_color_texture_program_pipeline.instancing.program = ret->instanced_program;
+	lit_color_texture_program_pipeline.instancing.buffer = ret->instance_buffer;
+
 	/* This will be used later if/when we build a light loop into the Scene:
 	lit_color_texture_program_pipeline.LIGHT_TYPE_int = ret->LIGHT_TYPE_int;
 	lit_color_texture_program_pipeline.LIGHT_LOCATION_vec3 = ret->LIGHT_LOCATION_vec3;
@@ -43,6 +46,46 @@ Load< LitColorTextureProgram > lit_color_texture_program(LoadTagEarly, []() -> L
 	return ret;
 });
 
+//fragment shader shared by the plain and instanced programs:
+static char const *lit_color_texture_fragment_shader =
+	"#version 330\n"
+	"uniform sampler2D TEX;\n"
+	"uniform int LIGHT_TYPE;\n"
+	"uniform vec3 LIGHT_LOCATION;\n"
+	"uniform vec3 LIGHT_DIRECTION;\n"
+	"uniform vec3 LIGHT_ENERGY;\n"
+	"uniform float LIGHT_CUTOFF;\n"
+	"in vec3 position;\n"
+	"in vec3 normal;\n"
+	"in vec4 color;\n"
+	"in vec2 texCoord;\n"
+	"out vec4 fragColor;\n"
+	"void main() {\n"
+	"	vec3 n = normalize(normal);\n"
+	"	vec3 e;\n"
+	"	if (LIGHT_TYPE == 0) { //point light \n"
+	"		vec3 l = (LIGHT_LOCATION - position);\n"
+	"		float dis2 = dot(l,l);\n"
+	"		l = normalize(l);\n"
+	"		float nl = max(0.0, dot(n, l)) / max(1.0, dis2);\n"
+	"		e = nl * LIGHT_ENERGY;\n"
+	"	} else if (LIGHT_TYPE == 1) { //hemi light \n"
+	"		e = (dot(n,-LIGHT_DIRECTION) * 0.5 + 0.5) * LIGHT_ENERGY;\n"
+	"	} else if (LIGHT_TYPE == 2) { //spot light \n"
+	"		vec3 l = (LIGHT_LOCATION - position);\n"
+	"		float dis2 = dot(l,l);\n"
+	"		l = normalize(l);\n"
+	"		float nl = max(0.0, dot(n, l)) / max(1.0, dis2);\n"
+	"		float c = dot(l,-LIGHT_DIRECTION);\n"
+	"		nl *= smoothstep(LIGHT_CUTOFF,mix(LIGHT_CUTOFF,1.0,0.1), c);\n"
+	"		e = nl * LIGHT_ENERGY;\n"
+	"	} else { //(LIGHT_TYPE == 3) //directional light \n"
+	"		e = max(0.0, dot(n,-LIGHT_DIRECTION)) * LIGHT_ENERGY;\n"
+	"	}\n"
+	"	vec4 albedo = texture(TEX, texCoord) * color;\n"
+	"	fragColor = vec4(e*albedo.rgb, albedo.a);\n"
+	"}\n";
+
 LitColorTextureProgram::LitColorTextureProgram() {
 	//Compile vertex and fragment shaders using the convenient 'gl_compile_program' helper function:
 	program = gl_compile_program(
@@ -68,43 +111,7 @@ LitColorTextureProgram::LitColorTextureProgram() {
 		"}\n"
 	,
 		//fragment shader:
-		"#version 330\n"
-		"uniform sampler2D TEX;\n"
-		"uniform int LIGHT_TYPE;\n"
-		"uniform vec3 LIGHT_LOCATION;\n"
-		"uniform vec3 LIGHT_DIRECTION;\n"
-		"uniform vec3 LIGHT_ENERGY;\n"
-		"uniform float LIGHT_CUTOFF;\n"
-		"in vec3 position;\n"
-		"in vec3 normal;\n"
-		"in vec4 color;\n"
-		"in vec2 texCoord;\n"
-		"out vec4 fragColor;\n"
-		"void main() {\n"
-		"	vec3 n = normalize(normal);\n"
-		"	vec3 e;\n"
-		"	if (LIGHT_TYPE == 0) { //point light \n"
-		"		vec3 l = (LIGHT_LOCATION - position);\n"
-		"		float dis2 = dot(l,l);\n"
-		"		l = normalize(l);\n"
-		"		float nl = max(0.0, dot(n, l)) / max(1.0, dis2);\n"
-		"		e = nl * LIGHT_ENERGY;\n"
-		"	} else if (LIGHT_TYPE == 1) { //hemi light \n"
-		"		e = (dot(n,-LIGHT_DIRECTION) * 0.5 + 0.5) * LIGHT_ENERGY;\n"
-		"	} else if (LIGHT_TYPE == 2) { //spot light \n"
-		"		vec3 l = (LIGHT_LOCATION - position);\n"
-		"		float dis2 = dot(l,l);\n"
-		"		l = normalize(l);\n"
-		"		float nl = max(0.0, dot(n, l)) / max(1.0, dis2);\n"
-		"		float c = dot(l,-LIGHT_DIRECTION);\n"
-		"		nl *= smoothstep(LIGHT_CUTOFF,mix(LIGHT_CUTOFF,1.0,0.1), c);\n"
-		"		e = nl * LIGHT_ENERGY;\n"
-		"	} else { //(LIGHT_TYPE == 3) //directional light \n"
-		"		e = max(0.0, dot(n,-LIGHT_DIRECTION)) * LIGHT_ENERGY;\n"
-		"	}\n"
-		"	vec4 albedo = texture(TEX, texCoord) * color;\n"
-		"	fragColor = vec4(e*albedo.rgb, albedo.a);\n"
-		"}\n"
+		lit_color_texture_fragment_shader
 	);
 	//As you can see above, adjacent strings in C/C++ are concatenated.
 	// this is very useful for writing long shader programs inline.
@@ -135,10 +142,59 @@ LitColorTextureProgram::LitColorTextureProgram() {
 	glUniform1i(TEX_sampler2D, 0); //set TEX to sample from GL_TEXTURE0
 
 	glUseProgram(0); //unbind program -- glUniform* calls refer to ??? now
+
+	//----- instanced variant -----
+	instanced_program = gl_compile_program(
+		//vertex shader:
+		"#version 330\n"
+		"in mat4 ObjectToClip;\n"
+		"in mat4x3 ObjectToLight;\n"
+		"in mat3 NormalToLight;\n"
+		"in vec4 Position;\n"
+		"in vec3 Normal;\n"
+		"in vec4 Color;\n"
+		"in vec2 TexCoord;\n"
+		"out vec3 position;\n"
+		"out vec3 normal;\n"
+		"out vec4 color;\n"
+		"out vec2 texCoord;\n"
+		"void main() {\n"
+		"	gl_Position = ObjectToClip * Position;\n"
+		"	position = ObjectToLight * Position;\n"
+		"	normal = NormalToLight * Normal;\n"
+		"	color = Color;\n"
+		"	texCoord = TexCoord;\n"
+		"}\n"
+	,
+		//fragment shader:
+		lit_color_texture_fragment_shader
+	);
+
+	ObjectToClip_mat4 = glGetAttribLocation(instanced_program, "ObjectToClip");
+	ObjectToLight_mat4x3 = glGetAttribLocation(instanced_program, "ObjectToLight");
+	NormalToLight_mat3 = glGetAttribLocation(instanced_program, "NormalToLight");
+
+	instanced_LIGHT_TYPE_int = glGetUniformLocation(instanced_program, "LIGHT_TYPE");
+	instanced_LIGHT_LOCATION_vec3 = glGetUniformLocation(instanced_program, "LIGHT_LOCATION");
+	instanced_LIGHT_DIRECTION_vec3 = glGetUniformLocation(instanced_program, "LIGHT_DIRECTION");
+	instanced_LIGHT_ENERGY_vec3 = glGetUniformLocation(instanced_program, "LIGHT_ENERGY");
+	instanced_LIGHT_CUTOFF_float = glGetUniformLocation(instanced_program, "LIGHT_CUTOFF");
+
+	glUseProgram(instanced_program);
+	glUniform1i(glGetUniformLocation(instanced_program, "TEX"), 0); //set TEX to sample from GL_TEXTURE0
+	glUseProgram(0);
+
+	glGenBuffers(1, &instance_buffer);
 }
 
 LitColorTextureProgram::~LitColorTextureProgram() {
 	glDeleteProgram(program);
 	program = 0;
+
+	glDeleteProgram(instanced_program);
+	instanced_program = 0;
+
+	glDeleteBuffers(1, &instance_buffer);
+	instance_buffer = 0;
 }
 
@@ -31,10 +31,30 @@ struct LitColorTextureProgram {
 	
 	//Textures:
 	//TEXTURE0 - texture that is accessed by TexCoord
+
+	//Instanced variant, identical except that the OBJECT_TO_* matrices come from per-instance attributes
+	// (laid out as Scene::Instance) rather than uniforms:
+	GLuint instanced_program = 0;
+
+	//Attribute locations (per-instance):
+	GLuint ObjectToClip_mat4 = -1U;
+	GLuint ObjectToLight_mat4x3 = -1U;
+	GLuint NormalToLight_mat3 = -1U;
+
+	//Uniform locations (lighting, same meaning as above):
+	GLuint instanced_LIGHT_TYPE_int = -1U;
+	GLuint instanced_LIGHT_LOCATION_vec3 = -1U;
+	GLuint instanced_LIGHT_DIRECTION_vec3 = -1U;
+	GLuint instanced_LIGHT_ENERGY_vec3 = -1U;
+	GLuint instanced_LIGHT_CUTOFF_float = -1U;
+
+	//buffer the scene streams per-instance data into:
+	GLuint instance_buffer = 0;
 };
 
 extern Load< LitColorTextureProgram > lit_color_texture_program;
 
 //For convenient scene-graph setup, copy this object:
 // NOTE: by default, has texture bound to 1-pixel white texture -- so it's okay to use with vertex-color-only meshes.
+// NOTE: instancing.program/buffer are filled in; set instancing.vao (see MeshBuffer::make_vao_for_program) to enable instancing.
 extern Scene::Drawable::Pipeline lit_color_texture_program_pipeline;
@@ -0,0 +1,197 @@
+#include "Locomotion.hpp"
+
+#include <glm/gtx/quaternion.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+
+// Small enough that the pool overhead doesn't eat the win, big enough to spread a few hundred pawns around
+static size_t const WALKER_GRAIN = 16;
+
+static uint64_t cell_key(int32_t x, int32_t y)
+{
+	return ((uint64_t)(uint32_t)x << 32) | (uint64_t)(uint32_t)y;
+}
+
+void Locomotion::walk(WalkMesh const& walkmesh, std::vector<Walker>& walkers, WorkerPool& pool, Separation separation)
+{
+	separate(walkers, pool, separation);
+
+	pool.parallel_for(walkers.size(), WALKER_GRAIN, [&walkmesh, &walkers](size_t begin, size_t end)
+		{
+			for(size_t i = begin; i < end; i++)
+			{
+				if(!walkers[i].obstacleOnly)
+				{
+					walk_one(walkmesh, walkers[i]);
+				}
+			}
+		});
+}
+
+// Takes the part of remain that heads toward the other walker back out, same push either separation uses
+static glm::vec3 slide_off(glm::vec3 const& remain, glm::vec3 const& toOther)
+{
+	float toOtherLength = glm::length(toOther);
+	float remainLength = glm::length(remain);
+	if(remainLength * toOtherLength > 0.0001f)
+	{
+		return remain - remain * glm::dot(toOther / toOtherLength, remain / remainLength);
+	}
+	return remain;
+}
+
+static void separate_spatial_hash(std::vector<Locomotion::Walker>& walkers, WorkerPool& pool)
+{
+	float maxRadius = 0.0f;
+	for(Locomotion::Walker const& w : walkers)
+	{
+		maxRadius = std::max(maxRadius, w.radius);
+	}
+	if(maxRadius <= 0.0f || walkers.size() < 2) return;
+
+	// Any two walkers that touch are at most two max radii apart, so with cells that big they're in neighboring cells
+	// Pawns stay on the ground, so hashing x and y is plenty (distance check is still 3d)
+	float cellSize = 2.0f * maxRadius;
+	auto cell_of = [cellSize](glm::vec3 const& p) -> glm::ivec2
+		{
+			return glm::ivec2((int32_t)std::floor(p.x / cellSize), (int32_t)std::floor(p.y / cellSize));
+		};
+
+	// Sorted (cell, walker) pairs, so each cell is a contiguous run
+	std::vector<std::pair<uint64_t, uint32_t>> cells;
+	cells.reserve(walkers.size());
+	for(uint32_t i = 0; i < walkers.size(); i++)
+	{
+		glm::ivec2 c = cell_of(walkers[i].position);
+		cells.emplace_back(cell_key(c.x, c.y), i);
+	}
+	std::sort(cells.begin(), cells.end());
+
+	pool.parallel_for(walkers.size(), WALKER_GRAIN, [&walkers, &cells, &cell_of](size_t begin, size_t end)
+		{
+			std::vector<uint32_t> nearby;
+			for(size_t i = begin; i < end; i++)
+			{
+				Locomotion::Walker& w = walkers[i];
+				if(w.obstacleOnly) continue;
+
+				nearby.clear();
+				glm::ivec2 c = cell_of(w.position);
+				for(int32_t dx = -1; dx <= 1; dx++)
+				{
+					for(int32_t dy = -1; dy <= 1; dy++)
+					{
+						uint64_t key = cell_key(c.x + dx, c.y + dy);
+						auto it = std::lower_bound(cells.begin(), cells.end(), std::make_pair(key, (uint32_t)0));
+						for(; it != cells.end() && it->first == key; it++)
+						{
+							if(it->second != i) nearby.push_back(it->second);
+						}
+					}
+				}
+				std::sort(nearby.begin(), nearby.end()); // Order matters, each push works on what the last one left
+
+				glm::vec3 remain = w.move;
+				for(uint32_t j : nearby)
+				{
+					Locomotion::Walker const& other = walkers[j];
+					glm::vec3 toOther = other.position - w.position;
+					if(glm::length(toOther) < (other.radius + w.radius))
+					{
+						remain = slide_off(remain, toOther);
+					}
+				}
+				// Only this walker's move changes, and nobody else reads moves, so writing in place is fine
+				w.move = remain;
+			}
+		});
+}
+
+static void separate_contacts(std::vector<Locomotion::Walker>& walkers, WorkerPool& pool)
+{
+	pool.parallel_for(walkers.size(), WALKER_GRAIN, [&walkers](size_t begin, size_t end)
+		{
+			for(size_t i = begin; i < end; i++)
+			{
+				Locomotion::Walker& w = walkers[i];
+				if(!w.obstacleOnly)
+				{
+					glm::vec3 remain = w.move;
+					for(glm::vec3 const& contact : w.contacts)
+					{
+						// Pawns stay on the ground, so only the horizontal part of the push matters
+						remain = slide_off(remain, glm::vec3(contact.x, contact.y, 0.0f));
+					}
+					w.move = remain;
+				}
+				w.contacts.clear();
+			}
+		});
+}
+
+void Locomotion::separate(std::vector<Walker>& walkers, WorkerPool& pool, Separation separation)
+{
+	if(separation == Separation::CONTACTS)
+	{
+		separate_contacts(walkers, pool);
+	}
+	else
+	{
+		separate_spatial_hash(walkers, pool);
+	}
+}
+
+void Locomotion::walk_one(WalkMesh const& walkmesh, Walker& walker)
+{
+	glm::vec3 remain = walker.move;
+
+	//using a for() instead of a while() here so that if walkpoint gets stuck I
+	// some awkward case, code will not infinite loop:
+	for(uint32_t iter = 0; iter < 10; ++iter)
+	{
+		if (remain == glm::vec3(0.0f)) break;
+		WalkPoint end;
+		float time;
+		walkmesh.walk_in_triangle(walker.at, remain, &end, &time);
+		walker.at = end;
+		if (time == 1.0f) {
+			//finished within triangle:
+			remain = glm::vec3(0.0f);
+			break;
+		}
+		//some step remains:
+		remain *= (1.0f - time);
+		//try to step over edge:
+		glm::quat rotation;
+		if (walkmesh.cross_edge(walker.at, &end, &rotation)) {
+			//stepped to a new triangle:
+			walker.at = end;
+			//rotate step to follow surface:
+			remain = rotation * remain;
+		} else {
+			//ran into a wall, bounce / slide along it:
+			glm::vec3 const &a = walkmesh.vertices[walker.at.indices.x];
+			glm::vec3 const &b = walkmesh.vertices[walker.at.indices.y];
+			glm::vec3 const &c = walkmesh.vertices[walker.at.indices.z];
+			glm::vec3 along = glm::normalize(b-a);
+			glm::vec3 normal = glm::normalize(glm::cross(b-a, c-a));
+			glm::vec3 in = glm::cross(normal, along);
+
+			//check how much 'remain' is pointing out of the triangle:
+			float d = glm::dot(remain, in);
+			if (d < 0.0f) {
+				//bounce off of the wall:
+				remain += (-1.25f * d) * in;
+			} else {
+				//if it's just pointing along the edge, bend slightly away from wall:
+				remain += 0.01f * d * in;
+			}
+		}
+	}
+
+	walker.outOfIterations = (remain != glm::vec3(0.0f));
+	walker.walked = walkmesh.to_world_point(walker.at);
+}
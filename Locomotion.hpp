@@ -0,0 +1,51 @@
+#ifndef LOCOMOTION_HPP
+#define LOCOMOTION_HPP
+
+#include "WalkMesh.hpp"
+#include "WorkerPool.hpp"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// Moves a whole batch of pawns over a walk mesh at once
+// Everything reads the positions from before the batch, so the result doesn't depend on thread count or scheduling
+struct Locomotion
+{
+	struct Walker
+	{
+		// In:
+		glm::vec3 position = glm::vec3(0.0f); // Feet, where the walker is before this step
+		float radius = 1.0f; // Walkers closer than the sum of their radii push each other's moves aside
+		glm::vec3 move = glm::vec3(0.0f); // Desired displacement this step (already scaled by elapsed)
+		bool obstacleOnly = false; // Gets avoided but doesn't walk
+
+		// Only read with Separation::CONTACTS, unit normals from this walker's body toward each body it's touching,
+		// from the last collision update. Used up (and cleared) by separate
+		std::vector<glm::vec3> contacts;
+
+		// In/out:
+		WalkPoint at;
+
+		// Out:
+		glm::vec3 walked = glm::vec3(0.0f); // Feet after walking
+		bool outOfIterations = false; // Hit the edge crossing budget with some move left
+	};
+
+	// How separate keeps walkers out of each other
+	enum class Separation
+	{
+		SPATIAL_HASH, // Walkers inside each other's radius, found with a spatial hash over this step's positions
+		CONTACTS // The body contacts the collision engine reported last update (needs enemy bodies colliding with each other)
+	};
+
+	// Resolves separation between walkers, then walks them all across the mesh
+	// Neighbors are applied in index order, the same order a single walker loop would use
+	static void walk(WalkMesh const& walkmesh, std::vector<Walker>& walkers, WorkerPool& pool, Separation separation = Separation::SPATIAL_HASH);
+
+	// The two halves of walk, in case someone wants them separately
+	static void separate(std::vector<Walker>& walkers, WorkerPool& pool, Separation separation = Separation::SPATIAL_HASH);
+	static void walk_one(WalkMesh const& walkmesh, Walker& walker);
+};
+
+#endif
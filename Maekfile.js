@@ -128,14 +128,16 @@ if (maek.OS === 'windows') {
 // cppFile: name of c++ file to compile
 // objFileBase (optional): base name object file to produce (if not supplied, set to options.objDir + '/' + cppFile without the extension)
 //returns objFile: objFileBase + a platform-dependant suffix ('.o' or '.obj')
+
+//enemy AI, shared with its test:
+const ai_names = [
+	maek.CPP('BT.cpp')
+];
+
 const game_names = [
-	maek.CPP('BehaviorTree.cpp'),
-	maek.CPP('WalkMesh.cpp'),
 	maek.CPP('PlayMode.cpp'),
 	maek.CPP('main.cpp'),
 	maek.CPP('LitColorTextureProgram.cpp'),
-	maek.CPP('TextureProgram.cpp'),
-	maek.CPP('BarTextureProgram.cpp'),
 	//maek.CPP('ColorTextureProgram.cpp'),  //not used right now, but you might want it
 	maek.CPP('Sound.cpp'),
 	maek.CPP('load_wav.cpp'),
@@ -160,6 +162,11 @@ const common_names = [
 	maek.CPP('Game.cpp'),
 	maek.CPP('Collisions.cpp'),
 	maek.CPP('GUI.cpp'),
+	maek.CPP('TextureProgram.cpp'), //GUI draws with these two
+	maek.CPP('BarTextureProgram.cpp'),
+	maek.CPP('WorkerPool.cpp'),
+	maek.CPP('WalkMesh.cpp'), //Locomotion walks over it
+	maek.CPP('Locomotion.cpp'),
 ];
 
 const show_meshes_names = [
@@ -174,16 +181,61 @@ const show_scene_names = [
 	maek.CPP('ShowSceneMode.cpp')
 ];
 
+//tests are plain executables that print what they checked and exit non-zero on a failure:
+const test_ai_names = [
+	maek.CPP('test-ai.cpp')
+];
+
+const test_collisions_names = [
+	maek.CPP('test-collisions.cpp')
+];
+
+//benches just print timings, they're not in the default targets (build them by name, e.g. 'node Maekfile.js tests/bench-collisions'):
+const bench_collisions_names = [
+	maek.CPP('bench-collisions.cpp')
+];
+
+const bench_scene_names = [
+	maek.CPP('bench-scene.cpp')
+];
+
+const bench_walkmesh_names = [
+	maek.CPP('bench-walkmesh.cpp')
+];
+
+const bench_ecs_names = [
+	maek.CPP('bench-ecs.cpp')
+];
+
+const bench_ai_names = [
+	maek.CPP('bench-ai.cpp')
+];
+
+//bench-draw swaps in a do-nothing GL (null-GL.cpp), which needs the GL entry points to be plain functions, so not on windows:
+const bench_draw_names = (maek.OS === 'windows' ? [] : [
+	maek.CPP('bench-draw.cpp'),
+	maek.CPP('null-GL.cpp')
+]);
+
 //the '[exeFile =] LINK(objFiles, exeFileBase, [, options])' links an array of objects into an executable:
 // objFiles: array of objects to link
 // exeFileBase: name of executable file to produce
 //returns exeFile: exeFileBase + a platform-dependant suffix (e.g., '.exe' on windows)
-const game_exe = maek.LINK([...game_names, ...common_names], 'dist/game');
+const game_exe = maek.LINK([...game_names, ...ai_names, ...common_names], 'dist/game');
 const show_meshes_exe = maek.LINK([...show_meshes_names, ...common_names], 'scenes/show-meshes');
 const show_scene_exe = maek.LINK([...show_scene_names, ...common_names], 'scenes/show-scene');
+const test_ai_exe = maek.LINK([...test_ai_names, ...ai_names, ...common_names], 'tests/test-ai');
+const test_collisions_exe = maek.LINK([...test_collisions_names, ...common_names], 'tests/test-collisions');
+const bench_collisions_exe = maek.LINK([...bench_collisions_names, ...common_names], 'tests/bench-collisions');
+const bench_scene_exe = maek.LINK([...bench_scene_names, ...common_names], 'tests/bench-scene');
+const bench_walkmesh_exe = maek.LINK([...bench_walkmesh_names, ...common_names], 'tests/bench-walkmesh');
+const bench_ecs_exe = maek.LINK([...bench_ecs_names, ...common_names], 'tests/bench-ecs');
+const bench_ai_exe = maek.LINK([...bench_ai_names, ...ai_names, ...common_names], 'tests/bench-ai');
+const bench_draw_exe = (maek.OS === 'windows' ? null : maek.LINK([...bench_draw_names, ...common_names], 'tests/bench-draw'));
 
 //set the default target to the game (and copy the readme files):
-maek.TARGETS = [game_exe, show_meshes_exe, show_scene_exe, ...copies];
+// (tests get built too, run them from tests/)
+maek.TARGETS = [game_exe, show_meshes_exe, show_scene_exe, test_ai_exe, test_collisions_exe, ...copies];
 
 //Note that tasks that produce ':abstract targets' are never cached.
 // This is similar to how .PHONY targets behave in make.
@@ -1,5 +1,6 @@
 #include "Mesh.hpp"
 #include "read_write_chunk.hpp"
+#include "Scene.hpp"
 
 #include <glm/glm.hpp>
 
@@ -106,7 +107,7 @@ const Mesh &MeshBuffer::lookup(std::string const &name) const {
 	return f->second;
 }
 
-GLuint MeshBuffer::make_vao_for_program(GLuint program) const {
+GLuint MeshBuffer::make_vao_for_program(GLuint program, GLuint instance_buffer) const {
 	//create a new vertex array object:
 	GLuint vao = 0;
 	glGenVertexArrays(1, &vao);
@@ -127,6 +128,25 @@ GLuint MeshBuffer::make_vao_for_program(GLuint program) const {
 	bind_attribute("Normal", Normal);
 	bind_attribute("Color", Color);
 	bind_attribute("TexCoord", TexCoord);
+
+	//Per-instance matrices are bound one column at a time, each column advancing once per instance:
+	if (instance_buffer != 0) {
+		glBindBuffer(GL_ARRAY_BUFFER, instance_buffer);
+		auto bind_instance_matrix = [&](char const *name, GLint columns, GLint rows, GLsizei offset) {
+			GLint location = glGetAttribLocation(program, name);
+			if (location == -1) return; //can't bind missing attribs
+			for (GLint c = 0; c < columns; ++c) {
+				glVertexAttribPointer(location + c, rows, GL_FLOAT, GL_FALSE, sizeof(Scene::Instance), (GLbyte *)0 + offset + c * rows * sizeof(float));
+				glEnableVertexAttribArray(location + c);
+				glVertexAttribDivisor(location + c, 1);
+			}
+			bound.insert(location);
+		};
+		bind_instance_matrix("ObjectToClip", 4, 4, offsetof(Scene::Instance, object_to_clip));
+		bind_instance_matrix("ObjectToLight", 4, 3, offsetof(Scene::Instance, object_to_light));
+		bind_instance_matrix("NormalToLight", 3, 3, offsetof(Scene::Instance, normal_to_light));
+	}
+
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindVertexArray(0);
 
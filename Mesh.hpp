@@ -40,7 +40,9 @@ struct MeshBuffer {
 	
 	//build a vertex array object that links this vbo to attributes to a program:
 	// note: will throw if program defines attributes not contained in this buffer
-	GLuint make_vao_for_program(GLuint program) const;
+	// if instance_buffer is given, also links the per-instance "ObjectToClip", "ObjectToLight", and "NormalToLight"
+	//  attributes to that buffer (laid out as Scene::Instance), for use with instanced pipelines
+	GLuint make_vao_for_program(GLuint program, GLuint instance_buffer = 0) const;
 
 	//This is the OpenGL vertex buffer object containing the mesh data:
 	GLuint buffer = 0;
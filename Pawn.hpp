@@ -3,9 +3,11 @@
 
 #include "Game.hpp"
 #include "Collisions.hpp"
-#include <list>
-
-class BehaviorTree;
+#include "ECS.hpp"
+#include "Locomotion.hpp"
+#include "BT.hpp"
+#include <algorithm>
+#include <vector>
 
 struct PawnControl
 {
@@ -54,7 +56,7 @@ struct PawnControl
 
 struct Pawn : public Game::Creature
 {
-	Pawn() { recentHitters.clear(); };
+	Pawn() {};
 	virtual ~Pawn() {};
 
 	void update(float elapsed) override {};
@@ -80,10 +82,6 @@ struct Pawn : public Game::Creature
 	float hp;
 	float maxhp;
 
-	float stamina;
-	float maxstamina;
-	float staminaRegenRate = 0.0f;
-
 	CollisionEngine::ID swordCollider;
 	CollisionEngine::ID bodyCollider;
 
@@ -93,22 +91,52 @@ struct Pawn : public Game::Creature
 
 	float swordDamage = 1.0f; // This is how much damage we do to others
 
-	struct RecentHitter
+	// Stamina, sword hits, AI and walking state live in components on this entity (see below)
+	ECS::Entity entity;
+};
+
+// ----- Components -----
+// These are the parts of a pawn that get a pass every update, so they're packed together per type instead of
+// spread out over the pawns. Systems that go over them are set up in PlayMode::setupSystems
+
+struct Stamina
+{
+	float current = 100.0f;
+	float max = 100.0f;
+	float regenRate = 0.0f; // Per second
+};
+
+// Swords touching this pawn that already did their damage, so each sword hits once per contact
+// The collision engine's END for that contact takes it off again
+struct SwordHits
+{
+	bool alreadyHitBy(Scene::Transform const* sword) const
 	{
-		RecentHitter(float tl, Scene::Transform* tf) : timeLeft(tl), hitter(tf) {};
-		
-		float timeLeft = 0.0f;
-		Scene::Transform* hitter = nullptr;
-	};
-	
-	std::list<RecentHitter> recentHitters;
-	float hitInvulnTime = 1.0f; // On a per enemy basis
+		return std::find(swords.begin(), swords.end(), sword) != swords.end();
+	}
+
+	void contactEnded(Scene::Transform const* sword)
+	{
+		swords.erase(std::remove(swords.begin(), swords.end(), sword), swords.end());
+	}
+
+	std::vector<Scene::Transform const*> swords;
 };
 
-struct Enemy : public Pawn
+// Pawns that think for themselves
+struct Brain
 {
-	BehaviorTree* bt;
+	BT::Agent ai;
+};
 
+// Back to the pawn, for systems that still need the rest of it
+struct PawnRef
+{
+	Pawn* pawn = nullptr;
+};
+
+struct Enemy : public Pawn
+{
 	bool flagToBreakSword = false;
 	int type = 0;
 	float previous_sword_clang_time = 0.0f;
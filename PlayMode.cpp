@@ -15,7 +15,6 @@
 #include <glm/gtx/quaternion.hpp>
 
 #include <random>
-#include "BehaviorTree.hpp"
 
 #include "load_save_png.hpp"
 #include "data_path.hpp"
@@ -23,6 +22,7 @@
 #define M_PI_2f 1.57079632679489661923f
 
 GLuint G_LIT_COLOR_TEXTURE_PROGRAM_VAO = 0;
+GLuint G_LIT_COLOR_TEXTURE_PROGRAM_INSTANCED_VAO = 0;
 
 // Contains all the meshes for the scene
 Load<MeshBuffer> G_MESHES(LoadTagDefault,
@@ -31,6 +31,7 @@ Load<MeshBuffer> G_MESHES(LoadTagDefault,
 		MeshBuffer const* ret = new MeshBuffer(data_path("sword.pnct"));
 		// If we add more shader programs, we're going to need to make VAOs for them as well here
 		G_LIT_COLOR_TEXTURE_PROGRAM_VAO = ret->make_vao_for_program(lit_color_texture_program->program);
+		G_LIT_COLOR_TEXTURE_PROGRAM_INSTANCED_VAO = ret->make_vao_for_program(lit_color_texture_program->instanced_program, lit_color_texture_program->instance_buffer);
 		return ret;
 	});
 
@@ -215,6 +216,7 @@ Load<Scene> G_SCENE(LoadTagDefault,
 
 				drawable.pipeline = lit_color_texture_program_pipeline;
 				drawable.pipeline.vao = G_LIT_COLOR_TEXTURE_PROGRAM_VAO;
+				drawable.pipeline.instancing.vao = G_LIT_COLOR_TEXTURE_PROGRAM_INSTANCED_VAO;
 				drawable.pipeline.type = mesh.type;
 				drawable.pipeline.start = mesh.start;
 				drawable.pipeline.count = mesh.count;
@@ -301,22 +303,21 @@ void PlayMode::setupEnemy(Game::CreatureID myEnemyID, glm::vec3 pos, float maxhp
 	// Customize
 	enemy->hp = maxhp;
 	enemy->maxhp = maxhp;
-	enemy->stamina = 100.0f;
-	enemy->maxstamina = 100.0f;
-	enemy->staminaRegenRate = 10.0f;
 	enemy->is_player = false;
 	enemy->type = type;
 
 	enemy->swordDamage = 7.5f;
-	enemy->walkCollRad = 1.0f;
-	enemy->hitInvulnTime = 0.3f;
 
-	enemy->bt=new BehaviorTree();
-	enemy->bt->Init();//AI Initialize
-	enemy->bt->SetEnemy(enemy);
-	enemy->bt->SetPlayer(player);
-	enemy->bt->SetEnemyType(type); // Customize
-	enemy->bt->InitInterrupt();
+	// Boss parries, soldiers just swing
+	BT::Agent ai(type == 0 ? &BT::Tree::boss() : &BT::Tree::soldier(), type);
+
+	// Entity is keyed by the feet transform, like the player
+	enemy->entity = world.spawn(enemy->transform);
+	world.add(enemy->entity, PawnRef{enemy});
+	world.add(enemy->entity, Stamina{100.0f, 100.0f, 10.0f});
+	world.add(enemy->entity, SwordHits());
+	world.add(enemy->entity, Brain{ai});
+	world.add(enemy->entity, Locomotion::Walker());
 
 	enemy->body_transform->position = pos; // CUSTOMIZE
 	
@@ -327,9 +328,9 @@ void PlayMode::setupEnemy(Game::CreatureID myEnemyID, glm::vec3 pos, float maxhp
 	enemy->transform->position = worldPoint;
 	enemy->default_rotation = glm::angleAxis(glm::radians(180.0f), glm::vec3(0.0f, 0.0f, 1.0f)); //dictates enemy's original rotation wrt +x
 
-	auto enemySwordHit = [this, myEnemyID](Game::CreatureID c, Scene::Transform* t) -> void
+	auto enemySwordHit = [this, myEnemyID](CollisionEvent const& e) -> void
 		{
-			if(t == player->sword_transform)
+			if(e.phase != CollisionEvent::END && e.otherTransform == player->sword_transform)
 			{
 				if(player->pawn_control.stance == 4)
 				{
@@ -372,9 +373,17 @@ void PlayMode::setupEnemy(Game::CreatureID myEnemyID, glm::vec3 pos, float maxhp
 				}
 			}
 		};
-	auto enemyHit = [this, myEnemyID](Game::CreatureID c, Scene::Transform* t) -> void
+	auto enemyHit = [this, myEnemyID](CollisionEvent const& e) -> void
 		{
-			if(t == player->sword_transform)
+			if(e.otherLayer == CollisionEngine::Layer::PLAYER_BODY_LAYER || e.otherLayer == CollisionEngine::Layer::ENEMY_BODY_LAYER)
+			{
+				if(e.phase != CollisionEvent::END)
+				{
+					addBodyContact(myEnemyID, e.contact);
+				}
+				return;
+			}
+			if(e.otherTransform == player->sword_transform)
 			{
 				Enemy* enemyPtr = static_cast<Enemy*>(game.getCreature(myEnemyID));
 						
@@ -384,21 +393,34 @@ void PlayMode::setupEnemy(Game::CreatureID myEnemyID, glm::vec3 pos, float maxhp
 					return;
 				}
 
+				SwordHits* hits = world.get<SwordHits>(enemyPtr->entity);
+				if(!hits)
+				{
+					return;
+				}
+				if(e.phase == CollisionEvent::END)
+				{
+					hits->contactEnded(player->sword_transform);
+					return;
+				}
 
 				if(player->pawn_control.stance == 1 || player->pawn_control.stance == 7 || player->pawn_control.stance == 9)
 				{
-					if(std::find_if(enemyPtr->recentHitters.begin(), enemyPtr->recentHitters.end(),
-									 [this](Pawn::RecentHitter& rh) -> bool { return rh.hitter == player->sword_transform; }) == enemyPtr->recentHitters.end())
+					if(!hits->alreadyHitBy(player->sword_transform))
 					{
 						enemyPtr->hp -= player->swordDamage;
-						enemyPtr->recentHitters.push_front(Pawn::RecentHitter(enemyPtr->hitInvulnTime, player->sword_transform));
+						hits->swords.push_back(player->sword_transform);
+						if(Brain* brain = world.get<Brain>(enemyPtr->entity))
+						{
+							brain->ai.tookHit = true;
+						}
 						DEBUGOUT << "ENEMY HIT WITH SWORD while player was in stance " << player->pawn_control.stance << std::endl;
 					}
 				}
 			}
 		};
 
-	enemy->swordCollider = collEng.registerCollider(myEnemyID, enemy->sword_transform, enemySwordCollMesh, enemySwordCollMesh->containingRadius, enemySwordHit, CollisionEngine::Layer::ENEMY_SWORD_LAYER);
+	enemy->swordCollider = collEng.registerCollider(myEnemyID, enemy->sword_transform, enemySwordCollMesh, enemySwordCollMesh->containingRadius, enemySwordHit, CollisionEngine::Layer::ENEMY_SWORD_LAYER, true);
 	enemy->bodyCollider = collEng.registerCollider(myEnemyID, enemy->body_transform, enemyCollMesh, enemyCollMesh->containingRadius, enemyHit, CollisionEngine::Layer::ENEMY_BODY_LAYER);
 
 	auto enemyHpBarCalculate = [this, myEnemyID](float elapsed) -> float
@@ -411,13 +433,14 @@ void PlayMode::setupEnemy(Game::CreatureID myEnemyID, glm::vec3 pos, float maxhp
 			return 0.0f;
 		};
 
-	auto* enemyHpBar = new Gui::Bar(enemyHpBarCalculate, *heart_tex, -0.095f, 1.095f);
+	auto* enemyHpBar = new Gui::WorldBar(enemyHpBarCalculate, *heart_tex, -0.095f, 1.095f);
 	enemyHpBar->scale = glm::vec2(0.05f, 0.08f);
 	enemyHpBar->alpha = 0.5f;
 	enemyHpBar->fullColor = glm::vec3(0.0f, 1.0f, 0.0f);
 	enemyHpBar->emptyColor = glm::vec3(1.0f, 0.0f, 0.0f);
-	enemyHpBar->useCreatureID = true;
-	enemyHpBar->creatureIDForPos = myEnemyID;
+	enemyHpBar->anchor = enemy->body_transform; // Shader projects this, bar goes away with the enemy in update
+	enemyHpBar->anchorOffset = glm::vec3(0.0f, 0.0f, 2.0f);
+	enemyHpBar->creatureID = myEnemyID;
 			
 	enemyHpBars.push_back(gui.addElement(enemyHpBar));
 
@@ -430,6 +453,7 @@ void PlayMode::setupEnemy(Game::CreatureID myEnemyID, glm::vec3 pos, float maxhp
 
 			drawable.pipeline = lit_color_texture_program_pipeline;
 			drawable.pipeline.vao = G_LIT_COLOR_TEXTURE_PROGRAM_VAO;
+			drawable.pipeline.instancing.vao = G_LIT_COLOR_TEXTURE_PROGRAM_INSTANCED_VAO;
 			drawable.pipeline.type = mesh.type;
 			drawable.pipeline.start = mesh.start;
 			drawable.pipeline.count = mesh.count;
@@ -459,6 +483,8 @@ void PlayMode::swapEnemyToBrokenSword(Game::CreatureID myEnemyID)
 		};
 	scene.drawables.remove_if(pertainsToEnemySword);
 	collEng.unregisterCollider(enemy->swordCollider);
+	// Unregistering doesn't send END, so whoever the old sword was in needs telling
+	world.each<SwordHits>([enemy](ECS::Entity, SwordHits& hits) { hits.contactEnded(enemy->sword_transform); });
 
 	auto addDrawable = [this](Scene::Transform* tform, std::string mesh_name) -> void
 		{
@@ -469,6 +495,7 @@ void PlayMode::swapEnemyToBrokenSword(Game::CreatureID myEnemyID)
 
 			drawable.pipeline = lit_color_texture_program_pipeline;
 			drawable.pipeline.vao = G_LIT_COLOR_TEXTURE_PROGRAM_VAO;
+			drawable.pipeline.instancing.vao = G_LIT_COLOR_TEXTURE_PROGRAM_INSTANCED_VAO;
 			drawable.pipeline.type = mesh.type;
 			drawable.pipeline.start = mesh.start;
 			drawable.pipeline.count = mesh.count;
@@ -477,9 +504,9 @@ void PlayMode::swapEnemyToBrokenSword(Game::CreatureID myEnemyID)
 	//addDrawable(enemy->sword_transform, "Player" + enemyPresets[enemy->type].postfix); // SWAP ME
 	 addDrawable(enemy->sword_transform, "Sword_Broken" + enemyPresets[enemy->type].postfix); 
 
-	auto enemySwordHit = [this, myEnemyID](Game::CreatureID c, Scene::Transform* t) -> void
+	auto enemySwordHit = [this, myEnemyID](CollisionEvent const& e) -> void
 		{
-			if(t == player->sword_transform)
+			if(e.phase != CollisionEvent::END && e.otherTransform == player->sword_transform)
 			{
 				if(player->pawn_control.stance == 4)
 				{
@@ -520,14 +547,20 @@ void PlayMode::swapEnemyToBrokenSword(Game::CreatureID myEnemyID)
 			}
 		};
 	
-	enemy->swordCollider = collEng.registerCollider(myEnemyID, enemy->sword_transform, enemySwordBrokenCollMesh, enemySwordBrokenCollMesh->containingRadius, enemySwordHit, CollisionEngine::Layer::ENEMY_SWORD_LAYER);
+	enemy->swordCollider = collEng.registerCollider(myEnemyID, enemy->sword_transform, enemySwordBrokenCollMesh, enemySwordBrokenCollMesh->containingRadius, enemySwordHit, CollisionEngine::Layer::ENEMY_SWORD_LAYER, true);
 }
 
 // Right now, this makes a proper fully copy of the scene, which is fine, but
 // there's no reason to keep the global scene around if we're only using it
 // like this. Unsure what to do.
-PlayMode::PlayMode() : scene(*G_SCENE)
+PlayMode::PlayMode() : scene(*G_SCENE), collEng(workers)
 {
+	// Sort + instance drawables, every enemy shares the same handful of meshes
+	scene.render_queue = true;
+
+	// Sliding off contacts needs enemy bodies to report touching each other, the spatial hash doesn't
+	collEng.LayerMatrix[CollisionEngine::Layer::ENEMY_BODY_LAYER][CollisionEngine::Layer::ENEMY_BODY_LAYER] = (separation == Locomotion::Separation::CONTACTS);
+
 	for(size_t i = 0; i < enemyPresets.size(); i++)
 	{
 		enemyPresets[i].postfix = ".00" + std::to_string(i + 1);
@@ -591,13 +624,14 @@ PlayMode::PlayMode() : scene(*G_SCENE)
 	player->is_player = true;
 	player->hp = 100.0f;
 	player->maxhp = 100.0f;
-	player->stamina = 100.0f;
-	player->maxstamina = 100.0f;
-	player->staminaRegenRate = 10.0f;
 
-	player->walkCollRad = 1.0f;
 	player->swordDamage = 34.0f;
-	player->hitInvulnTime = 0.3f;
+
+	player->entity = world.spawn(player->transform);
+	world.add(player->entity, PawnRef{player});
+	world.add(player->entity, Stamina{100.0f, 100.0f, 10.0f});
+	world.add(player->entity, SwordHits());
+	world.add(player->entity, Locomotion::Walker());
 
 	// TODO This should probably be done by setting the camera to match the properties from the blender camera but this is OK
 	if (scene.cameras.size() != 1) throw std::runtime_error("Expecting scene to have exactly one camera, but it has " + std::to_string(scene.cameras.size()));
@@ -635,69 +669,90 @@ PlayMode::PlayMode() : scene(*G_SCENE)
 		enemyCollMesh = &G_COLLIDEMESHES->lookup("EnemyCollMesh");
 		playerCollMesh = &G_COLLIDEMESHES->lookup("PlayerCollMesh");
 	
-		auto playerSwordHit = [this](Game::CreatureID c, Scene::Transform* t) -> void
+		auto playerSwordHit = [this](CollisionEvent const& e) -> void
 			{
-				for(Game::CreatureID enemyID : enemiesId)
+				if(e.phase == CollisionEvent::END || e.otherLayer != CollisionEngine::Layer::ENEMY_SWORD_LAYER)
 				{
-					Enemy* enemyPtr = static_cast<Enemy*>(game.getCreature(enemyID));
-					
-					if(t == enemyPtr->sword_transform)
-					{
-						if(player->pawn_control.stance == 1)
-						{
-							player->pawn_control.stance = 2;
-							player->pawn_control.swingHit = player->pawn_control.swingTime;
-						}
-						else if(player->pawn_control.stance == 9)
-						{
-							player->pawn_control.stance = 10;
-							player->pawn_control.swingHit = player->pawn_control.swingTime;
-						}
-						
-						// sound stuff starts here:
-						float current_time = (float)clock();
-						float elapsed = current_time - enemyPtr->previous_sword_clang_time;
-						std::cout << "time since this enemy's sword last hit: " << elapsed << std::endl;
-
-						if ((elapsed / CLOCKS_PER_SEC) > min_enemy_sword_clang_interval){
-							w_conv1_sound = Sound::play(*w_conv1, 1.0f, 0.0f);
-							enemyPtr->previous_sword_clang_time = current_time;
-							
-						}
-						// sound stuff ends here
+					return;
+				}
+				Enemy* enemyPtr = static_cast<Enemy*>(game.getCreature(e.other));
+				if(!enemyPtr)
+				{
+					DEBUGOUT << "Enemy no longer exists on playerSwordHit!" << std::endl;
+					return;
+				}
 
-						
+				if(player->pawn_control.stance == 1)
+				{
+					player->pawn_control.stance = 2;
+					player->pawn_control.swingHit = player->pawn_control.swingTime;
+				}
+				else if(player->pawn_control.stance == 9)
+				{
+					player->pawn_control.stance = 10;
+					player->pawn_control.swingHit = player->pawn_control.swingTime;
+				}
+				
+				// sound stuff starts here:
+				float current_time = (float)clock();
+				float elapsed = current_time - enemyPtr->previous_sword_clang_time;
+				std::cout << "time since this enemy's sword last hit: " << elapsed << std::endl;
 
-						return;
-					}
+				if ((elapsed / CLOCKS_PER_SEC) > min_enemy_sword_clang_interval){
+					w_conv1_sound = Sound::play(*w_conv1, 1.0f, 0.0f);
+					enemyPtr->previous_sword_clang_time = current_time;
+					
 				}
+				// sound stuff ends here
 			};
 
 
-		auto playerHit = [this](Game::CreatureID c, Scene::Transform* t) -> void
+		auto playerHit = [this](CollisionEvent const& e) -> void
 			{	
-				for(Game::CreatureID enemyID : enemiesId)
+				if(e.otherLayer == CollisionEngine::Layer::ENEMY_BODY_LAYER)
 				{
-					Enemy* enemyPtr = static_cast<Enemy*>(game.getCreature(enemyID));
-					
-					if(t == enemyPtr->sword_transform &&
-					   (std::find_if(player->recentHitters.begin(), player->recentHitters.end(),
-									 [enemyPtr](Pawn::RecentHitter& rh) -> bool { return rh.hitter == enemyPtr->sword_transform; }) == player->recentHitters.end()))
+					if(e.phase != CollisionEvent::END)
 					{
-						if(enemyPtr->pawn_control.stance == 1 || enemyPtr->pawn_control.stance == 7 || enemyPtr->pawn_control.stance == 9)
-						{
-							// Could add damage based on stance (best done by actually having a table inside each pawn that says
-							// how much damage it does in each stance).
-							// Generalize stances to moves?
-							player->hp -= enemyPtr->swordDamage;
-							player->recentHitters.push_back(Pawn::RecentHitter(player->hitInvulnTime, enemyPtr->sword_transform));
-							DEBUGOUT << "Player hit with sword while enemy was in stance " << enemyPtr->pawn_control.stance << std::endl;
-						}
+						addBodyContact(plyr, e.contact);
+					}
+					return;
+				}
+				if(e.otherLayer != CollisionEngine::Layer::ENEMY_SWORD_LAYER)
+				{
+					return;
+				}
+				SwordHits* hits = world.get<SwordHits>(player->entity);
+				if(!hits)
+				{
+					return;
+				}
+				if(e.phase == CollisionEvent::END)
+				{
+					hits->contactEnded(e.otherTransform);
+					return;
+				}
+				Enemy* enemyPtr = static_cast<Enemy*>(game.getCreature(e.other));
+				if(!enemyPtr)
+				{
+					DEBUGOUT << "Enemy no longer exists on playerHit!" << std::endl;
+					return;
+				}
+
+				if(!hits->alreadyHitBy(enemyPtr->sword_transform))
+				{
+					if(enemyPtr->pawn_control.stance == 1 || enemyPtr->pawn_control.stance == 7 || enemyPtr->pawn_control.stance == 9)
+					{
+						// Could add damage based on stance (best done by actually having a table inside each pawn that says
+						// how much damage it does in each stance).
+						// Generalize stances to moves?
+						player->hp -= enemyPtr->swordDamage;
+						hits->swords.push_back(enemyPtr->sword_transform);
+						DEBUGOUT << "Player hit with sword while enemy was in stance " << enemyPtr->pawn_control.stance << std::endl;
 					}
 				}
 			};
 	
-		player->swordCollider = collEng.registerCollider(plyr, player->sword_transform, playerSwordCollMesh, playerSwordCollMesh->containingRadius, playerSwordHit, CollisionEngine::Layer::PLAYER_SWORD_LAYER);
+		player->swordCollider = collEng.registerCollider(plyr, player->sword_transform, playerSwordCollMesh, playerSwordCollMesh->containingRadius, playerSwordHit, CollisionEngine::Layer::PLAYER_SWORD_LAYER, true);
 		player->bodyCollider = collEng.registerCollider(plyr, player->body_transform, playerCollMesh, playerCollMesh->containingRadius, playerHit, CollisionEngine::Layer::PLAYER_BODY_LAYER);
 	}
 
@@ -723,9 +778,10 @@ PlayMode::PlayMode() : scene(*G_SCENE)
 		auto playerStamBarCalculate = [this](float elapsed) -> float
 			{
 				Pawn* p = static_cast<Pawn*>(game.getCreature(plyr));
-				if(p)
+				Stamina* stamina = p ? world.get<Stamina>(p->entity) : nullptr;
+				if(stamina)
 				{
-					return (float)p->stamina / (float)p->maxstamina;
+					return stamina->current / stamina->max;
 				}
 				return 0.0f;
 			};
@@ -795,6 +851,45 @@ PlayMode::PlayMode() : scene(*G_SCENE)
 	prompts.push(Prompt("with nothing but a sword in hand.", 3.0f));
 	prompts.push(Prompt("Your instincts tell you...", 5.0f));
 	prompts.push(Prompt("to move forward and defeat all enemies you find!", 5.0f));
+
+	setupSystems();
+}
+
+void PlayMode::setupSystems()
+{
+	// Run in this order every update, after input has been read into the player's control
+
+	systems.add("stamina", [](ECS::World& w, float elapsed)
+		{
+			w.each<Stamina>([elapsed](ECS::Entity, Stamina& stamina)
+				{
+					stamina.current = std::min(stamina.current + stamina.regenRate * elapsed, stamina.max);
+				});
+		});
+
+	systems.add("ai", [this](ECS::World& w, float elapsed)
+		{
+			think();
+		});
+
+	// Works out how far everyone wants to go, the player stays put (but still in the way) once the game is over
+	systems.add("control", [this](ECS::World& w, float elapsed)
+		{
+			w.each<Locomotion::Walker, PawnRef>([this, elapsed](ECS::Entity, Locomotion::Walker& walker, PawnRef& ref)
+				{
+					Pawn& pawn = *ref.pawn;
+					walker.position = pawn.transform->position;
+					walker.radius = pawn.walkCollRad;
+					walker.at = pawn.at;
+					walker.obstacleOnly = pawn.is_player && is_game_over;
+					walker.move = walker.obstacleOnly ? glm::vec3(0.0f) : processPawnControl(pawn, elapsed);
+				});
+		});
+
+	systems.add("locomotion", [this](ECS::World& w, float elapsed)
+		{
+			walk_pawns();
+		});
 }
 
 PlayMode::~PlayMode()
@@ -912,7 +1007,8 @@ bool PlayMode::handle_event(SDL_Event const &evt, glm::uvec2 const &window_size)
 			}*/
 
 			glm::vec3 upDir = walkmesh->to_world_smooth_normal(player->at);
-			player->transform->rotation = glm::angleAxis(-motion.x * player->camera->fovy, upDir) * player->transform->rotation;
+			glm::quat yaw = glm::angleAxis(-motion.x * player->camera->fovy, upDir);
+			player->transform->rotation = yaw * player->transform->rotation;
 
 			float pitch = glm::pitch(player->camera->transform->rotation);
 			pitch += motion.y * player->camera->fovy;
@@ -944,6 +1040,16 @@ bool PlayMode::handle_event(SDL_Event const &evt, glm::uvec2 const &window_size)
 
 			player->camera->transform->position = newlocal;
 
+			// Looking around should show up on the next frame, not get blended in over the next step
+			if(TransformState* from = previous_state(player->transform))
+			{
+				from->rotation = yaw * from->rotation;
+			}
+			if(TransformState* from = previous_state(player->camera->transform))
+			{
+				from->position = player->camera->transform->position;
+				from->rotation = player->camera->transform->rotation;
+			}
 			return true;
 		}
 	}
@@ -951,9 +1057,10 @@ bool PlayMode::handle_event(SDL_Event const &evt, glm::uvec2 const &window_size)
 	return false;
 }
 
-void PlayMode::processPawnControl(Pawn& pawn, float elapsed)
+glm::vec3 PlayMode::processPawnControl(Pawn& pawn, float elapsed)
 {	
 	// Control& control = pawn.pawn_control;
+	Stamina& stamina = *world.get<Stamina>(pawn.entity);
 
 	glm::vec3 movement = glm::vec3(0.0f);
 
@@ -999,7 +1106,7 @@ void PlayMode::processPawnControl(Pawn& pawn, float elapsed)
 			pawn.wrist_transform->rotation = glm::angleAxis(0.0f, glm::vec3(0.0f, 1.0f, 0.0f));
 			if(pawn.pawn_control.attack)
 			{
-				if(pawn.is_player && pawn.stamina <= 10.0f)
+				if(pawn.is_player && stamina.current <= 10.0f)
 				{
 					DEBUGOUT << "Player doesn't have enough stamina to attack" << std::endl;
 				}
@@ -1011,12 +1118,12 @@ void PlayMode::processPawnControl(Pawn& pawn, float elapsed)
 
 					if(pawn.pawn_control.attack==1){// Here you can change whether the pawn is casting vertical(stance=1) or horizontal(stance=9)
 						stance = 1;
-						pawn.stamina -= 10.0f;
+						stamina.current -= 10.0f;
 						pawn.pawn_control.attack=0;
 					}
 					if(pawn.pawn_control.attack==2){
 						stance = 9;
-						pawn.stamina -= 10.0f;
+						stamina.current -= 10.0f;
 						pawn.pawn_control.attack=0;
 					}
 
@@ -1025,7 +1132,7 @@ void PlayMode::processPawnControl(Pawn& pawn, float elapsed)
 			}
 			else if (pawn.pawn_control.parry)
 			{
-				if(pawn.is_player && pawn.stamina <= 20.0f)
+				if(pawn.is_player && stamina.current <= 20.0f)
 				{
 					DEBUGOUT << "Player doesn't have enough stamina to parry" << std::endl;
 				}
@@ -1036,12 +1143,12 @@ void PlayMode::processPawnControl(Pawn& pawn, float elapsed)
 					stance = 4;
 					pawn.pawn_control.parry=0;
 
-					pawn.stamina -= 20.0f;
+					stamina.current -= 20.0f;
 				}
 			}
 			else if(pawn.pawn_control.dodge)
 			{
-				if(pawn.is_player && pawn.stamina <= 15.0f)
+				if(pawn.is_player && stamina.current <= 15.0f)
 				{
 					DEBUGOUT << "Player doesn't have enough stamina to dodge" << std::endl;
 				}
@@ -1054,7 +1161,7 @@ void PlayMode::processPawnControl(Pawn& pawn, float elapsed)
 						pawn.pawn_control.stanceInfo.dodge.dir = glm::normalize(pawn.pawn_control.move);
 						pawn.pawn_control.stanceInfo.dodge.attackAfter = 0;
 
-						pawn.stamina -= 15.0f;
+						stamina.current -= 15.0f;
 					}
 				
 					pawn.pawn_control.dodge = 0;
@@ -1250,7 +1357,7 @@ void PlayMode::processPawnControl(Pawn& pawn, float elapsed)
 				st = 0.0f;
 				if(pawn.pawn_control.stanceInfo.dodge.attackAfter)
 				{
-					if(pawn.is_player && pawn.stamina <= 20.0f)
+					if(pawn.is_player && stamina.current <= 20.0f)
 					{
 						DEBUGOUT << "Player doesn't have enough stamina to lunge" << std::endl;
 						stance = 0;
@@ -1260,7 +1367,7 @@ void PlayMode::processPawnControl(Pawn& pawn, float elapsed)
 						pawn.pawn_control.stanceInfo.lunge.dir = pawn.pawn_control.stanceInfo.dodge.dir;
 						stance = 7;
 
-						pawn.stamina -= 20.0f;
+						stamina.current -= 20.0f;
 					}
 				}
 				else
@@ -1405,115 +1512,202 @@ void PlayMode::processPawnControl(Pawn& pawn, float elapsed)
 		}
 	}
 
-	walk_pawn(pawn, movement);
+	return movement;
 }
 
-void PlayMode::walk_pawn(Pawn& pawn, glm::vec3 movement)
+void PlayMode::addBodyContact(Game::CreatureID id, Contact const& contact)
 {
-	glm::vec3 remain = movement;
+	if(separation != Locomotion::Separation::CONTACTS)
+	{
+		return;
+	}
+	Pawn* pawn = static_cast<Pawn*>(game.getCreature(id));
+	if(!pawn)
+	{
+		return;
+	}
+	Locomotion::Walker* walker = world.get<Locomotion::Walker>(pawn->entity);
+	if(walker)
+	{
+		walker->contacts.push_back(contact.normal);
+	}
+}
 
-	for(Game::CreatureID enemyID : enemiesId)
+void PlayMode::think()
+{
+	// Gather where every thinker stands, sense for all of them at once, let them all decide on the workers, then hand
+	// the decisions to the pawns back here
+	ECS::Pool<Brain>& pool = world.pool<Brain>();
+	std::vector<Brain>& brains = pool.data;
+
+	std::vector<Pawn*> thinkingPawns(brains.size(), nullptr);
+	std::vector<BT::Agent*> agents(brains.size(), nullptr);
+	crowd.clear();
+	for(size_t i = 0; i < brains.size(); i++)
 	{
-		Enemy* enemyPtr = static_cast<Enemy*>(game.getCreature(enemyID));
-		if(enemyPtr && (enemyPtr != &pawn))
+		PawnRef* ref = world.get<PawnRef>(pool.entities[i]);
+		thinkingPawns[i] = ref ? ref->pawn : nullptr;
+		agents[i] = ref ? &brains[i].ai : nullptr;
+		if(thinkingPawns[i])
 		{
-			glm::vec3 toOther = enemyPtr->transform->position - pawn.transform->position;
-			float toOtherLength = glm::length(toOther);
-			if(toOtherLength < (enemyPtr->walkCollRad + pawn.walkCollRad))
-			{
-				float remainLength = glm::length(remain);
-				if(remainLength * toOtherLength > 0.0001f)
-				{
-					remain = remain - remain * glm::dot(toOther / toOtherLength, remain / remainLength);
-				}
-			}
+			crowd.add(thinkingPawns[i]->transform->position);
 		}
+		else
+		{
+			crowd.add(glm::vec3(0.0f), false); // Keeps the crowd lined up with agents, but nobody's standing there
+		}
+	}
+
+	bool hasPlayer = (player != nullptr);
+	bool playerAttacking = hasPlayer && player->gameplay_tags == "attack";
+	if(hasPlayer)
+	{
+		crowd.sense(player->transform->position, workers);
+	}
+
+	BT::think(crowd, agents, hasPlayer, playerAttacking, simClock, workers, reactiveAI);// AI Thinking
+
+	for(size_t i = 0; i < brains.size(); i++)
+	{
+		if(!thinkingPawns[i]) continue;
+		Pawn& pawn = *thinkingPawns[i];
+		BT::Agent& ai = brains[i].ai;
+		pawn.pawn_control.move = ai.move;
+		ai.move = glm::vec3(0,0,0);//like a consumer pattern
+		pawn.pawn_control.rotate = ai.rotate;
+		pawn.pawn_control.attack = ai.attack;
+		pawn.pawn_control.parry = ai.parry;
+		ai.attack = 0;
+		ai.parry = 0;
+	}
+}
+
+void PlayMode::walk_pawns()
+{
+	// Separation and walkmesh stepping for everyone, in parallel, straight over the packed walker components
+	ECS::Pool<Locomotion::Walker>& pool = world.pool<Locomotion::Walker>();
+	std::vector<Locomotion::Walker>& walkers = pool.data;
+	Locomotion::walk(*walkmesh, walkers, workers, separation);
+
+	std::vector<Pawn*> walkingPawns(walkers.size(), nullptr);
+	for(size_t i = 0; i < walkers.size(); i++)
+	{
+		PawnRef* ref = world.get<PawnRef>(pool.entities[i]);
+		walkingPawns[i] = ref ? ref->pawn : nullptr;
 	}
-	if(&pawn != player)
+
+	// Enemies face using the player's walk point, so hand out every walk point first
+	for(size_t i = 0; i < walkers.size(); i++)
 	{
-		glm::vec3 toOther = player->transform->position - pawn.transform->position;
-		float toOtherLength = glm::length(toOther);
-		if(toOtherLength < (player->walkCollRad + pawn.walkCollRad))
+		if(walkers[i].obstacleOnly || !walkingPawns[i]) continue;
+		walkingPawns[i]->at = walkers[i].at;
+		if(walkers[i].outOfIterations)
 		{
-			float remainLength = glm::length(remain);
-			if(remainLength * toOtherLength > 0.0001f)
-			{
-				remain = remain - remain * glm::dot(toOther / toOtherLength, remain / remainLength);
-			}
+			std::cout << "NOTE: code used full iteration budget for walking." << std::endl;
 		}
 	}
-	
-	///std::cout << remain.x << "," << remain.y << "," << remain.z << "\n";
 
-	//using a for() instead of a while() here so that if walkpoint gets stuck I
-	// some awkward case, code will not infinite loop:
-	for(uint32_t iter = 0; iter < 10; ++iter)
+	for(size_t i = 0; i < walkers.size(); i++)
 	{
-		if (remain == glm::vec3(0.0f)) break;
-		WalkPoint end;
-		float time;
-		walkmesh->walk_in_triangle(pawn.at, remain, &end, &time);
-		pawn.at = end;
-		if (time == 1.0f) {
-			//finished within triangle:
-			remain = glm::vec3(0.0f);
-			break;
-		}
-		//some step remains:
-		remain *= (1.0f - time);
-		//try to step over edge:
-		glm::quat rotation;
-		if (walkmesh->cross_edge(pawn.at, &end, &rotation)) {
-			//stepped to a new triangle:
-			pawn.at = end;
-			//rotate step to follow surface:
-			remain = rotation * remain;
-		} else {
-			//ran into a wall, bounce / slide along it:
-			glm::vec3 const &a = walkmesh->vertices[pawn.at.indices.x];
-			glm::vec3 const &b = walkmesh->vertices[pawn.at.indices.y];
-			glm::vec3 const &c = walkmesh->vertices[pawn.at.indices.z];
-			glm::vec3 along = glm::normalize(b-a);
-			glm::vec3 normal = glm::normalize(glm::cross(b-a, c-a));
-			glm::vec3 in = glm::cross(normal, along);
-
-			//check how much 'remain' is pointing out of the triangle:
-			float d = glm::dot(remain, in);
-			if (d < 0.0f) {
-				//bounce off of the wall:
-				remain += (-1.25f * d) * in;
-			} else {
-				//if it's just pointing along the edge, bend slightly away from wall:
-				remain += 0.01f * d * in;
+		if(walkers[i].obstacleOnly || !walkingPawns[i]) continue;
+		Pawn& pawn = *walkingPawns[i];
+
+		//update player's position to respect walking:
+		pawn.transform->position = walkers[i].walked;
+
+		{ //rotates enemy, not player
+			if (!pawn.is_player){
+				glm::vec3 upDir = walkmesh->to_world_smooth_normal(player->at);
+				pawn.transform->rotation = glm::inverse(pawn.default_rotation) *  glm::angleAxis(pawn.pawn_control.rotate, upDir);  
 			}
 		}
+
+		{ //update player's rotation to respect local (smooth) up-vector:
+			glm::quat adjust = glm::rotation(
+				pawn.transform->rotation * glm::vec3(0.0f, 0.0f, 1.0f), //current up vector
+				walkmesh->to_world_smooth_normal(pawn.at) //smoothed up vector at walk location
+			);
+			pawn.transform->rotation = glm::normalize(adjust * pawn.transform->rotation);
+		}
 	}
+}
 
-	if (remain != glm::vec3(0.0f)) {
-		std::cout << "NOTE: code used full iteration budget for walking." << std::endl;
+void PlayMode::update(float elapsed)
+{
+	if(simulationRate <= 0.0f)
+	{
+		step(elapsed);
+		interpolation = 1.0f;
+		return;
 	}
 
-	//update player's position to respect walking:
-	pawn.transform->position = walkmesh->to_world_point(pawn.at);
+	float const dt = 1.0f / simulationRate;
+	simulationAccumulator += elapsed;
+	int steps = 0;
+	while(simulationAccumulator >= dt && steps < MAX_STEPS_PER_FRAME)
+	{
+		save_transforms();
+		step(dt);
+		simulationAccumulator -= dt;
+		steps++;
+	}
+	// Couldn't keep up, so let the game slow down instead of spending ever longer catching up
+	simulationAccumulator = std::fmod(simulationAccumulator, dt);
+	interpolation = simulationAccumulator / dt;
+}
 
-	{ //rotates enemy, not player
-		if (!pawn.is_player){
-			glm::vec3 upDir = walkmesh->to_world_smooth_normal(player->at);
-			pawn.transform->rotation = glm::inverse(pawn.default_rotation) *  glm::angleAxis(pawn.pawn_control.rotate, upDir);  
+void PlayMode::gather_moving(std::vector<TransformState>* into)
+{
+	into->clear();
+	auto add = [into](Game::CreatureID owner, Scene::Transform* t)
+		{
+			if(t)
+			{
+				into->push_back(TransformState{owner, t, t->position, t->rotation, t->scale});
+			}
+		};
+	auto addPawn = [&add](Game::CreatureID owner, Pawn* pawn)
+		{
+			add(owner, pawn->transform);
+			add(owner, pawn->arm_transform);
+			add(owner, pawn->wrist_transform);
+			add(owner, pawn->sword_transform);
+		};
+
+	if(Player* p = static_cast<Player*>(game.getCreature(plyr)))
+	{
+		addPawn(plyr, p);
+		add(plyr, p->camera->transform);
+	}
+	for(Game::CreatureID myEnemyID : enemiesId)
+	{
+		if(Pawn* p = static_cast<Pawn*>(game.getCreature(myEnemyID)))
+		{
+			addPawn(myEnemyID, p);
 		}
 	}
+}
 
-	{ //update player's rotation to respect local (smooth) up-vector:
-		glm::quat adjust = glm::rotation(
-			pawn.transform->rotation * glm::vec3(0.0f, 0.0f, 1.0f), //current up vector
-			walkmesh->to_world_smooth_normal(pawn.at) //smoothed up vector at walk location
-		);
-		pawn.transform->rotation = glm::normalize(adjust * pawn.transform->rotation);
+void PlayMode::save_transforms()
+{
+	gather_moving(&movingTransforms);
+	previousTransforms.clear();
+	for(TransformState const& s : movingTransforms)
+	{
+		previousTransforms[s.transform] = s;
 	}
 }
 
-void PlayMode::update(float elapsed)
+PlayMode::TransformState* PlayMode::previous_state(Scene::Transform const* t)
+{
+	auto found = previousTransforms.find(t);
+	return found == previousTransforms.end() ? nullptr : &found->second;
+}
+
+void PlayMode::step(float elapsed)
 {
+	simClock.advance(elapsed);
+
 	// Clearing 0 HP enemies
 	{
 		auto enemyIDit = enemiesId.begin();
@@ -1556,18 +1750,35 @@ void PlayMode::update(float elapsed)
 					
 					collEng.unregisterCollider(enemyPtr->bodyCollider); 
 					collEng.unregisterCollider(enemyPtr->swordCollider);
+					// No END for the sword either, and its transform's about to go (and maybe get reused)
+					world.each<SwordHits>([enemyPtr](ECS::Entity, SwordHits& hits) { hits.contactEnded(enemyPtr->sword_transform); });
 
 					DEBUGOUT << "Deleting enemy, colliders deregistered" << std::endl;
+
+					// HP bar points at the body transform, so it has to go before the transforms do
+					auto hpBarit = enemyHpBars.begin();
+					while(hpBarit != enemyHpBars.end())
+					{
+						Gui::WorldBar* bar = static_cast<Gui::WorldBar*>(gui.getElement(*hpBarit));
+						if(!bar || bar->creatureID == *enemyIDit)
+						{
+							gui.removeElement(*hpBarit);
+							auto hpBarToDeleteit = hpBarit++;
+							enemyHpBars.erase(hpBarToDeleteit);
+							continue;
+						}
+						hpBarit++;
+					}
 					
 					scene.drawables.remove_if(pertainsToEnemy);
 
 					DEBUGOUT << "Deleting enemy, drawables removed" << std::endl;
 
 					// This is ridiculously inefficient since we have pointers already, but we never stored iterators, and I don't want to add it rn
+					world.destroy(enemyPtr->entity);
 					scene.transforms.remove_if(pertainsToEnemyTForm); // Whatever, we will just leave transforms allocated, who cares
-					delete enemyPtr->bt;
 
-					DEBUGOUT << "Deleting enemy, bt deleted" << std::endl;
+					DEBUGOUT << "Deleting enemy, entity destroyed" << std::endl;
 					
 					game.destroyCreature(*enemyIDit); // Automatically calls delete (yes I know bad design but we don't have time to fix)
 
@@ -1600,63 +1811,12 @@ void PlayMode::update(float elapsed)
 		}
 	}
 
-	// Also processing invuln timer decrements
-	{
-		for(Game::CreatureID myEnemyID : enemiesId)
-		{
-			Enemy* enemyPtr = static_cast<Enemy*>(game.getCreature(myEnemyID));
-			for(auto it = enemyPtr->recentHitters.begin(); it != enemyPtr->recentHitters.end();)
-			{
-				if(it->timeLeft <= 0.0f)
-				{
-					it = enemyPtr->recentHitters.erase(it);
-				}
-				else
-				{
-					it->timeLeft -= elapsed;
-					it++;
-				}
-			}
-		}
+	// Stamina regen is a system now, see setupSystems
 
-		for(auto it = player->recentHitters.begin(); it != player->recentHitters.end();)
-		{
-			if(it->timeLeft <= 0.0f)
-			{
-				it = player->recentHitters.erase(it);
-			}
-			else
-			{
-				it->timeLeft -= elapsed;
-				it++;
-			}
-		}
-	}
-
-	// Replenishing player stamina
-	{
-		for(Game::CreatureID myEnemyID : enemiesId)
-		{
-			Enemy* enemyPtr = static_cast<Enemy*>(game.getCreature(myEnemyID));
-
-					
-			enemyPtr->stamina += enemyPtr->staminaRegenRate * elapsed;
-			if(enemyPtr->stamina >= enemyPtr->maxstamina)
-			{
-				enemyPtr->stamina = enemyPtr->maxstamina;
-			}
-		}
-		
-		player->stamina += player->staminaRegenRate * elapsed;
-		if(player->stamina >= player->maxstamina)
-		{
-			player->stamina = player->maxstamina;
-		}
-	}
-	
 	// Handle the input we've received this update
 	// We don't put this in player's own update since we need to get the input
 	// which is the mode's job
+	// This only reads input into the player's control, the systems below do the rest for every pawn
 	{
 		//combine inputs into a move:
 		
@@ -1728,33 +1888,17 @@ void PlayMode::update(float elapsed)
 		};
 		
 		static int prev_stance = player->pawn_control.stance;
-		processPawnControl(*player, elapsed);
+		systems.run(world, elapsed); // Stamina, AI, control, locomotion
 		if (player->pawn_control.stance != prev_stance){
 			trigger_move_graphic(prev_stance, player->pawn_control.stance);
 		}
 		prev_stance = player->pawn_control.stance;
 		}
-
-		for(Game::CreatureID enemyID : enemiesId)
+		else
 		{
-			Enemy* enemyPtr = static_cast<Enemy*>(game.getCreature(enemyID));
-			if(!enemyPtr)
-			{
-				DEBUGOUT << "Trying to iterate enemy control, but an enemy didn't exist..." << std::endl;
-				continue;
-			}
-			enemyPtr->bt->tick();// AI Thinking
-			PawnControl& enemy_control=enemyPtr->bt->GetControl();
-			enemyPtr->pawn_control.move = enemy_control.move;
-			enemy_control.move=glm::vec3(0,0,0);//like a consumer pattern
-			enemyPtr->pawn_control.rotate = enemy_control.rotate;
-			enemyPtr->pawn_control.attack = enemy_control.attack; // mainAction.pressed; // For demonstration purposes bound to player attack
-			enemyPtr->pawn_control.parry = enemy_control.parry; //secondAction.pressed; 
-			enemy_control.attack=0;
-			enemy_control.parry=0;
-			
-			processPawnControl(*enemyPtr, elapsed);	
+			systems.run(world, elapsed);
 		}
+
 	}
 
 	Pawn* p = static_cast<Pawn*>(game.getCreature(plyr));
@@ -1846,6 +1990,7 @@ void PlayMode::update(float elapsed)
 	min_footstep_interval = 7.0f / PlayerSpeed;
 
 	// Updates the systems
+	scene.update_world_transforms(); // Everything has moved for this frame, collisions and drawing read the cached matrices
 	collEng.update(elapsed);
 	//DEBUGOUT << "Finished collision update" << std::endl;
 	game.update(elapsed);
@@ -1868,6 +2013,12 @@ void PlayMode::draw(glm::uvec2 const &drawable_size)
 	glUniform1i(lit_color_texture_program->LIGHT_TYPE_int, 1);
 	glUniform3fv(lit_color_texture_program->LIGHT_DIRECTION_vec3, 1, glm::value_ptr(glm::vec3(0.0f, 0.2f * std::cos(angle),-std::sin(angle))));
 	glUniform3fv(lit_color_texture_program->LIGHT_ENERGY_vec3, 1, glm::value_ptr(glm::vec3(1.0f, cscale * 1.0f, cscale * 1.0f)));
+
+	// Instanced variant used by the scene's render queue needs the same lighting
+	glUseProgram(lit_color_texture_program->instanced_program);
+	glUniform1i(lit_color_texture_program->instanced_LIGHT_TYPE_int, 1);
+	glUniform3fv(lit_color_texture_program->instanced_LIGHT_DIRECTION_vec3, 1, glm::value_ptr(glm::vec3(0.0f, 0.2f * std::cos(angle),-std::sin(angle))));
+	glUniform3fv(lit_color_texture_program->instanced_LIGHT_ENERGY_vec3, 1, glm::value_ptr(glm::vec3(1.0f, cscale * 1.0f, cscale * 1.0f)));
 	// glUseProgram(0);
 
 	glm::vec3 xyy_blue = glm::vec3(0.24f, 0.3f, 0.65f);
@@ -1888,50 +2039,50 @@ void PlayMode::draw(glm::uvec2 const &drawable_size)
 	glEnable(GL_DEPTH_TEST);
 	glDepthFunc(GL_LESS); //this is the default depth comparison function, but FYI you can change it.
 
+	// Draw partway between the last two steps, then put back what moved where the simulation left it
+	// Anything that sat still keeps exactly the state its cached matrices were built from, so those don't get rebuilt
+	bool blending = (simulationRate > 0.0f && interpolation < 1.0f && !previousTransforms.empty());
+	drawnTransforms.clear();
+	if(blending)
+	{
+		gather_moving(&movingTransforms);
+		for(TransformState const& now : movingTransforms)
+		{
+			TransformState const* from = previous_state(now.transform);
+			if(!from || from->owner != now.owner) // New since the last step
+			{
+				continue;
+			}
+			if(from->position == now.position && from->rotation == now.rotation && from->scale == now.scale)
+			{
+				continue;
+			}
+			drawnTransforms.push_back(now);
+			Scene::Transform& t = *now.transform;
+			t.position = glm::mix(from->position, now.position, interpolation);
+			t.rotation = glm::slerp(from->rotation, now.rotation, interpolation);
+			t.scale = glm::mix(from->scale, now.scale, interpolation);
+		}
+	}
+
 	glm::mat4 world_to_clip; // Just want to reuse this lol
 	scene.draw(*player->camera, world_to_clip);
 
 	//DEBUGOUT << "Started drawing gui bars" << std::endl;
-	
-	// Positioning enemy HP bars (yes I know we can do this much more efficiently on the GPU)
-	auto enemyHpBarit = enemyHpBars.begin();
-	while(enemyHpBarit != enemyHpBars.end())
-	{	
-		Gui::GuiID enemyHpBar = *enemyHpBarit;
-		Gui::Element* elem = gui.getElement(enemyHpBar);
-		if(elem)
-		{	
-			Gui::Bar* bar = static_cast<Gui::Bar*>(elem);
 
-			if(bar->useCreatureID)
-			{
-				Enemy* enemyPtr = static_cast<Enemy*>(game.getCreature(bar->creatureIDForPos));
-				if(!enemyPtr)
-				{
-					DEBUGOUT << "Tried to set position for hp bar, and it exists, but it's enemy for positioning doesn't, deleting" << std::endl;
-					gui.removeElement(enemyHpBar);
-					auto hpBarToDeleteit = enemyHpBarit++;
-					enemyHpBars.erase(hpBarToDeleteit);
-					continue;
-				}
-				else
-				{
-					enemyHpBarit++;
-				}
-				glm::vec4 clipPos = world_to_clip * glm::mat4(enemyPtr->body_transform->make_local_to_world()) * glm::vec4(0.0f, 0.0f, 2.0f, 1.0f);
+	// Enemy HP bars are anchored to their bodies and projected on the GPU
+	gui.render(world_to_clip);
 
-				// Cursed ass cpu clipping LMAO
-				bar->screenPos = glm::vec3(clipPos.x / clipPos.w, clipPos.y / clipPos.w, (clipPos.w > 0) ? 0.0f : 1.0f);
-			}
-		}
-		else
+	if(!drawnTransforms.empty())
+	{
+		for(TransformState const& s : drawnTransforms)
 		{
-			enemyHpBarit++;
-			DEBUGOUT << "Enemy hp bar doesn't exist, but it's still in the list!" << std::endl;
+			s.transform->position = s.position;
+			s.transform->rotation = s.rotation;
+			s.transform->scale = s.scale;
 		}
+		scene.update_world_transforms();
 	}
-	
-	gui.render(world_to_clip);
 
 	//DEBUGOUT << "Finished drawing gui" << std::endl;
 
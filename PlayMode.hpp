@@ -10,6 +10,11 @@
 #include "Collisions.hpp"
 #include "Sound.hpp"
 #include "Slots.hpp"
+#include "Locomotion.hpp"
+#include "WorkerPool.hpp"
+#include "ECS.hpp"
+#include "BT.hpp"
+#include "SimClock.hpp"
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <vector>
@@ -18,6 +23,7 @@
 #include <array>
 #include <iostream>
 #include <map>
+#include <unordered_map>
 
 struct PlayMode : Mode
 {
@@ -28,6 +34,35 @@ struct PlayMode : Mode
 	virtual bool handle_event(SDL_Event const &, glm::uvec2 const &window_size) override;
 	virtual void update(float elapsed) override;
 	virtual void draw(glm::uvec2 const &drawable_size) override;
+
+	// One simulation step: collisions, AI, walking, everything but drawing
+	// update runs however many of these fit in the time that passed, but a headless run can just call it in a loop
+	void step(float elapsed);
+
+	// Simulation steps at simulationRate no matter the frame rate, and draw blends between the last two steps
+	// 0 goes back to one step per frame of however long the frame took
+	float simulationRate = 120.0f;
+	float simulationAccumulator = 0.0f; // Time passed that hasn't been stepped yet
+	SimClock simClock; // Every step's elapsed, added up, AI cooldowns run off of this
+	float interpolation = 1.0f; // How far draw goes from previousTransforms to the current ones
+	// After a long stall, only this many steps get run and the rest of the time is dropped
+	static constexpr int MAX_STEPS_PER_FRAME = 8;
+
+	// Only pawns (root, arm, wrist, sword) and the camera move during a step, so only those get blended
+	struct TransformState
+	{
+		Game::CreatureID owner; // Who the transform belonged to, so one reusing a dead pawn's address isn't blended
+		Scene::Transform* transform;
+		glm::vec3 position;
+		glm::quat rotation;
+		glm::vec3 scale;
+	};
+	std::unordered_map<Scene::Transform const*, TransformState> previousTransforms; // As of the start of the last step
+	std::vector<TransformState> movingTransforms; // The live pawns' and the camera's, gathered by gather_moving
+	std::vector<TransformState> drawnTransforms; // Where draw stashes the current state of the ones it blended
+	void gather_moving(std::vector<TransformState>* into);
+	void save_transforms();
+	TransformState* previous_state(Scene::Transform const* t);
 	
 	//----- game state -----	
 	//input tracking:
@@ -55,6 +90,8 @@ struct PlayMode : Mode
 
 	Game game;
 	Scene scene;
+	// The one thread pool, for collisions, AI and walking. Declared before collEng, which holds onto it
+	WorkerPool workers;
 	CollisionEngine collEng;
 	Gui gui;
 
@@ -71,8 +108,25 @@ struct PlayMode : Mode
 	
 	std::array<EnemyPreset, 3> enemyPresets;	
 
-	void walk_pawn(Pawn& pawn, glm::vec3 movement);
-	void processPawnControl(Pawn& pawn, float elapsed);
+	// Runs every enemy's behavior tree on the workers, sensing for the whole crowd in one pass first
+	BT::Crowd crowd;
+	bool reactiveAI = true; // Only rethink when something changed, off goes back to running every tree from the top every step
+	void think();
+
+	// Returns how far the pawn wants to move this update, the walking itself is batched in walk_pawns
+	glm::vec3 processPawnControl(Pawn& pawn, float elapsed);
+	void walk_pawns();
+
+	// Spatial hash by default, CONTACTS slides off last update's body contacts instead (and turns on enemy body vs enemy body collisions)
+	Locomotion::Separation separation = Locomotion::Separation::SPATIAL_HASH;
+
+	// Body on body contacts from the collision engine, pawns slide off these on their next walk (only kept with CONTACTS separation)
+	void addBodyContact(Game::CreatureID id, Contact const& contact);
+
+	// Per pawn state that gets a pass every update (stamina, sword hits, AI, walking) lives here
+	ECS::World world;
+	ECS::Scheduler systems;
+	void setupSystems();
 
 	float PlayerSpeed = 8.0f; // for ease of testing only
 
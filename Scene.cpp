@@ -6,6 +6,8 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include <fstream>
+#include <algorithm>
+#include <tuple>
 
 //-------------------------
 
@@ -73,6 +75,49 @@ glm::mat4x3 Scene::Transform::make_world_to_local() const {
 
 //-------------------------
 
+//Rebuild one transform's cached world matrices (and, first, its parents'):
+static void update_world_transform(Scene::Transform const &transform, uint32_t pass) {
+	Scene::Transform::WorldCache &cache = transform.world_cache;
+	if (cache.pass == pass) return; //already handled this pass
+	cache.pass = pass;
+
+	Scene::Transform const *parent = transform.parent;
+	if (parent) update_world_transform(*parent, pass);
+
+	//skip the rebuild if nothing this transform depends on has changed:
+	if (transform.position == cache.position
+	 && transform.rotation == cache.rotation
+	 && transform.scale == cache.scale
+	 && parent == cache.parent
+	 && (!parent || parent->world_cache.version == cache.parent_version)) {
+		return;
+	}
+
+	if (!parent) {
+		cache.local_to_world = transform.make_local_to_parent();
+		cache.world_to_local = transform.make_parent_to_local();
+	} else {
+		cache.local_to_world = parent->world_cache.local_to_world * glm::mat4(transform.make_local_to_parent());
+		cache.world_to_local = transform.make_parent_to_local() * glm::mat4(parent->world_cache.world_to_local);
+	}
+
+	cache.position = transform.position;
+	cache.rotation = transform.rotation;
+	cache.scale = transform.scale;
+	cache.parent = parent;
+	cache.parent_version = (parent ? parent->world_cache.version : 0);
+	cache.version += 1;
+}
+
+void Scene::update_world_transforms() const {
+	world_transforms_pass += 1;
+	for (auto const &transform : transforms) {
+		update_world_transform(transform, world_transforms_pass);
+	}
+}
+
+//-------------------------
+
 glm::mat4 Scene::Camera::make_projection() const {
 	return glm::infinitePerspective( fovy, aspect, near );
 }
@@ -98,51 +143,85 @@ void Scene::draw(Camera const &camera, glm::mat4& w2cret) const
 }
 
 void Scene::draw(glm::mat4 const &world_to_clip, glm::mat4x3 const &world_to_light) const {
+	update_world_transforms();
+
+	draw_stats = DrawStats();
+
+	if (render_queue) {
+		draw_queued(world_to_clip, world_to_light);
+	} else {
+		draw_immediate(world_to_clip, world_to_light);
+	}
+
+	GL_ERRORS();
+}
+
+//skip any drawables that can't actually be drawn:
+static bool is_drawable(Scene::Drawable::Pipeline const &pipeline) {
+	//skip any drawables without a shader program set:
+	if (pipeline.program == 0) return false;
+	//skip any drawables that don't reference any vertex array:
+	if (pipeline.vao == 0) return false;
+	//skip any drawables that don't contain any vertices:
+	if (pipeline.count == 0) return false;
+	return true;
+}
+
+//upload the per-object matrix uniforms for a single drawable:
+static uint32_t set_object_uniforms(Scene::Drawable const &drawable, glm::mat4 const &world_to_clip, glm::mat4x3 const &world_to_light) {
+	Scene::Drawable::Pipeline const &pipeline = drawable.pipeline;
+	uint32_t uploads = 0;
+
+	//the object-to-world matrix is used in all three of these uniforms:
+	assert(drawable.transform); //drawables *must* have a transform
+	glm::mat4x3 const &object_to_world = drawable.transform->get_local_to_world();
+
+	//OBJECT_TO_CLIP takes vertices from object space to clip space:
+	if (pipeline.OBJECT_TO_CLIP_mat4 != -1U) {
+		glm::mat4 object_to_clip = world_to_clip * glm::mat4(object_to_world);
+		glUniformMatrix4fv(pipeline.OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(object_to_clip));
+		uploads += 1;
+	}
+
+	//the object-to-light matrix is used in the next two uniforms:
+	glm::mat4x3 object_to_light = world_to_light * glm::mat4(object_to_world);
+
+	//OBJECT_TO_CLIP takes vertices from object space to light space:
+	if (pipeline.OBJECT_TO_LIGHT_mat4x3 != -1U) {
+		glUniformMatrix4x3fv(pipeline.OBJECT_TO_LIGHT_mat4x3, 1, GL_FALSE, glm::value_ptr(object_to_light));
+		uploads += 1;
+	}
+
+	//NORMAL_TO_CLIP takes normals from object space to light space:
+	if (pipeline.NORMAL_TO_LIGHT_mat3 != -1U) {
+		glm::mat3 normal_to_light = glm::inverse(glm::transpose(glm::mat3(object_to_light)));
+		glUniformMatrix3fv(pipeline.NORMAL_TO_LIGHT_mat3, 1, GL_FALSE, glm::value_ptr(normal_to_light));
+		uploads += 1;
+	}
+
+	return uploads;
+}
+
+void Scene::draw_immediate(glm::mat4 const &world_to_clip, glm::mat4x3 const &world_to_light) const {
 
 	//Iterate through all drawables, sending each one to OpenGL:
 	for (auto const &drawable : drawables) {
 		//Reference to drawable's pipeline for convenience:
 		Scene::Drawable::Pipeline const &pipeline = drawable.pipeline;
 
-		//skip any drawables without a shader program set:
-		if (pipeline.program == 0) continue;
-		//skip any drawables that don't reference any vertex array:
-		if (pipeline.vao == 0) continue;
-		//skip any drawables that don't contain any vertices:
-		if (pipeline.count == 0) continue;
-
+		if (!is_drawable(pipeline)) continue;
+		draw_stats.drawables += 1;
 
 		//Set shader program:
 		glUseProgram(pipeline.program);
+		draw_stats.program_binds += 1;
 
 		//Set attribute sources:
 		glBindVertexArray(pipeline.vao);
+		draw_stats.vao_binds += 1;
 
 		//Configure program uniforms:
-
-		//the object-to-world matrix is used in all three of these uniforms:
-		assert(drawable.transform); //drawables *must* have a transform
-		glm::mat4x3 object_to_world = drawable.transform->make_local_to_world();
-
-		//OBJECT_TO_CLIP takes vertices from object space to clip space:
-		if (pipeline.OBJECT_TO_CLIP_mat4 != -1U) {
-			glm::mat4 object_to_clip = world_to_clip * glm::mat4(object_to_world);
-			glUniformMatrix4fv(pipeline.OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(object_to_clip));
-		}
-
-		//the object-to-light matrix is used in the next two uniforms:
-		glm::mat4x3 object_to_light = world_to_light * glm::mat4(object_to_world);
-
-		//OBJECT_TO_CLIP takes vertices from object space to light space:
-		if (pipeline.OBJECT_TO_LIGHT_mat4x3 != -1U) {
-			glUniformMatrix4x3fv(pipeline.OBJECT_TO_LIGHT_mat4x3, 1, GL_FALSE, glm::value_ptr(object_to_light));
-		}
-
-		//NORMAL_TO_CLIP takes normals from object space to light space:
-		if (pipeline.NORMAL_TO_LIGHT_mat3 != -1U) {
-			glm::mat3 normal_to_light = glm::inverse(glm::transpose(glm::mat3(object_to_light)));
-			glUniformMatrix3fv(pipeline.NORMAL_TO_LIGHT_mat3, 1, GL_FALSE, glm::value_ptr(normal_to_light));
-		}
+		draw_stats.uniform_uploads += set_object_uniforms(drawable, world_to_clip, world_to_light);
 
 		//set any requested custom uniforms:
 		if (pipeline.set_uniforms) pipeline.set_uniforms();
@@ -152,17 +231,20 @@ void Scene::draw(glm::mat4 const &world_to_clip, glm::mat4x3 const &world_to_lig
 			if (pipeline.textures[i].texture != 0) {
 				glActiveTexture(GL_TEXTURE0 + i);
 				glBindTexture(pipeline.textures[i].target, pipeline.textures[i].texture);
+				draw_stats.texture_binds += 1;
 			}
 		}
 
 		//draw the object:
 		glDrawArrays(pipeline.type, pipeline.start, pipeline.count);
+		draw_stats.draw_calls += 1;
 
 		//un-bind textures:
 		for (uint32_t i = 0; i < Drawable::Pipeline::TextureCount; ++i) {
 			if (pipeline.textures[i].texture != 0) {
 				glActiveTexture(GL_TEXTURE0 + i);
 				glBindTexture(pipeline.textures[i].target, 0);
+				draw_stats.texture_binds += 1;
 			}
 		}
 		glActiveTexture(GL_TEXTURE0);
@@ -171,8 +253,133 @@ void Scene::draw(glm::mat4 const &world_to_clip, glm::mat4x3 const &world_to_lig
 
 	glUseProgram(0);
 	glBindVertexArray(0);
+}
 
-	GL_ERRORS();
+void Scene::draw_queued(glm::mat4 const &world_to_clip, glm::mat4x3 const &world_to_light) const {
+	typedef Drawable::Pipeline Pipeline;
+
+	//can this drawable be folded into an instanced draw with others like it?
+	auto instanceable = [](Pipeline const &p) -> bool {
+		return p.instancing.program != 0 && p.instancing.vao != 0 && p.instancing.buffer != 0 && !p.set_uniforms;
+	};
+
+	//sort key, in order of how expensive each piece of state is to change:
+	auto key = [&instanceable](Pipeline const &p) {
+		return std::make_tuple(
+			p.program, p.vao,
+			p.textures[0].texture, p.textures[1].texture, p.textures[2].texture, p.textures[3].texture,
+			p.type, p.start, p.count,
+			!instanceable(p)
+		);
+	};
+
+	//gather + sort:
+	draw_queue.clear();
+	for (auto const &drawable : drawables) {
+		if (!is_drawable(drawable.pipeline)) continue;
+		draw_queue.emplace_back(&drawable);
+	}
+	std::stable_sort(draw_queue.begin(), draw_queue.end(), [&key](Drawable const *a, Drawable const *b) {
+		return key(a->pipeline) < key(b->pipeline);
+	});
+	draw_stats.drawables = uint32_t(draw_queue.size());
+
+	//currently bound state, so only changes get sent to OpenGL:
+	GLuint bound_program = 0;
+	GLuint bound_vao = 0;
+	Pipeline::TextureInfo bound_textures[Pipeline::TextureCount];
+	GLuint active_texture = 0;
+
+	auto bind_textures = [&](Pipeline const &p) {
+		for (uint32_t i = 0; i < Pipeline::TextureCount; ++i) {
+			Pipeline::TextureInfo const &want = p.textures[i];
+			Pipeline::TextureInfo &have = bound_textures[i];
+			if (want.texture == have.texture && (want.texture == 0 || want.target == have.target)) continue;
+			if (active_texture != i) {
+				glActiveTexture(GL_TEXTURE0 + i);
+				active_texture = i;
+			}
+			if (have.texture != 0 && have.target != want.target) {
+				glBindTexture(have.target, 0); //different target, so binding 'want' won't replace it
+				draw_stats.texture_binds += 1;
+			}
+			if (want.texture != 0 || have.target == want.target) {
+				glBindTexture(want.target, want.texture);
+				draw_stats.texture_binds += 1;
+			}
+			have = want;
+		}
+	};
+
+	for (size_t begin = 0; begin < draw_queue.size(); ) {
+		Pipeline const &pipeline = draw_queue[begin]->pipeline;
+
+		//find the run of drawables that can share this draw:
+		size_t end = begin + 1;
+		bool instanced = instanceable(pipeline);
+		if (instanced) {
+			while (end < draw_queue.size() && key(draw_queue[end]->pipeline) == key(pipeline)) ++end;
+		}
+
+		GLuint program = (instanced ? pipeline.instancing.program : pipeline.program);
+		GLuint vao = (instanced ? pipeline.instancing.vao : pipeline.vao);
+
+		if (program != bound_program) {
+			glUseProgram(program);
+			bound_program = program;
+			draw_stats.program_binds += 1;
+		}
+		if (vao != bound_vao) {
+			glBindVertexArray(vao);
+			bound_vao = vao;
+			draw_stats.vao_binds += 1;
+		}
+		bind_textures(pipeline);
+
+		if (instanced) {
+			//stream matrices for the whole run into the instance buffer:
+			draw_instances.clear();
+			for (size_t i = begin; i < end; ++i) {
+				glm::mat4x3 const &object_to_world = draw_queue[i]->transform->get_local_to_world();
+				draw_instances.emplace_back();
+				Instance &instance = draw_instances.back();
+				instance.object_to_clip = world_to_clip * glm::mat4(object_to_world);
+				instance.object_to_light = world_to_light * glm::mat4(object_to_world);
+				instance.normal_to_light = glm::inverse(glm::transpose(glm::mat3(instance.object_to_light)));
+			}
+
+			glBindBuffer(GL_ARRAY_BUFFER, pipeline.instancing.buffer);
+			glBufferData(GL_ARRAY_BUFFER, draw_instances.size() * sizeof(Instance), draw_instances.data(), GL_STREAM_DRAW);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			draw_stats.buffer_uploads += 1;
+
+			glDrawArraysInstanced(pipeline.type, pipeline.start, pipeline.count, GLsizei(end - begin));
+			draw_stats.draw_calls += 1;
+		} else {
+			draw_stats.uniform_uploads += set_object_uniforms(*draw_queue[begin], world_to_clip, world_to_light);
+
+			//set any requested custom uniforms:
+			if (pipeline.set_uniforms) pipeline.set_uniforms();
+
+			glDrawArrays(pipeline.type, pipeline.start, pipeline.count);
+			draw_stats.draw_calls += 1;
+		}
+
+		begin = end;
+	}
+
+	//un-bind textures:
+	for (uint32_t i = 0; i < Pipeline::TextureCount; ++i) {
+		if (bound_textures[i].texture != 0) {
+			glActiveTexture(GL_TEXTURE0 + i);
+			glBindTexture(bound_textures[i].target, 0);
+			draw_stats.texture_binds += 1;
+		}
+	}
+	glActiveTexture(GL_TEXTURE0);
+
+	glUseProgram(0);
+	glBindVertexArray(0);
 }
 
 
@@ -347,6 +554,8 @@ void Scene::set(Scene const &other, std::unordered_map< Transform const *, Trans
 	//null transform maps to itself:
 	transform_to_transform.insert(std::make_pair(nullptr, nullptr));
 
+	render_queue = other.render_queue;
+
 	//Copy transforms and store mapping:
 	transforms.clear();
 	for (auto const &t : other.transforms) {
@@ -21,6 +21,7 @@
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <limits>
 
 struct Scene {
 	struct Transform {
@@ -43,6 +44,28 @@ struct Scene {
 		glm::mat4x3 make_local_to_world() const;
 		glm::mat4x3 make_world_to_local() const;
 
+		//..relative to the world, as cached by the last Scene::update_world_transforms():
+		// (much cheaper than the make_* versions, which walk the whole parent chain every call)
+		glm::mat4x3 const &get_local_to_world() const { return world_cache.local_to_world; }
+		glm::mat4x3 const &get_world_to_local() const { return world_cache.world_to_local; }
+
+		//bookkeeping for the cached matrices above:
+		struct WorldCache {
+			//local transformation + parent the matrices were built from (NaN position means "never built"):
+			glm::vec3 position = glm::vec3(std::numeric_limits< float >::quiet_NaN());
+			glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+			glm::vec3 scale = glm::vec3(1.0f);
+			Transform const *parent = nullptr;
+			uint32_t parent_version = 0;
+
+			uint32_t version = 0; //bumped whenever the matrices change, so children know to rebuild
+			uint32_t pass = 0; //last Scene::update_world_transforms() pass that visited this transform
+
+			glm::mat4x3 local_to_world = glm::mat4x3(1.0f);
+			glm::mat4x3 world_to_local = glm::mat4x3(1.0f);
+		};
+		mutable WorldCache world_cache; //mutable since refreshing the cache doesn't change the transform
+
 		//since hierarchy is tracked through pointers, copy-constructing a transform  is not advised:
 		Transform(Transform const &) = delete;
 		//if we delete some constructors, we need to let the compiler know that the default constructor is still okay:
@@ -78,9 +101,26 @@ struct Scene {
 				GLuint texture = 0;
 				GLenum target = GL_TEXTURE_2D;
 			} textures[TextureCount];
+
+			//(optional) instanced variant of this pipeline, used by the render queue (see Scene::render_queue):
+			// drawables that share program, vao, textures, and vertex range are drawn with a single glDrawArraysInstanced,
+			// with their matrices streamed through 'buffer' as per-instance attributes (laid out as Scene::Instance)
+			struct Instancing {
+				GLuint program = 0; //reads per-instance matrices from attributes instead of the OBJECT_TO_* uniforms
+				GLuint vao = 0; //same vertex attributes as 'vao' plus per-instance attributes sourced from 'buffer'
+				GLuint buffer = 0; //per-instance data, overwritten by every instanced draw
+			} instancing;
 		} pipeline;
 	};
 
+	//Per-instance data uploaded by the render queue for instanced pipelines:
+	struct Instance {
+		glm::mat4 object_to_clip;
+		glm::mat4x3 object_to_light;
+		glm::mat3 normal_to_light;
+	};
+	static_assert(sizeof(Instance) == 4*16 + 4*12 + 4*9, "Instance is packed.");
+
 	struct Camera {
 		//a 'Camera' attaches camera data to a transform:
 		Camera(Transform *transform_) : transform(transform_) { assert(transform); }
@@ -122,7 +162,31 @@ struct Scene {
 	std::list< Camera > cameras;
 	std::list< Light > lights;
 
+	//Refresh the cached world matrices of every transform whose local transformation (or whose parent's
+	// world transformation) changed since the last call. Each transform is rebuilt at most once per call.
+	// Call this once all transforms have been moved for the frame, before reading get_local_to_world():
+	void update_world_transforms() const;
+	mutable uint32_t world_transforms_pass = 0;
+
+	//When set, draw() sorts drawables by (program, vao, textures, vertex range) and only changes state between
+	// runs of matching drawables; runs whose pipeline has an instanced variant become one instanced draw call.
+	// Drawables with custom set_uniforms are still drawn one at a time (their uniforms can't be batched).
+	bool render_queue = false;
+
+	//Counts of GL work done by the last draw(), handy for checking how much the render queue is saving:
+	struct DrawStats {
+		uint32_t drawables = 0; //drawables submitted
+		uint32_t draw_calls = 0; //glDrawArrays + glDrawArraysInstanced
+		uint32_t program_binds = 0; //glUseProgram
+		uint32_t vao_binds = 0; //glBindVertexArray
+		uint32_t texture_binds = 0; //glBindTexture (including un-binds)
+		uint32_t uniform_uploads = 0; //glUniform* for the object matrices
+		uint32_t buffer_uploads = 0; //glBufferData for instance data
+	};
+	mutable DrawStats draw_stats;
+
 	//The "draw" function provides a convenient way to pass all the things in a scene to OpenGL:
+	// (it refreshes the world matrix cache itself)
 	void draw(Camera const &camera) const;
 	void draw(Camera const &camera, glm::mat4& w2cret) const;
 	//..sometimes, you want to draw with a custom projection matrix and/or light space:
@@ -150,4 +214,10 @@ struct Scene {
 	Scene &operator=(Scene const &); //...as scene = scene
 	//... as a set() function that optionally returns the transform->transform mapping:
 	void set(Scene const &, std::unordered_map< Transform const *, Transform * > *transform_map = nullptr);
+
+	//internals for draw():
+	void draw_immediate(glm::mat4 const &world_to_clip, glm::mat4x3 const &world_to_light) const;
+	void draw_queued(glm::mat4 const &world_to_clip, glm::mat4x3 const &world_to_light) const;
+	mutable std::vector< Drawable const * > draw_queue; //kept around to avoid reallocating every frame
+	mutable std::vector< Instance > draw_instances;
 };
@@ -0,0 +1,31 @@
+#ifndef SIM_CLOCK_HPP
+#define SIM_CLOCK_HPP
+
+#include <cstdint>
+#include <limits>
+
+// Time as the simulation sees it, it only moves when a step feeds it elapsed
+// So anything timed off of it runs just as well fast-forwarded or headless as it does in real time
+struct SimClock
+{
+	double now = 0.0; // Seconds of simulation so far
+	uint64_t steps = 0;
+
+	void advance(float elapsed)
+	{
+		now += elapsed;
+		steps++;
+	}
+};
+
+// Cooldown on a SimClock, as fine as the steps feeding it
+// Ready until it's first started, then again once more than length has passed (a length of 0 is always ready)
+struct SimTimer
+{
+	double last = -std::numeric_limits<double>::infinity();
+
+	bool ready(SimClock const& clock, double length) const { return length == 0.0 || clock.now - last > length; }
+	void start(SimClock const& clock) { last = clock.now; }
+};
+
+#endif
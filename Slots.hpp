@@ -2,110 +2,138 @@
 #define SLOTS_HPP
 
 #include <cstddef>
+#include <cstdint>
 #include <vector>
-#include <array>
-#include <queue>
-#include <tuple>
-#include <deque>
-#include <ctime>
-#include <exception>
-#include <iostream>
+#include <limits>
+#include <utility>
 
 typedef size_t slots_gen_t;
 
+// Handle into a Slots, stays valid only as long as the thing it was handed out for is alive
+// (destroying bumps the slot's generation, so old ids just stop resolving instead of pointing at whatever moved in)
 struct SlotID
 {
-	SlotID() : idx(0), gen(0) {};
+	static size_t const INVALID_IDX = std::numeric_limits<size_t>::max();
+
+	SlotID() : idx(INVALID_IDX), gen(0) {};
 	SlotID(size_t i, slots_gen_t g) : idx(i), gen(g) {};
-	
-	size_t idx;
-	slots_gen_t gen; 
+
+	size_t idx; // What slot are we in?
+	slots_gen_t gen; // What generation of inhabitant of this slot are we?
+
+	bool operator==(SlotID const& o) const { return idx == o.idx && gen == o.gen; }
+	bool operator!=(SlotID const& o) const { return !(*this == o); }
 };
 
-template<typename T, slots_gen_t N>
+// Generational slot map: ids index a sparse array of slots, which point into a densely packed array of values
+// Live values are always contiguous (iterate with begin()/end() or at()), it grows as needed, and nothing throws
+// Destroying swaps the last value into the hole, so dense order isn't stable across destroys
+template<typename T>
 struct Slots
 {
-	Slots()
-		{
-			for(size_t i = 0; i < N; i++)
-			{
-				openSlots.emplace(i, 0);
-				std::get<0>(slots[i]) = nullptr;
-			}
-		}
-	~Slots()
+	Slots() {};
+
+	// Returns the id for the new value, never fails
+	SlotID spawn(T value)
 		{
-			for(size_t i = 0; i < N; i++)
+			size_t idx;
+			if(freeHead != NONE)
 			{
-				auto c = slots[i];
-				if(std::get<0>(c) != nullptr)
-				{
-					delete std::get<0>(c);
-				}
+				// Take the slot that's been free longest, so the same slot doesn't get reused too much
+				idx = freeHead;
+				freeHead = sparse[idx].nextFree;
+				sparse[idx].nextFree = NONE;
+				if(freeHead == NONE) freeTail = NONE;
 			}
-		}
-	
-	SlotID spawn(T c)
-		{
-			if(openSlots.empty())
+			else
 			{
-				return SlotID(N, 0);
+				idx = sparse.size();
+				sparse.push_back(Slot{NONE, NONE, 0});
 			}
 
-			SlotID result = openSlots.front();
-			openSlots.pop();
+			sparse[idx].dense = values.size();
+			values.push_back(std::move(value));
+			denseToSparse.push_back(idx);
 
-			std::get<0>(slots[result.idx]) = c;
-	
-			return result;
+			return SlotID(idx, sparse[idx].gen);
 		}
 
+	// Returns false if id doesn't refer to a live value (wrong gen or out of range)
 	bool destroy(SlotID id)
 		{
-			try
-			{
-				auto& c = slots.at(id.idx);
-				if(std::get<1>(c) == id.gen)
-				{
-					delete std::get<0>(c);
-					std::get<0>(c) = nullptr;
-
-					openSlots.emplace(id.idx, id.gen + 1);
-					return true;
-				}
-				else
-				{
-					return false;
-				}
-			}
-			catch(std::out_of_range const& e)
+			if(!valid(id)) return false;
+
+			// Fill the hole with the last value
+			size_t dense = sparse[id.idx].dense;
+			size_t last = values.size() - 1;
+			if(dense != last)
 			{
-				return false;
+				values[dense] = std::move(values[last]);
+				denseToSparse[dense] = denseToSparse[last];
+				sparse[denseToSparse[dense]].dense = dense;
 			}
-		}
+			values.pop_back();
+			denseToSparse.pop_back();
 
-	T get(SlotID id)
-		{
-			try
+			// Old ids stop resolving, then slot goes on the back of the free list
+			Slot& slot = sparse[id.idx];
+			slot.gen++;
+			slot.dense = NONE;
+			if(freeTail != NONE)
 			{
-				auto c = slots.at(id.idx);
-				if(std::get<1>(c) == id.gen)
-				{
-					return std::get<0>(c);
-				}
-				else
-				{
-					return nullptr;
-				}
+				sparse[freeTail].nextFree = id.idx;
 			}
-			catch(std::out_of_range const& e)
+			else
 			{
-				return nullptr;
+				freeHead = id.idx;
 			}
+			freeTail = id.idx;
+
+			return true;
+		}
+
+	// Returns nullptr if id doesn't refer to a live value
+	// Pointer is good until the next spawn/destroy
+	T* get(SlotID id)
+		{
+			return valid(id) ? &values[sparse[id.idx].dense] : nullptr;
+		}
+	T const* get(SlotID id) const
+		{
+			return valid(id) ? &values[sparse[id.idx].dense] : nullptr;
 		}
 
-	std::array<std::tuple<T, slots_gen_t>, N> slots;
-	std::queue<SlotID> openSlots; 
+	bool valid(SlotID id) const
+		{
+			return id.idx < sparse.size() && sparse[id.idx].gen == id.gen && sparse[id.idx].dense != NONE;
+		}
+
+	// Dense access, for iterating live values
+	size_t size() const { return values.size(); }
+	bool empty() const { return values.empty(); }
+	T& at(size_t dense) { return values[dense]; }
+	T const& at(size_t dense) const { return values[dense]; }
+	SlotID idAt(size_t dense) const { return SlotID(denseToSparse[dense], sparse[denseToSparse[dense]].gen); }
+	typename std::vector<T>::iterator begin() { return values.begin(); }
+	typename std::vector<T>::iterator end() { return values.end(); }
+	typename std::vector<T>::const_iterator begin() const { return values.begin(); }
+	typename std::vector<T>::const_iterator end() const { return values.end(); }
+
+private:
+	static size_t const NONE = std::numeric_limits<size_t>::max();
+
+	struct Slot
+	{
+		size_t dense; // Index into values, NONE if free
+		size_t nextFree; // Next slot on the free list, NONE if last (or live)
+		slots_gen_t gen;
+	};
+
+	std::vector<T> values; // Live values, packed
+	std::vector<size_t> denseToSparse; // Slot each value belongs to
+	std::vector<Slot> sparse;
+	size_t freeHead = NONE; // Free list runs head -> tail through Slot::nextFree
+	size_t freeTail = NONE;
 };
 
 #endif
@@ -11,20 +11,36 @@
 #include <algorithm>
 #include <limits>
 #include <string>
+#include <functional>
 
 WalkMesh::WalkMesh(std::vector< glm::vec3 > const &vertices_, std::vector< glm::vec3 > const &normals_, std::vector< glm::uvec3 > const &triangles_)
 	: vertices(vertices_), normals(normals_), triangles(triangles_) {
 
-	//construct next_vertex map (maps each edge to the next vertex in the triangle):
-	next_vertex.reserve(triangles.size()*3);
-	auto do_next = [this](uint32_t a, uint32_t b, uint32_t c) {
-		auto ret = next_vertex.insert(std::make_pair(glm::uvec2(a,b), c));
-		assert(ret.second);
+	//construct adjacency (maps each edge to the matching edge of the triangle across it):
+	// sort all directed edges by (from, to), then look up the reversed edge of each one
+	struct HalfEdge {
+		uint64_t key; //from << 32 | to
+		uint32_t slot; //3*t+k
+		bool operator<(HalfEdge const &o) const { return key < o.key; }
 	};
-	for (auto const &tri : triangles) {
-		do_next(tri.x, tri.y, tri.z);
-		do_next(tri.y, tri.z, tri.x);
-		do_next(tri.z, tri.x, tri.y);
+	std::vector< HalfEdge > half_edges;
+	half_edges.reserve(triangles.size()*3);
+	for (uint32_t t = 0; t < triangles.size(); ++t) {
+		for (uint32_t k = 0; k < 3; ++k) {
+			uint64_t from = triangles[t][k];
+			uint64_t to = triangles[t][(k+1)%3];
+			half_edges.push_back(HalfEdge{ (from << 32) | to, 3*t+k });
+		}
+	}
+	std::sort(half_edges.begin(), half_edges.end());
+	adjacency.assign(triangles.size()*3, -1U);
+	for (uint32_t i = 0; i < half_edges.size(); ++i) {
+		assert((i == 0 || half_edges[i-1].key != half_edges[i].key) && "walkmesh has the same directed edge twice");
+		uint64_t reversed = (half_edges[i].key << 32) | (half_edges[i].key >> 32);
+		auto f = std::lower_bound(half_edges.begin(), half_edges.end(), HalfEdge{ reversed, 0 });
+		if (f != half_edges.end() && f->key == reversed) {
+			adjacency[half_edges[i].slot] = f->slot;
+		}
 	}
 
 	//DEBUG: are vertex normals consistent with geometric normals?
@@ -40,6 +56,8 @@ WalkMesh::WalkMesh(std::vector< glm::vec3 > const &vertices_, std::vector< glm::
 
 		assert(da > 0.1f && db > 0.1f && dc > 0.1f);
 	}
+
+	build_bvh();
 }
 
 //project pt to the plane of triangle a,b,c and return the barycentric weights of the projected point:
@@ -60,65 +78,125 @@ glm::vec3 barycentric_weights(glm::vec3 const &a, glm::vec3 const &b, glm::vec3
 	return glm::vec3(opA, opB, opC);
 }
 
-WalkPoint WalkMesh::nearest_walk_point(glm::vec3 const &world_point) const {
-	assert(!triangles.empty() && "Cannot start on an empty walkmesh");
+float WalkMesh::closest_on_triangle(uint32_t t, glm::vec3 const &world_point, WalkPoint *closest_) const {
+	assert(closest_);
+	auto &closest = *closest_;
+
+	glm::uvec3 const &tri = triangles[t];
+	glm::vec3 const &a = vertices[tri.x];
+	glm::vec3 const &b = vertices[tri.y];
+	glm::vec3 const &c = vertices[tri.z];
+
+	//get barycentric coordinates of closest point in the plane of (a,b,c):
+	glm::vec3 coords = barycentric_weights(a,b,c, world_point);
+
+	//is that point inside the triangle?
+	closest.triangle = t;
+	if (coords.x >= 0.0f && coords.y >= 0.0f && coords.z >= 0.0f) {
+		//yes, point is inside triangle.
+		closest.indices = tri;
+		closest.weights = coords;
+		return glm::length2(world_point - to_world_point(closest));
+	}
 
-	WalkPoint closest;
+	//check triangle vertices and edges:
 	float closest_dis2 = std::numeric_limits< float >::infinity();
+	auto check_edge = [&world_point, &closest, &closest_dis2, this](uint32_t ai, uint32_t bi, uint32_t ci) {
+		glm::vec3 const &a = vertices[ai];
+		glm::vec3 const &b = vertices[bi];
+
+		//find closest point on line segment ab:
+		float along = glm::dot(world_point-a, b-a);
+		float max = glm::dot(b-a, b-a);
+		glm::vec3 pt;
+		glm::vec3 coords;
+		if (along < 0.0f) {
+			pt = a;
+			coords = glm::vec3(1.0f, 0.0f, 0.0f);
+		} else if (along > max) {
+			pt = b;
+			coords = glm::vec3(0.0f, 1.0f, 0.0f);
+		} else {
+			float amt = along / max;
+			pt = glm::mix(a, b, amt);
+			coords = glm::vec3(1.0f - amt, amt, 0.0f);
+		}
 
-	for (auto const &tri : triangles) {
-		//find closest point on triangle:
+		float dis2 = glm::length2(world_point - pt);
+		if (dis2 < closest_dis2) {
+			closest_dis2 = dis2;
+			closest.indices = glm::uvec3(ai, bi, ci);
+			closest.weights = coords;
+		}
+	};
+	check_edge(tri.x, tri.y, tri.z);
+	check_edge(tri.y, tri.z, tri.x);
+	check_edge(tri.z, tri.x, tri.y);
+	return closest_dis2;
+}
 
-		glm::vec3 const &a = vertices[tri.x];
-		glm::vec3 const &b = vertices[tri.y];
-		glm::vec3 const &c = vertices[tri.z];
+WalkPoint WalkMesh::nearest_walk_point_linear(glm::vec3 const &world_point) const {
+	assert(!triangles.empty() && "Cannot start on an empty walkmesh");
 
+	WalkPoint closest;
+	float closest_dis2 = std::numeric_limits< float >::infinity();
 
-		//get barycentric coordinates of closest point in the plane of (a,b,c):
-		glm::vec3 coords = barycentric_weights(a,b,c, world_point);
+	for (uint32_t t = 0; t < triangles.size(); ++t) {
+		WalkPoint wp;
+		float dis2 = closest_on_triangle(t, world_point, &wp);
+		if (dis2 < closest_dis2) {
+			closest_dis2 = dis2;
+			closest = wp;
+		}
+	}
+	assert(closest.indices.x < vertices.size());
+	assert(closest.indices.y < vertices.size());
+	assert(closest.indices.z < vertices.size());
+	return closest;
+}
 
-		//is that point inside the triangle?
-		if (coords.x >= 0.0f && coords.y >= 0.0f && coords.z >= 0.0f) {
-			//yes, point is inside triangle.
-			float dis2 = glm::length2(world_point - to_world_point(WalkPoint(tri, coords)));
-			if (dis2 < closest_dis2) {
-				closest_dis2 = dis2;
-				closest.indices = tri;
-				closest.weights = coords;
-			}
-		} else {
-			//check triangle vertices and edges:
-			auto check_edge = [&world_point, &closest, &closest_dis2, this](uint32_t ai, uint32_t bi, uint32_t ci) {
-				glm::vec3 const &a = vertices[ai];
-				glm::vec3 const &b = vertices[bi];
-
-				//find closest point on line segment ab:
-				float along = glm::dot(world_point-a, b-a);
-				float max = glm::dot(b-a, b-a);
-				glm::vec3 pt;
-				glm::vec3 coords;
-				if (along < 0.0f) {
-					pt = a;
-					coords = glm::vec3(1.0f, 0.0f, 0.0f);
-				} else if (along > max) {
-					pt = b;
-					coords = glm::vec3(0.0f, 1.0f, 0.0f);
-				} else {
-					float amt = along / max;
-					pt = glm::mix(a, b, amt);
-					coords = glm::vec3(1.0f - amt, amt, 0.0f);
-				}
+//squared distance from pt to the box [min,max] (zero inside):
+static float box_dis2(glm::vec3 const &min, glm::vec3 const &max, glm::vec3 const &pt) {
+	return glm::length2(glm::max(glm::max(min - pt, pt - max), glm::vec3(0.0f)));
+}
+
+WalkPoint WalkMesh::nearest_walk_point(glm::vec3 const &world_point) const {
+	assert(!triangles.empty() && "Cannot start on an empty walkmesh");
+	assert(!bvh_nodes.empty());
 
-				float dis2 = glm::length2(world_point - pt);
-				if (dis2 < closest_dis2) {
+	WalkPoint closest;
+	float closest_dis2 = std::numeric_limits< float >::infinity();
+	uint32_t closest_tri = -1U;
+
+	//depth-first, nearer child first, skipping anything farther than the best so far:
+	// (boxes at exactly closest_dis2 are still visited so ties can go to the lower triangle index, like the linear scan)
+	uint32_t stack[64];
+	uint32_t stack_size = 0;
+	stack[stack_size++] = 0;
+	while (stack_size) {
+		BVHNode const &node = bvh_nodes[stack[--stack_size]];
+		if (box_dis2(node.min, node.max, world_point) > closest_dis2) continue;
+
+		if (node.count) {
+			for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+				uint32_t t = bvh_triangles[i];
+				WalkPoint wp;
+				float dis2 = closest_on_triangle(t, world_point, &wp);
+				if (dis2 < closest_dis2 || (dis2 == closest_dis2 && t < closest_tri)) {
 					closest_dis2 = dis2;
-					closest.indices = glm::uvec3(ai, bi, ci);
-					closest.weights = coords;
+					closest_tri = t;
+					closest = wp;
 				}
-			};
-			check_edge(tri.x, tri.y, tri.z);
-			check_edge(tri.y, tri.z, tri.x);
-			check_edge(tri.z, tri.x, tri.y);
+			}
+		} else {
+			uint32_t near_child = uint32_t(&node - bvh_nodes.data()) + 1;
+			uint32_t far_child = node.first;
+			float near_dis2 = box_dis2(bvh_nodes[near_child].min, bvh_nodes[near_child].max, world_point);
+			float far_dis2 = box_dis2(bvh_nodes[far_child].min, bvh_nodes[far_child].max, world_point);
+			if (far_dis2 < near_dis2) std::swap(near_child, far_child);
+			assert(stack_size + 2 <= 64);
+			stack[stack_size++] = far_child;
+			stack[stack_size++] = near_child;
 		}
 	}
 	assert(closest.indices.x < vertices.size());
@@ -127,6 +205,64 @@ WalkPoint WalkMesh::nearest_walk_point(glm::vec3 const &world_point) const {
 	return closest;
 }
 
+void WalkMesh::build_bvh() {
+	bvh_nodes.clear();
+	bvh_triangles.resize(triangles.size());
+	for (uint32_t t = 0; t < triangles.size(); ++t) {
+		bvh_triangles[t] = t;
+	}
+	if (triangles.empty()) return;
+
+	std::vector< glm::vec3 > centroids;
+	centroids.reserve(triangles.size());
+	for (auto const &tri : triangles) {
+		centroids.emplace_back((vertices[tri.x] + vertices[tri.y] + vertices[tri.z]) / 3.0f);
+	}
+
+	//median split on the longest axis of the centroid bounds; depth is ~log2(triangles / leaf_size), well inside the query stack:
+	constexpr uint32_t leaf_size = 4;
+	bvh_nodes.reserve(2 * (triangles.size() / leaf_size + 1));
+	std::function< void(uint32_t, uint32_t) > build = [&](uint32_t first, uint32_t count) {
+		uint32_t index = uint32_t(bvh_nodes.size());
+		bvh_nodes.emplace_back();
+
+		BVHNode node;
+		glm::vec3 cmin = glm::vec3( std::numeric_limits< float >::infinity());
+		glm::vec3 cmax = glm::vec3(-std::numeric_limits< float >::infinity());
+		for (uint32_t i = first; i < first + count; ++i) {
+			glm::uvec3 const &tri = triangles[bvh_triangles[i]];
+			for (uint32_t v : {tri.x, tri.y, tri.z}) {
+				node.min = glm::min(node.min, vertices[v]);
+				node.max = glm::max(node.max, vertices[v]);
+			}
+			cmin = glm::min(cmin, centroids[bvh_triangles[i]]);
+			cmax = glm::max(cmax, centroids[bvh_triangles[i]]);
+		}
+
+		if (count <= leaf_size) {
+			node.first = first;
+			node.count = count;
+			bvh_nodes[index] = node;
+			return;
+		}
+
+		glm::vec3 extent = cmax - cmin;
+		int axis = (extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2));
+		uint32_t half = count / 2;
+		std::nth_element(bvh_triangles.begin() + first, bvh_triangles.begin() + first + half, bvh_triangles.begin() + first + count,
+			[&centroids, axis](uint32_t a, uint32_t b) {
+				return centroids[a][axis] < centroids[b][axis];
+			});
+
+		build(first, half);
+		node.first = uint32_t(bvh_nodes.size());
+		node.count = 0;
+		build(first + half, count - half);
+		bvh_nodes[index] = node;
+	};
+	build(0, uint32_t(triangles.size()));
+}
+
 // Referenced code from @stroucki on discord (image in game5 channel)
 void WalkMesh::walk_in_triangle(WalkPoint const &start, glm::vec3 const &step, WalkPoint *end_, float *time_) const {
 	assert(end_);
@@ -169,6 +305,8 @@ void WalkMesh::walk_in_triangle(WalkPoint const &start, glm::vec3 const &step, W
 
 	glm::vec3 endWeights = start.weights + time * (stepEndBary - start.weights);
 
+	end.triangle = start.triangle;
+
 	if(nearestEdgeOpVert != 3)
 	{
 		for(auto i = 0; i < 3; i++)
@@ -194,19 +332,25 @@ bool WalkMesh::cross_edge(WalkPoint const& start, WalkPoint* end_, glm::quat* ro
 	auto& rotation = *rotation_;
 
 	assert(start.weights.z == 0.0f); // This is our convention
-	glm::uvec2 edge = glm::uvec2(start.indices); // The edge from the POV of the current triangle
-	glm::uvec2 opEdge = glm::uvec2(edge.y, edge.x); // The edge from the POV of the opposite triangle, regardless of whether that exists
+	assert(start.triangle < triangles.size());
+
+	// start.indices is a CCW rotation of its triangle, so the edge we're on is the one starting at indices.x
+	glm::uvec3 const& tri = triangles[start.triangle];
+	uint32_t k = (tri.x == start.indices.x) ? 0 : ((tri.y == start.indices.x) ? 1 : 2);
+	assert(tri[k] == start.indices.x && tri[(k + 1) % 3] == start.indices.y);
 
 	// Checking if the edge we're on is a boundary edge:
-	// Since we maintained counter clock wise order in the triangle we started in, we can
-	// reverse the order of the edge endpoints to discover the third point of the adjacent
-	// triangle that we want to cross over into.
-	// We're using find here since there SHOULDN'T be an entry if this is a boundary edge.
-	auto opEdgeIt = next_vertex.find(opEdge);
-	if(opEdgeIt != next_vertex.end())
+	// The adjacent triangle has the same edge running the other way, which is what adjacency stores
+	uint32_t across = adjacency[3 * start.triangle + k];
+	if(across != -1U)
 	{
+		uint32_t opTri = across / 3;
+		uint32_t opK = across % 3;
+		glm::uvec3 const& op = triangles[opTri];
+		assert(op[opK] == start.indices.y && op[(opK + 1) % 3] == start.indices.x);
+
 		//make 'end' represent the same (world) point, but on triangle (edge.y, edge.x, [other point]):
-		end = WalkPoint(glm::uvec3(opEdge.x, opEdge.y, opEdgeIt->second), glm::vec3(start.weights.y, start.weights.x, 0.0f));
+		end = WalkPoint(glm::uvec3(op[opK], op[(opK + 1) % 3], op[(opK + 2) % 3]), glm::vec3(start.weights.y, start.weights.x, 0.0f), opTri);
 
 		//make 'rotation' the rotation that takes (start.indices)'s normal to (end.indices)'s normal:
 		glm::vec3 const startN = to_world_triangle_normal(start);
@@ -1,11 +1,11 @@
 #pragma once
 
 #include <glm/glm.hpp>
-#include <glm/gtx/hash.hpp> //allows the use of 'uvec2' as an unordered_map key
 
 #include <vector>
 #include <string>
 #include <unordered_map>
+#include <limits>
 
 //"WalkPoint" represents location on the WalkMesh as barycentric coordinates on a triangle:
 struct WalkPoint {
@@ -14,7 +14,9 @@ struct WalkPoint {
 	//barycentric coordinates for current point:
 	glm::vec3 weights = glm::vec3(std::numeric_limits< float >::quiet_NaN());
 	//NOTE: by convention, if WalkPoint is on an edge, indices/weights will be arranged so that weights.z will be 0.0.
-	WalkPoint(glm::uvec3 const &indices_, glm::vec3 const &weights_) : indices(indices_), weights(weights_) { }
+	//index into WalkMesh::triangles of the triangle 'indices' is a rotation of:
+	uint32_t triangle = -1U;
+	WalkPoint(glm::uvec3 const &indices_, glm::vec3 const &weights_, uint32_t triangle_) : indices(indices_), weights(weights_), triangle(triangle_) { }
 	WalkPoint() = default;
 };
 
@@ -24,16 +26,35 @@ struct WalkMesh {
 	std::vector< glm::vec3 > normals; //normals for interpolated 'up' direction
 	std::vector< glm::uvec3 > triangles; //CCW-oriented
 
-	//This "next vertex" map includes [a,b]->c, [b,c]->a, and [c,a]->b for each triangle (a,b,c), and is useful for checking what's over an edge from a given point:
-	std::unordered_map< glm::uvec2, uint32_t > next_vertex;
+	//Edge adjacency, three entries per triangle: adjacency[3*t+k] is what's across edge k of triangle t
+	// (edge k runs from triangles[t][k] to triangles[t][(k+1)%3]), stored as 3*t'+k' for the matching
+	// edge of the neighbouring triangle t', or -1U if it's a boundary edge:
+	std::vector< uint32_t > adjacency;
 
-	//Construct new WalkMesh and build next_vertex structure:
+	//Construct new WalkMesh and build adjacency structure:
 	WalkMesh(std::vector< glm::vec3 > const &vertices_, std::vector< glm::vec3 > const &normals_, std::vector< glm::uvec3 > const &triangles_);
 
 	//used to initialize walking -- finds the closest point on the walk mesh:
-	// (should only need to call this at the start of a level)
+	// (answered from the triangle BVH; same result as the linear scan, ties go to the lowest triangle index)
 	WalkPoint nearest_walk_point(glm::vec3 const &world_point) const;
 
+	//reference version that checks every triangle, handy for checking the BVH:
+	WalkPoint nearest_walk_point_linear(glm::vec3 const &world_point) const;
+
+	//closest point on triangle 'tri' to world_point, returns the squared distance:
+	float closest_on_triangle(uint32_t tri, glm::vec3 const &world_point, WalkPoint *closest) const;
+
+	//Bounding volume hierarchy over triangles, built along with adjacency:
+	struct BVHNode {
+		glm::vec3 min = glm::vec3( std::numeric_limits< float >::infinity());
+		glm::vec3 max = glm::vec3(-std::numeric_limits< float >::infinity());
+		uint32_t first = 0; //leaf: first entry in bvh_triangles; interior: index of second child (first child is the next node)
+		uint32_t count = 0; //leaf: number of triangles; interior: 0
+	};
+	std::vector< BVHNode > bvh_nodes; //root is bvh_nodes[0]
+	std::vector< uint32_t > bvh_triangles; //triangle indices, leaves reference contiguous runs
+	void build_bvh();
+
 
 	//take a step on a triangle, stopping at edges:
 	//  if the step stays within the triangle:
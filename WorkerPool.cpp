@@ -0,0 +1,92 @@
+#include "WorkerPool.hpp"
+
+#include <algorithm>
+
+WorkerPool::WorkerPool(size_t threads)
+{
+	workers.reserve(threads);
+	for(size_t i = 0; i < threads; i++)
+	{
+		workers.emplace_back(&WorkerPool::work, this);
+	}
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quitting = true;
+	}
+	wake.notify_all();
+	for(std::thread& t : workers)
+	{
+		t.join();
+	}
+}
+
+size_t WorkerPool::default_threads()
+{
+	size_t hw = std::thread::hardware_concurrency(); // 0 if it doesn't know
+	return (hw > 1) ? hw - 1 : 0;
+}
+
+void WorkerPool::parallel_for(size_t count_, size_t grain_, std::function<void(size_t, size_t)> const& job_)
+{
+	if(count_ == 0) return;
+	grain_ = std::max<size_t>(grain_, 1);
+
+	// Not worth waking anyone up for
+	if(workers.empty() || count_ <= grain_)
+	{
+		job_(0, count_);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		job = &job_;
+		count = count_;
+		grain = grain_;
+		next = 0;
+		busy = workers.size();
+		generation++;
+	}
+	wake.notify_all();
+
+	run_chunks();
+
+	std::unique_lock<std::mutex> lock(mutex);
+	done.wait(lock, [this]() { return busy == 0; });
+	job = nullptr;
+}
+
+void WorkerPool::work()
+{
+	uint64_t seen = 0;
+	std::unique_lock<std::mutex> lock(mutex);
+	while(true)
+	{
+		wake.wait(lock, [this, seen]() { return quitting || generation != seen; });
+		if(quitting) return;
+		seen = generation;
+
+		lock.unlock();
+		run_chunks();
+		lock.lock();
+
+		if(--busy == 0)
+		{
+			done.notify_one();
+		}
+	}
+}
+
+void WorkerPool::run_chunks()
+{
+	while(true)
+	{
+		size_t begin = next.fetch_add(grain);
+		if(begin >= count) break;
+		(*job)(begin, std::min(begin + grain, count));
+	}
+}
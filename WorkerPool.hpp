@@ -0,0 +1,53 @@
+#ifndef WORKER_POOL_HPP
+#define WORKER_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads for splitting a loop over many items
+// The thread calling parallel_for helps out, so a pool with 0 threads just runs everything inline
+struct WorkerPool
+{
+	WorkerPool(size_t threads = default_threads());
+	~WorkerPool();
+	WorkerPool(WorkerPool const&) = delete;
+	WorkerPool& operator=(WorkerPool const&) = delete;
+
+	// One less than the hardware threads, since the main thread works too
+	static size_t default_threads();
+
+	// How many threads end up running jobs, including the caller
+	size_t size() const { return workers.size() + 1; }
+
+	// Calls job(begin, end) over disjoint ranges covering [0, count), at most grain items each, and returns when they're all done
+	// Ranges are handed out first come first serve, so job should only write to its own items if the result has to be
+	// the same regardless of thread count
+	void parallel_for(size_t count, size_t grain, std::function<void(size_t, size_t)> const& job);
+
+private:
+	void work();
+	void run_chunks();
+
+	std::vector<std::thread> workers;
+
+	std::mutex mutex;
+	std::condition_variable wake; // New job or quitting
+	std::condition_variable done; // Last worker finished the job
+	uint64_t generation = 0; // Bumped for every job, so workers know they haven't run it yet
+	bool quitting = false;
+	size_t busy = 0; // Workers that haven't finished the current job
+
+	// Current job, only touched under the mutex or while busy > 0
+	std::function<void(size_t, size_t)> const* job = nullptr;
+	size_t count = 0;
+	size_t grain = 1;
+	std::atomic<size_t> next{0};
+};
+
+#endif
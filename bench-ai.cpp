@@ -0,0 +1,349 @@
+// Timings for the enemy behavior trees, from 100 to 10k agents: Crowd::sense, then BT::think with tick and with react,
+// against the pointer trees every enemy used to new up for itself (the old BehaviorTree, cut down to what it ran)
+// Build with 'node Maekfile.js tests/bench-ai' and run it, it exits non-zero if the three ever decide differently
+
+#include "BT.hpp"
+#include "SimClock.hpp"
+#include "WorkerPool.hpp"
+
+#include <glm/glm.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <list>
+#include <random>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+static double seconds_since(Clock::time_point start)
+{
+	return std::chrono::duration< double >(Clock::now() - start).count();
+}
+
+static int failures = 0;
+
+static float const STEP = 1.0f / 120.0f;
+
+// What the old tree read and wrote, PawnControl's fields standing in for the pawn's
+struct OldBlackBoard
+{
+	float distanceToPlayer = 100.0f;
+	bool isBoss = false;
+	bool isVertical = false;
+	glm::vec3 move = glm::vec3(0.0f);
+	float rotate = 0.0f;
+	uint8_t attack = 0;
+	uint8_t parry = 0;
+	SimClock const* clock = nullptr;
+	glm::vec3 const* player = nullptr;
+	glm::vec3 const* enemy = nullptr;
+};
+
+// Virtual nodes, children in a std::list, each one its own allocation, same as before
+struct OldNode
+{
+	virtual ~OldNode()
+	{
+		for(OldNode* child : children)
+		{
+			delete child;
+		}
+	}
+	virtual bool run() = 0;
+	std::list<OldNode*> children;
+};
+
+struct OldSelector : OldNode
+{
+	bool run() override
+	{
+		for(OldNode* child : children)
+		{
+			if(child->run()) return true;
+		}
+		return false;
+	}
+};
+
+struct OldSequence : OldNode
+{
+	bool run() override
+	{
+		for(OldNode* child : children)
+		{
+			if(!child->run()) return false;
+		}
+		return true;
+	}
+};
+
+struct OldPlayerExists : OldNode
+{
+	OldPlayerExists(OldBlackBoard* status_, bool negate_) : status(status_), negate(negate_) {}
+	bool run() override
+	{
+		if(!status->player) return negate;
+		status->distanceToPlayer = glm::length(*status->player - *status->enemy);
+		return !negate;
+	}
+	OldBlackBoard* status;
+	bool negate;
+};
+
+struct OldCheckDistance : OldNode
+{
+	OldCheckDistance(OldBlackBoard* status_, float max_, float min_) : status(status_), max(max_), min(min_) {}
+	bool run() override
+	{
+		return status->distanceToPlayer < max && status->distanceToPlayer > min;
+	}
+	OldBlackBoard* status;
+	float max;
+	float min;
+};
+
+struct OldWalkToPlayer : OldNode
+{
+	OldWalkToPlayer(OldBlackBoard* status_) : status(status_) {}
+	bool run() override
+	{
+		if(status->distanceToPlayer > 4.0f)
+		{
+			glm::vec3 diff = *status->player - *status->enemy;
+			status->move = glm::normalize(diff) * 2.0f;
+			status->rotate = std::atan2(diff.y, diff.x);
+		}
+		return true;
+	}
+	OldBlackBoard* status;
+};
+
+struct OldAttack : OldNode
+{
+	OldAttack(OldBlackBoard* status_) : status(status_) {}
+	bool run() override
+	{
+		if(!timer.ready(*status->clock, 5.0f)) return false;
+		if(status->isBoss)
+		{
+			count++;
+			status->attack = (count % 2 == 0) ? 1 : 2;
+		}
+		else
+		{
+			status->attack = status->isVertical ? 1 : 2;
+		}
+		timer.start(*status->clock);
+		return true;
+	}
+	OldBlackBoard* status;
+	SimTimer timer;
+	int count = 0;
+};
+
+struct OldParry : OldNode
+{
+	OldParry(OldBlackBoard* status_) : status(status_) {}
+	bool run() override
+	{
+		if(!timer.ready(*status->clock, 0.0f)) return false;
+		status->parry = 1;
+		timer.start(*status->clock);
+		return true;
+	}
+	OldBlackBoard* status;
+	SimTimer timer;
+};
+
+// One per enemy, built the way BehaviorTree::SoldierBehaviorTree and InitInterruptBoss did
+struct OldBehaviorTree
+{
+	OldBehaviorTree(int type, SimClock const* clock, glm::vec3 const* enemy)
+	{
+		status = new OldBlackBoard();
+		status->isBoss = (type == 0);
+		status->isVertical = (type == 2);
+		status->clock = clock;
+		status->enemy = enemy;
+
+		OldSequence* approach = new OldSequence;
+		approach->children.push_back(new OldCheckDistance(status, 20.0f, 4.5f));
+		approach->children.push_back(new OldWalkToPlayer(status));
+		OldSequence* attack = new OldSequence;
+		attack->children.push_back(new OldCheckDistance(status, 4.5f, 0.0f));
+		attack->children.push_back(new OldAttack(status));
+		OldSelector* choose = new OldSelector;
+		choose->children.push_back(approach);
+		choose->children.push_back(attack);
+		OldSequence* fight = new OldSequence;
+		fight->children.push_back(choose);
+		OldSelector* selector = new OldSelector;
+		selector->children.push_back(new OldPlayerExists(status, true));
+		selector->children.push_back(fight);
+		root = new OldSequence;
+		root->children.push_back(selector);
+
+		if(status->isBoss)
+		{
+			interrupt = new OldSequence;
+			interrupt->children.push_back(new OldCheckDistance(status, 4.5f, 0.0f));
+			interrupt->children.push_back(new OldParry(status));
+		}
+	}
+	~OldBehaviorTree()
+	{
+		delete root;
+		delete interrupt;
+		delete status;
+	}
+
+	// The old tick only measured the distance on the way through the root, so the interrupt read whatever the last
+	// root tick left there. Measured up front here so it decides off the same distance as BT does
+	void tick(bool playerAttacking)
+	{
+		if(status->player)
+		{
+			status->distanceToPlayer = glm::length(*status->player - *status->enemy);
+		}
+		if(interrupt && status->player && playerAttacking)
+		{
+			interrupt->run();
+			return;
+		}
+		root->run();
+	}
+
+	OldBlackBoard* status = nullptr;
+	OldNode* root = nullptr;
+	OldNode* interrupt = nullptr;
+};
+
+static bool same(BT::Agent const& agent, OldBlackBoard const& old)
+{
+	return glm::length(agent.move - old.move) <= 1e-4f && agent.attack == old.attack && agent.parry == old.parry;
+}
+
+// Everyone scattered around the player at the origin, most of them out of reach on the bigger fields, and all three
+// ways deciding from the same spots every step (moved along by what tick decided)
+static void ticks()
+{
+	std::cout << "ticks per simulated step, agents scattered around the player about 3 apart (whatever the count)" << std::endl;
+
+	for(size_t count : {100, 1000, 10000})
+	{
+		std::mt19937 rng(1);
+		float side = 3.0f * std::sqrt((float)count);
+		std::uniform_real_distribution<float> place(-0.5f * side, 0.5f * side);
+		std::vector<glm::vec3> positions(count);
+		for(glm::vec3& p : positions)
+		{
+			p = glm::vec3(place(rng), place(rng), 0.0f);
+		}
+		glm::vec3 const player = glm::vec3(0.0f);
+
+		WorkerPool pool(0);
+		SimClock clock;
+		std::vector<BT::Agent> ticked;
+		std::vector<BT::Agent> reacting;
+		std::vector<OldBehaviorTree*> olds;
+		for(size_t i = 0; i < count; i++)
+		{
+			int type = (int)(i % 3);
+			ticked.emplace_back(type == 0 ? &BT::Tree::boss() : &BT::Tree::soldier(), type);
+			reacting.emplace_back(type == 0 ? &BT::Tree::boss() : &BT::Tree::soldier(), type);
+			olds.push_back(new OldBehaviorTree(type, &clock, &positions[i]));
+			olds.back()->status->player = &player;
+		}
+		std::vector<BT::Agent*> tickers;
+		std::vector<BT::Agent*> reactors;
+		for(size_t i = 0; i < count; i++)
+		{
+			tickers.push_back(&ticked[i]);
+			reactors.push_back(&reacting[i]);
+		}
+
+		// Ten simulated seconds, the player swinging for one second in seven
+		size_t const STEPS = 1200;
+		BT::Crowd crowd;
+		double senseSeconds = 0.0;
+		double tickSeconds = 0.0;
+		double reactSeconds = 0.0;
+		double oldSeconds = 0.0;
+		size_t mismatches = 0;
+		size_t swings = 0;
+		for(size_t s = 0; s < STEPS; s++)
+		{
+			clock.advance(STEP);
+			bool attacking = (s / 120) % 7 == 0;
+
+			Clock::time_point start = Clock::now();
+			crowd.clear();
+			for(glm::vec3 const& p : positions)
+			{
+				crowd.add(p);
+			}
+			crowd.sense(player, pool);
+			senseSeconds += seconds_since(start);
+
+			start = Clock::now();
+			BT::think(crowd, tickers, true, attacking, clock, pool, false);
+			tickSeconds += seconds_since(start);
+
+			start = Clock::now();
+			BT::think(crowd, reactors, true, attacking, clock, pool, true);
+			reactSeconds += seconds_since(start);
+
+			start = Clock::now();
+			for(OldBehaviorTree* old : olds)
+			{
+				old->tick(attacking);
+			}
+			oldSeconds += seconds_since(start);
+
+			for(size_t i = 0; i < count; i++)
+			{
+				OldBlackBoard& old = *olds[i]->status;
+				mismatches += !same(ticked[i], old) || !same(reacting[i], old);
+				swings += (ticked[i].attack != 0);
+				positions[i] += ticked[i].move * STEP;
+				for(BT::Agent* agent : {&ticked[i], &reacting[i]})
+				{
+					agent->move = glm::vec3(0.0f);
+					agent->attack = 0;
+					agent->parry = 0;
+				}
+				old.move = glm::vec3(0.0f);
+				old.attack = 0;
+				old.parry = 0;
+			}
+		}
+		for(OldBehaviorTree* old : olds)
+		{
+			delete old;
+		}
+
+		double ticks = (double)count * STEPS;
+		std::cout << "  " << count << " agents: sense " << 1e6 * senseSeconds / STEPS << " us, think with tick " << 1e6 * tickSeconds / STEPS
+				  << " us (" << 1e9 * tickSeconds / ticks << " ns per agent), with react " << 1e6 * reactSeconds / STEPS << " us ("
+				  << 1e9 * reactSeconds / ticks << " ns), old trees " << 1e6 * oldSeconds / STEPS << " us (" << 1e9 * oldSeconds / ticks
+				  << " ns); " << swings << " swings, " << mismatches << " decisions differ" << std::endl;
+		if(mismatches)
+		{
+			failures++;
+		}
+	}
+}
+
+int main()
+{
+	ticks();
+
+	if(failures)
+	{
+		std::cout << failures << " failed" << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,455 @@
+// Timings for CollisionEngine, printed as a table per section. Nothing here fails, it's for comparing numbers
+// before and after a change on the same machine
+// Build with 'node Maekfile.js tests/bench-collisions' and run it
+
+#include "Collisions.hpp"
+#include "Scene.hpp"
+#include "data_path.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <set>
+#include <thread>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+static double seconds_since(Clock::time_point start)
+{
+	return std::chrono::duration< double >(Clock::now() - start).count();
+}
+
+static std::vector<glm::vec3> box(glm::vec3 const& half)
+{
+	std::vector<glm::vec3> vertices;
+	for(int i = 0; i < 8; i++)
+	{
+		vertices.emplace_back((i & 1) ? half.x : -half.x, (i & 2) ? half.y : -half.y, (i & 4) ? half.z : -half.z);
+	}
+	return vertices;
+}
+
+// Unit boxes scattered over the ground at the same density whatever the count (about one neighbor each), jiggled a
+// little before every update so the sweep has to re-sort
+struct Field
+{
+	Field(size_t count, CollideMesh const* mesh) : rng(1), jitter(-0.05f, 0.05f), pool(0), engine(pool)
+	{
+		float side = std::sqrt((float)count) * 2.5f;
+		std::uniform_real_distribution<float> place(0.0f, side);
+		for(size_t i = 0; i < count; i++)
+		{
+			scene.transforms.emplace_back();
+			transforms.push_back(&scene.transforms.back());
+			transforms.back()->position = glm::vec3(place(rng), place(rng), 0.0f);
+			engine.registerCollider(Game::CreatureID(), transforms.back(), mesh, mesh->containingRadius, [](CollisionEvent const&) {},
+				(CollisionEngine::Layer)(i % CollisionEngine::LAYER_COUNT));
+		}
+	}
+
+	void set_layers(bool interact)
+	{
+		for(size_t l = 0; l < CollisionEngine::LAYER_COUNT; l++)
+		{
+			for(size_t m = 0; m < CollisionEngine::LAYER_COUNT; m++)
+			{
+				engine.LayerMatrix[l][m] = interact;
+			}
+		}
+	}
+
+	void jiggle()
+	{
+		for(Scene::Transform* t : transforms)
+		{
+			t->position += glm::vec3(jitter(rng), jitter(rng), 0.0f);
+		}
+		scene.update_world_transforms();
+	}
+
+	// Average seconds per engine update
+	double time_updates(size_t updates)
+	{
+		double seconds = 0.0;
+		for(size_t u = 0; u < updates; u++)
+		{
+			jiggle();
+			Clock::time_point start = Clock::now();
+			engine.update(1.0f / 60.0f);
+			seconds += seconds_since(start);
+		}
+		return seconds / updates;
+	}
+
+	std::mt19937 rng;
+	std::uniform_real_distribution<float> jitter;
+	Scene scene;
+	WorkerPool pool;
+	CollisionEngine engine;
+	std::vector<Scene::Transform*> transforms;
+};
+
+// With the layer matrix all off nothing gets past the sweep, so that's the broad phase on its own (gathering
+// matrices, sorting, sweeping). All on, every overlapping sphere goes on to GJK too
+static void broad_phase_scaling()
+{
+	std::cout << "broad phase scaling" << std::endl;
+
+	CollideMesh const unitBox(box(glm::vec3(0.5f)), std::sqrt(0.75f));
+
+	for(size_t count : {10, 30, 100, 300, 1000})
+	{
+		// Enough updates that even 10 colliders take a measurable while
+		size_t updates = 200000 / count;
+
+		Field field(count, &unitBox);
+		field.set_layers(false);
+		double broadSeconds = field.time_updates(updates);
+		field.set_layers(true);
+		double fullSeconds = field.time_updates(updates);
+
+		// The same bounding sphere test over every pair, what the sweep saves us from
+		size_t candidates = 0;
+		Clock::time_point start = Clock::now();
+		for(size_t u = 0; u < updates; u++)
+		{
+			for(size_t i = 0; i < count; i++)
+			{
+				for(size_t j = i + 1; j < count; j++)
+				{
+					float reach = 2.0f * unitBox.containingRadius;
+					glm::vec3 between = field.transforms[j]->position - field.transforms[i]->position;
+					candidates += (glm::dot(between, between) <= reach * reach);
+				}
+			}
+		}
+		double bruteSeconds = seconds_since(start) / updates;
+
+		std::cout << "  " << count << " colliders: broad phase " << 1e6 * broadSeconds << " us (" << 1e6 * broadSeconds / count
+				  << " per collider), with narrow phase " << 1e6 * fullSeconds << " us for " << (double)candidates / updates
+				  << " pairs, all-pairs sphere test " << 1e6 * bruteSeconds << " us" << std::endl;
+	}
+}
+
+// Colliders dying and coming back all game long, the way enemies do: a field of unit boxes where every update a few
+// get unregistered and registered again in the same spot under a new id, some of them from inside a BEGIN callback.
+// Each window should cost about the same as the first, and every collider should hear BEGIN, STAY... END in order
+struct Soak
+{
+	struct Slot
+	{
+		Scene::Transform* transform = nullptr;
+		CollisionEngine::ID id = 0;
+		slots_gen_t life = 0;
+		std::set<std::pair<size_t, slots_gen_t>> touching; // Who this life has heard BEGIN from and no END yet
+	};
+
+	Soak(size_t count, CollideMesh const* mesh_) : rng(1), jitter(-0.05f, 0.05f), pool(0), engine(pool), mesh(mesh_)
+	{
+		float side = std::sqrt((float)count) * 2.5f;
+		std::uniform_real_distribution<float> place(0.0f, side);
+		slots.resize(count);
+		for(size_t s = 0; s < count; s++)
+		{
+			scene.transforms.emplace_back();
+			slots[s].transform = &scene.transforms.back();
+			slots[s].transform->position = glm::vec3(place(rng), place(rng), 0.0f);
+			spawn(s);
+		}
+		for(size_t l = 0; l < CollisionEngine::LAYER_COUNT; l++)
+		{
+			for(size_t m = 0; m < CollisionEngine::LAYER_COUNT; m++)
+			{
+				engine.LayerMatrix[l][m] = true;
+			}
+		}
+	}
+
+	void spawn(size_t s)
+	{
+		Slot& slot = slots[s];
+		slots_gen_t life = slot.life;
+		slot.id = engine.registerCollider(Game::CreatureID(s, life), slot.transform, mesh, mesh->containingRadius,
+			[this, s, life](CollisionEvent const& e) { heard(s, life, e); },
+			(CollisionEngine::Layer)(s % CollisionEngine::LAYER_COUNT));
+	}
+
+	void respawn(size_t s)
+	{
+		engine.unregisterCollider(slots[s].id);
+		slots[s].life++;
+		slots[s].touching.clear();
+		spawn(s);
+		respawns++;
+	}
+
+	void heard(size_t s, slots_gen_t life, CollisionEvent const& e)
+	{
+		events++;
+		Slot& slot = slots[s];
+		if(life != slot.life)
+		{
+			misheard++; // Went to a collider that was already unregistered
+			return;
+		}
+		auto key = std::make_pair(e.other.idx, e.other.gen);
+		bool was = slot.touching.count(key);
+		if(e.phase == CollisionEvent::BEGIN)
+		{
+			misheard += was;
+			slot.touching.insert(key);
+			// Now and then whatever we just hit dies and comes back right away, mid-dispatch
+			if(callbackKill(rng) == 0 && e.other.gen == slots[e.other.idx].life)
+			{
+				respawn(e.other.idx);
+			}
+		}
+		else
+		{
+			misheard += !was;
+			if(e.phase == CollisionEvent::END)
+			{
+				slot.touching.erase(key);
+			}
+		}
+	}
+
+	void step()
+	{
+		std::uniform_int_distribution<size_t> pick(0, slots.size() - 1);
+		for(int k = 0; k < 5; k++)
+		{
+			respawn(pick(rng));
+		}
+		for(Slot& slot : slots)
+		{
+			slot.transform->position += glm::vec3(jitter(rng), jitter(rng), 0.0f);
+		}
+		scene.update_world_transforms();
+	}
+
+	// Partners that died go quiet without an END, so their half-finished pairs get forgotten here
+	void forget_dead()
+	{
+		for(Slot& slot : slots)
+		{
+			for(auto it = slot.touching.begin(); it != slot.touching.end();)
+			{
+				it = (it->second != slots[it->first].life) ? slot.touching.erase(it) : std::next(it);
+			}
+		}
+	}
+
+	std::mt19937 rng;
+	std::uniform_real_distribution<float> jitter;
+	std::uniform_int_distribution<int> callbackKill = std::uniform_int_distribution<int>(0, 49);
+	Scene scene;
+	WorkerPool pool;
+	CollisionEngine engine;
+	CollideMesh const* mesh;
+	std::vector<Slot> slots;
+	size_t events = 0;
+	size_t respawns = 0;
+	size_t misheard = 0;
+};
+
+static void spawn_kill_soak()
+{
+	std::cout << "spawn/kill soak (300 colliders, 5 respawned per update plus 1 in 50 BEGINs, 10000 updates)" << std::endl;
+
+	CollideMesh const unitBox(box(glm::vec3(0.5f)), std::sqrt(0.75f));
+	Soak soak(300, &unitBox);
+
+	size_t const WINDOW = 1000;
+	for(size_t w = 0; w < 10; w++)
+	{
+		size_t events = soak.events;
+		size_t respawns = soak.respawns;
+		size_t misheard = soak.misheard;
+		double seconds = 0.0;
+		for(size_t u = 0; u < WINDOW; u++)
+		{
+			soak.step();
+			Clock::time_point start = Clock::now();
+			soak.engine.update(1.0f / 60.0f);
+			seconds += seconds_since(start);
+			soak.forget_dead();
+		}
+		std::cout << "  updates " << w * WINDOW << "-" << (w + 1) * WINDOW - 1 << ": " << 1e6 * seconds / WINDOW << " us per update, "
+				  << (double)(soak.events - events) / WINDOW << " events, " << (double)(soak.respawns - respawns) / WINDOW << " respawns, "
+				  << soak.misheard - misheard << " events out of order" << std::endl;
+	}
+	std::cout << "  " << soak.respawns << " respawns in all, " << soak.events << " events" << std::endl;
+}
+
+// Player swords against enemy bodies, each pair far from the others so the broad phase hands over exactly one pair
+// per sword, with the sword somewhere inside the bounding spheres' reach so every pair gets tested
+struct Duels
+{
+	Duels(CollideMesh const& sword, CollideMesh const& body, size_t count, WorkerPool& pool)
+		: rng(1), unit(-1.0f, 1.0f), reach(sword.containingRadius + body.containingRadius), engine(pool)
+	{
+		for(size_t i = 0; i < count; i++)
+		{
+			scene.transforms.emplace_back();
+			scene.transforms.back().position = glm::vec3(10.0f * reach * i, 0.0f, 0.0f);
+			engine.registerCollider(Game::CreatureID(), &scene.transforms.back(), &body, body.containingRadius,
+				[](CollisionEvent const&) {}, CollisionEngine::ENEMY_BODY_LAYER);
+
+			scene.transforms.emplace_back();
+			swords.push_back(&scene.transforms.back());
+			engine.registerCollider(Game::CreatureID(), swords.back(), &sword, sword.containingRadius,
+				[this](CollisionEvent const& e) { touching += (e.phase != CollisionEvent::END); },
+				CollisionEngine::PLAYER_SWORD_LAYER);
+		}
+		pose();
+	}
+
+	// Every sword somewhere new around its body
+	void pose()
+	{
+		for(size_t i = 0; i < swords.size(); i++)
+		{
+			glm::vec3 away = glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)));
+			swords[i]->position = glm::vec3(10.0f * reach * i, 0.0f, 0.0f) + 0.5f * (unit(rng) + 1.0f) * 0.9f * reach * away;
+			swords[i]->rotation = glm::normalize(glm::quat(unit(rng), unit(rng), unit(rng), unit(rng)));
+		}
+		scene.update_world_transforms();
+	}
+
+	// Total seconds in engine updates, with swords and bodies interacting or not (not is everything but the narrow phase)
+	// Still pairs stay put (GJK gets its cached axis and hints right every time), moving ones get a new pose every update
+	double run(bool interact, bool moving, size_t updates)
+	{
+		engine.LayerMatrix[CollisionEngine::PLAYER_SWORD_LAYER][CollisionEngine::ENEMY_BODY_LAYER] = interact;
+		engine.LayerMatrix[CollisionEngine::ENEMY_BODY_LAYER][CollisionEngine::PLAYER_SWORD_LAYER] = interact;
+		touching = 0;
+		double seconds = 0.0;
+		for(size_t u = 0; u < updates; u++)
+		{
+			if(moving)
+			{
+				pose();
+			}
+			Clock::time_point start = Clock::now();
+			engine.update(1.0f / 60.0f);
+			seconds += seconds_since(start);
+		}
+		return seconds;
+	}
+
+	std::mt19937 rng;
+	std::uniform_real_distribution<float> unit;
+	float reach;
+	Scene scene;
+	CollisionEngine engine;
+	std::vector<Scene::Transform*> swords;
+	size_t touching = 0; // Sword events from the last run
+};
+
+static void gjk_pairs(CollideMesh const& sword, CollideMesh const& body)
+{
+	std::cout << "GJK pair tests, PlayerSwordCollMesh against EnemyCollMesh from dist/sword.c (" << sword.vertices.size() << " and "
+			  << body.vertices.size() << " vertices)" << std::endl;
+
+	size_t const PAIRS = 500;
+	size_t const UPDATES = 400;
+
+	for(bool moving : {false, true})
+	{
+		WorkerPool pool(0);
+		Duels duels(sword, body, PAIRS, pool);
+		double broadSeconds = duels.run(false, moving, UPDATES);
+		double fullSeconds = duels.run(true, moving, UPDATES);
+
+		double tests = (double)PAIRS * UPDATES;
+		std::cout << "  " << (moving ? "moving: " : "still: ") << 1e-6 * tests / (fullSeconds - broadSeconds) << "M pair tests/s ("
+				  << 1e9 * (fullSeconds - broadSeconds) / tests << " ns each, on top of " << 1e9 * broadSeconds / tests
+				  << " ns of broad phase), " << 100.0 * duels.touching / tests << "% touching" << std::endl;
+	}
+}
+
+// The closed form primitive tests against GJK, for the game's boxes: both sides primitives, one side a hull (GJK on
+// the primitive's vertices, what a primitive against the player's sword gets), and both hulls (what everything got before)
+static void primitive_pairs(CollideMesh const& sword, CollideMesh const& body)
+{
+	std::cout << "primitive pair tests, EnemySwordCollMesh against PlayerCollMesh from dist/sword.c (both boxes, " << sword.vertices.size()
+			  << " and " << body.vertices.size() << " vertices as hulls)" << std::endl;
+
+	CollideMesh const swordHull(sword.vertices, sword.containingRadius, sword.adjacencyStart, sword.adjacency);
+	CollideMesh const bodyHull(body.vertices, body.containingRadius, body.adjacencyStart, body.adjacency);
+	// The body is a cylinder, so its box sticks out at the corners, this is the box itself as a hull to compare like with like
+	std::vector<glm::vec3> corners = box(body.primitive.b);
+	for(glm::vec3& v : corners)
+	{
+		v += body.primitive.a;
+	}
+	CollideMesh const bodyBox(corners, body.containingRadius);
+
+	size_t const PAIRS = 500;
+	size_t const UPDATES = 400;
+
+	struct Case
+	{
+		char const* name;
+		CollideMesh const* sword;
+		CollideMesh const* body;
+	};
+	for(Case const& c : {Case{"box / box", &sword, &body}, Case{"box / hull", &sword, &bodyHull}, Case{"hull / hull", &swordHull, &bodyHull},
+		Case{"hull / box as a hull", &swordHull, &bodyBox}})
+	{
+		WorkerPool pool(0);
+		Duels duels(*c.sword, *c.body, PAIRS, pool);
+		double broadSeconds = duels.run(false, true, UPDATES);
+		double fullSeconds = duels.run(true, true, UPDATES);
+
+		double tests = (double)PAIRS * UPDATES;
+		std::cout << "  " << c.name << ": " << 1e-6 * tests / (fullSeconds - broadSeconds) << "M pair tests/s ("
+				  << 1e9 * (fullSeconds - broadSeconds) / tests << " ns each), " << 100.0 * duels.touching / tests << "% touching" << std::endl;
+	}
+}
+
+// The same moving pairs with the narrow phase split over more and more threads, speedup is against the caller alone
+// Only means anything on a machine with at least as many cores as the biggest pool
+static void narrow_phase_threads(CollideMesh const& sword, CollideMesh const& body)
+{
+	std::cout << "narrow phase threads, 2000 moving sword / body pairs (" << std::thread::hardware_concurrency() << " hardware threads here)" << std::endl;
+
+	size_t const PAIRS = 2000;
+	size_t const UPDATES = 100;
+
+	double alone = 0.0;
+	for(size_t threads : {1, 2, 4, 8, 16})
+	{
+		WorkerPool pool(threads - 1);
+		Duels duels(sword, body, PAIRS, pool);
+		double broadSeconds = duels.run(false, true, UPDATES);
+		double narrowSeconds = duels.run(true, true, UPDATES) - broadSeconds;
+		if(threads == 1)
+		{
+			alone = narrowSeconds;
+		}
+
+		std::cout << "  " << threads << " threads: narrow phase " << 1e6 * narrowSeconds / UPDATES << " us per update, "
+				  << alone / narrowSeconds << "x, " << duels.touching << " sword events" << std::endl;
+	}
+}
+
+int main()
+{
+	broad_phase_scaling();
+	spawn_kill_soak();
+
+	CollideMeshes meshes(data_path("../dist/sword.c"));
+	CollideMesh const& sword = meshes.lookup("PlayerSwordCollMesh");
+	CollideMesh const& body = meshes.lookup("EnemyCollMesh");
+	gjk_pairs(sword, body);
+	primitive_pairs(meshes.lookup("EnemySwordCollMesh"), meshes.lookup("PlayerCollMesh"));
+	narrow_phase_threads(sword, body);
+	return 0;
+}
@@ -0,0 +1,158 @@
+// Scene::draw_stats for the level, drawn one drawable at a time and through the render queue, against a GL that
+// does nothing (null-GL.cpp), so it runs without a window. Also times the CPU side of each draw
+// Build with 'node Maekfile.js tests/bench-draw' and run it
+
+#include "Scene.hpp"
+#include "data_path.hpp"
+#include "null-GL.hpp"
+
+#include <glm/glm.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+
+typedef std::chrono::steady_clock Clock;
+
+static double seconds_since(Clock::time_point start)
+{
+	return std::chrono::duration< double >(Clock::now() - start).count();
+}
+
+// Stand-ins for the GL objects PlayMode sets up, only their identity matters to the render queue
+static GLuint const PROGRAM = 1;
+static GLuint const INSTANCED_PROGRAM = 2;
+static GLuint const VAO = 3;
+static GLuint const INSTANCED_VAO = 4;
+static GLuint const INSTANCE_BUFFER = 5;
+static GLuint const WHITE_TEX = 10;
+static GLuint const GRASS_TEX = 11;
+static GLuint const TILE_TEX = 12;
+static GLuint const ROCK_TEX = 13;
+static GLuint const PATH_TEX = 14;
+
+// The mesh buffer only decides where each mesh's vertices start, and every mesh gets its own range, so one made up
+// range per name draws the same as the real one
+static std::unordered_map<std::string, GLuint> meshStarts;
+
+static Scene::Drawable::Pipeline pipeline_for(std::string const& mesh_name)
+{
+	Scene::Drawable::Pipeline pipeline;
+	pipeline.program = PROGRAM;
+	pipeline.OBJECT_TO_CLIP_mat4 = 0;
+	pipeline.OBJECT_TO_LIGHT_mat4x3 = 1;
+	pipeline.NORMAL_TO_LIGHT_mat3 = 2;
+	pipeline.instancing.program = INSTANCED_PROGRAM;
+	pipeline.instancing.buffer = INSTANCE_BUFFER;
+	pipeline.instancing.vao = INSTANCED_VAO;
+	pipeline.textures[0].texture = WHITE_TEX;
+	pipeline.textures[0].target = GL_TEXTURE_2D;
+	pipeline.vao = VAO;
+	pipeline.type = GL_TRIANGLES;
+
+	auto found = meshStarts.find(mesh_name);
+	if(found == meshStarts.end())
+	{
+		found = meshStarts.emplace(mesh_name, GLuint(meshStarts.size() * 1000)).first;
+	}
+	pipeline.start = found->second;
+	pipeline.count = 36;
+	return pipeline;
+}
+
+// Same drawables (and textures) as G_SCENE and setupEnemy in PlayMode
+static Scene load_level(size_t enemies)
+{
+	Scene scene(data_path("../dist/sword.scene"),
+		[](Scene& scene, Scene::Transform* transform, std::string const& mesh_name)
+		{
+			if(transform->name.length() >= 5 && transform->name.substr(0, 5) == "Enemy")
+			{
+				return;
+			}
+
+			scene.drawables.emplace_back(transform);
+			Scene::Drawable& drawable = scene.drawables.back();
+			drawable.pipeline = pipeline_for(mesh_name);
+
+			if(transform->name.length() >= 5 && transform->name.substr(0, 5) == "Plane")
+			{
+				drawable.pipeline.textures[0].texture = GRASS_TEX;
+			}
+			else if(transform->name == "Arena")
+			{
+				drawable.pipeline.textures[0].texture = TILE_TEX;
+			}
+			else if(transform->name.length() >= 8 && transform->name.substr(0, 8) == "Mountain")
+			{
+				drawable.pipeline.textures[0].texture = ROCK_TEX;
+			}
+			else if(transform->name.length() >= 4 && transform->name.substr(0, 4) == "Path")
+			{
+				drawable.pipeline.textures[0].texture = PATH_TEX;
+			}
+		});
+
+	for(size_t i = 0; i < enemies; i++)
+	{
+		std::string postfix = ".00" + std::to_string(i % 3 + 1);
+		Scene::Transform* parent = nullptr;
+		for(char const* part : {"Player", "Wrist", "Sword"})
+		{
+			scene.transforms.emplace_back();
+			scene.transforms.back().parent = parent;
+			parent = &scene.transforms.back();
+			scene.drawables.emplace_back(parent);
+			scene.drawables.back().pipeline = pipeline_for(std::string(part) + postfix);
+		}
+	}
+
+	return scene;
+}
+
+static void print_stats(Scene::DrawStats const& stats)
+{
+	std::cout << stats.drawables << " drawables, " << stats.draw_calls << " draw calls, " << stats.program_binds << " program binds, "
+			  << stats.vao_binds << " vao binds, " << stats.texture_binds << " texture binds, " << stats.uniform_uploads
+			  << " uniform uploads, " << stats.buffer_uploads << " buffer uploads";
+}
+
+// Whether draw_stats says the same thing the GL calls did
+static bool matches(Scene::DrawStats const& stats, NullGLCalls const& calls)
+{
+	return stats.draw_calls == calls.draw_calls && stats.program_binds == calls.program_binds && stats.vao_binds == calls.vao_binds
+		&& stats.texture_binds == calls.texture_binds && stats.uniform_uploads == calls.uniform_uploads
+		&& stats.buffer_uploads == calls.buffer_uploads;
+}
+
+int main()
+{
+	std::cout << "draw stats for dist/sword.scene" << std::endl;
+
+	// Nothing but the level, and the level with the enemies of level 5 and level 20 around
+	for(size_t enemies : {0, 12, 47})
+	{
+		Scene scene = load_level(enemies);
+		for(bool queued : {false, true})
+		{
+			scene.render_queue = queued;
+
+			size_t const FRAMES = 20;
+			double seconds = 0.0;
+			for(size_t f = 0; f < FRAMES; f++)
+			{
+				null_gl_calls = NullGLCalls();
+				Clock::time_point start = Clock::now();
+				scene.draw(glm::mat4(1.0f));
+				seconds += seconds_since(start);
+			}
+
+			std::cout << "  " << enemies << " enemies, " << (queued ? "render queue: " : "immediate: ");
+			print_stats(scene.draw_stats);
+			std::cout << ", " << 1e3 * seconds / FRAMES << " ms" << (matches(scene.draw_stats, null_gl_calls) ? "" : " (GL calls DISAGREE)") << std::endl;
+		}
+	}
+
+	return 0;
+}
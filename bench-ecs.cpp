@@ -0,0 +1,456 @@
+// Timings for Slots under spawn/destroy churn, against the fixed creature array and open slot queue Game used to have,
+// and for the per-pawn passes as ECS systems, against looping over the enemy list like PlayMode::update used to
+// Build with 'node Maekfile.js tests/bench-ecs' and run it, it exits non-zero if an id ever resolves after its value
+// was destroyed, or if the systems end up somewhere different from the old loops
+
+#include "ECS.hpp"
+#include "Game.hpp"
+#include "Locomotion.hpp"
+#include "Pawn.hpp"
+#include "Scene.hpp"
+#include "Slots.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <list>
+#include <queue>
+#include <random>
+#include <tuple>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+static double seconds_since(Clock::time_point start)
+{
+	return std::chrono::duration< double >(Clock::now() - start).count();
+}
+
+static int failures = 0;
+
+// What iterating adds up into, so the loops don't get optimized out
+static volatile uint64_t sink = 0;
+
+// About the size of a small component
+struct Thing
+{
+	uint64_t serial; // Which spawn this was, so we can tell whether an id found the right value
+	float data[7];
+};
+
+// Game's creature list as it was (Game.cpp before the slot map), sized at runtime instead of 128, and with spawn
+// writing the slot's gen, which the original forgot to do (so nothing spawned into a reused slot could be found)
+struct OldSlots
+{
+	OldSlots(size_t capacity) : things(capacity, std::make_tuple(nullptr, 0))
+	{
+		for(size_t i = 0; i < capacity; i++)
+		{
+			open.emplace(i, 0);
+		}
+	}
+	~OldSlots()
+	{
+		for(auto& t : things)
+		{
+			delete std::get<0>(t);
+		}
+	}
+
+	SlotID spawn(Thing const& t)
+	{
+		if(open.empty()) return SlotID();
+		SlotID result = open.front();
+		open.pop();
+		things[result.idx] = std::make_tuple(new Thing(t), result.gen);
+		return result;
+	}
+
+	bool destroy(SlotID id)
+	{
+		if(id.idx >= things.size()) return false;
+		auto& t = things[id.idx];
+		if(std::get<1>(t) != id.gen) return false;
+		delete std::get<0>(t);
+		std::get<0>(t) = nullptr;
+		open.emplace(id.idx, id.gen + 1);
+		return true;
+	}
+
+	Thing* get(SlotID id)
+	{
+		if(id.idx >= things.size()) return nullptr;
+		auto& t = things[id.idx];
+		return (std::get<1>(t) == id.gen) ? std::get<0>(t) : nullptr;
+	}
+
+	// Game::update's loop, stopping once it has seen every live one
+	template<typename F>
+	void each(F const& f)
+	{
+		size_t active = things.size() - open.size();
+		size_t seen = 0;
+		for(size_t i = 0; i < things.size() && seen < active; i++)
+		{
+			Thing* t = std::get<0>(things[i]);
+			if(t == nullptr) continue;
+			f(*t);
+			seen++;
+		}
+	}
+
+	std::vector<std::tuple<Thing*, slots_gen_t>> things;
+	std::queue<SlotID> open;
+};
+
+// Slots with the interface OldSlots has, so one churn loop drives both
+struct NewSlots
+{
+	NewSlots(size_t) {}
+
+	SlotID spawn(Thing const& t) { return slots.spawn(t); }
+	bool destroy(SlotID id) { return slots.destroy(id); }
+	Thing* get(SlotID id) { return slots.get(id); }
+	template<typename F>
+	void each(F const& f)
+	{
+		for(Thing& t : slots)
+		{
+			f(t);
+		}
+	}
+
+	Slots<Thing> slots;
+};
+
+struct ChurnResult
+{
+	double spawnSeconds = 0.0;
+	double destroySeconds = 0.0;
+	double getSeconds = 0.0;
+	double iterateSeconds = 0.0;
+	size_t spawns = 0;
+	size_t destroys = 0;
+	size_t gets = 0;
+	size_t iterated = 0;
+	size_t stale = 0; // Destroyed ids that got checked
+	size_t reused = 0; // ...of which a newer value lives in the same slot
+	size_t staleResolved = 0; // ...of which get() or destroy() still accepted (should be none)
+	size_t wrong = 0; // Live ids that resolved to some other value (should be none)
+};
+
+// Keeps live values alive, each round destroys a tenth of them at random, spawns as many back, looks each live one up
+// once and iterates them all. Every id destroyed along the way gets checked at the end
+template<typename Store>
+static ChurnResult churn(size_t live, size_t capacity)
+{
+	ChurnResult result;
+	Store store(capacity);
+
+	std::mt19937 rng(1);
+	uint64_t serial = 0;
+	auto make = [&serial]()
+		{
+			Thing t = Thing();
+			t.serial = serial++;
+			return t;
+		};
+
+	std::vector<std::pair<SlotID, uint64_t>> ids; // Live ids and the serial each should find
+	std::vector<SlotID> stale;
+	auto spawn = [&]()
+		{
+			SlotID id = store.spawn(make());
+			ids.emplace_back(id, serial - 1);
+		};
+	for(size_t i = 0; i < live; i++)
+	{
+		spawn();
+	}
+
+	size_t perRound = std::max<size_t>(1, live / 10);
+	size_t rounds = std::max<size_t>(20, 2000000 / perRound);
+	for(size_t r = 0; r < rounds; r++)
+	{
+		Clock::time_point start = Clock::now();
+		for(size_t i = 0; i < perRound; i++)
+		{
+			size_t pick = std::uniform_int_distribution<size_t>(0, ids.size() - 1)(rng);
+			store.destroy(ids[pick].first);
+			stale.push_back(ids[pick].first);
+			ids[pick] = ids.back();
+			ids.pop_back();
+		}
+		result.destroySeconds += seconds_since(start);
+		result.destroys += perRound;
+
+		start = Clock::now();
+		for(size_t i = 0; i < perRound; i++)
+		{
+			spawn();
+		}
+		result.spawnSeconds += seconds_since(start);
+		result.spawns += perRound;
+
+		uint64_t sum = 0;
+		start = Clock::now();
+		for(auto const& id : ids)
+		{
+			Thing* t = store.get(id.first);
+			sum += t ? t->serial : 0;
+		}
+		result.getSeconds += seconds_since(start);
+		result.gets += ids.size();
+
+		start = Clock::now();
+		store.each([&sum](Thing const& t)
+			{
+				sum += t.serial + (uint64_t)t.data[0];
+			});
+		result.iterateSeconds += seconds_since(start);
+		result.iterated += ids.size();
+		sink = sink + sum;
+
+		// Checking every stale id each round would swamp the timings, so keep at most the last 100k
+		if(stale.size() > 200000)
+		{
+			stale.erase(stale.begin(), stale.begin() + 100000);
+		}
+	}
+
+	for(auto const& id : ids)
+	{
+		Thing* t = store.get(id.first);
+		result.wrong += !(t && t->serial == id.second);
+	}
+
+	// The ones that matter are stale ids whose slot has something new living in it
+	std::vector<bool> inUse(capacity + live * 2, false);
+	for(auto const& id : ids)
+	{
+		if(id.first.idx >= inUse.size()) inUse.resize(id.first.idx + 1, false);
+		inUse[id.first.idx] = true;
+	}
+	for(SlotID const& id : stale)
+	{
+		result.stale++;
+		if(id.idx >= inUse.size() || !inUse[id.idx]) continue;
+		result.reused++;
+		Thing* t = store.get(id);
+		if(t != nullptr || store.destroy(id))
+		{
+			result.staleResolved++;
+		}
+		if(result.reused == 1000) break;
+	}
+
+	return result;
+}
+
+static void print_churn(char const* name, ChurnResult const& r)
+{
+	std::cout << "    " << name << ": spawn " << 1e9 * r.spawnSeconds / r.spawns << " ns, destroy " << 1e9 * r.destroySeconds / r.destroys
+			  << " ns, get " << 1e9 * r.getSeconds / r.gets << " ns, iterate " << 1e9 * r.iterateSeconds / r.iterated
+			  << " ns per value; " << r.staleResolved << " of " << r.reused << " stale ids into reused slots still resolved, "
+			  << r.wrong << " live ids found the wrong value" << std::endl;
+}
+
+static void slots_churn()
+{
+	std::cout << "Slots churn, a tenth of the live values destroyed and respawned per round" << std::endl;
+
+	// 100 live in 128 is the old MAX_CREATURE_COUNT; the old array gets the same 28% headroom at every size
+	for(size_t live : {100, 10000, 100000})
+	{
+		std::cout << "  " << live << " live" << std::endl;
+
+		ChurnResult slots = churn<NewSlots>(live, 0);
+		print_churn("Slots", slots);
+		if(slots.staleResolved || slots.wrong || slots.reused == 0)
+		{
+			failures++;
+		}
+
+		print_churn("old array + queue", churn<OldSlots>(live, live * 128 / 100));
+	}
+}
+
+// An enemy from before the ECS, when stamina lived in the pawn
+struct OldEnemy : Enemy
+{
+	float stamina = 100.0f;
+	float maxstamina = 100.0f;
+	float staminaRegenRate = 10.0f;
+};
+
+// A level's worth of enemies, each one both in Game's creature list (for the old loops) and an entity with
+// components (for the systems). Half of them get killed and replaced before anything is timed, like a few waves in
+struct Horde
+{
+	Horde(size_t count)
+	{
+		std::mt19937 rng(1);
+		for(size_t i = 0; i < count; i++)
+		{
+			spawn(rng);
+		}
+		for(size_t i = 0; i < count / 2; i++)
+		{
+			auto it = enemiesId.begin();
+			std::advance(it, std::uniform_int_distribution<size_t>(0, enemiesId.size() - 1)(rng));
+			OldEnemy* enemy = static_cast<OldEnemy*>(game.getCreature(*it));
+			world.destroy(enemy->entity);
+			// What destroyCreature does, without it printing about every one
+			delete enemy;
+			game.creatures.destroy(*it);
+			enemiesId.erase(it);
+			spawn(rng);
+		}
+		setup_systems();
+	}
+
+	void spawn(std::mt19937& rng)
+	{
+		std::uniform_real_distribution<float> place(-50.0f, 50.0f);
+		std::uniform_real_distribution<float> tired(0.0f, 100.0f);
+
+		scene.transforms.emplace_back();
+		OldEnemy* enemy = new OldEnemy();
+		enemy->transform = &scene.transforms.back();
+		enemy->transform->position = glm::vec3(place(rng), place(rng), 0.0f);
+		enemy->gameplay_tags = "enemy";
+		enemy->stamina = tired(rng);
+		enemy->pawn_control.move = glm::vec3(0.01f * place(rng), 0.01f * place(rng), 0.0f);
+		enemiesId.push_back(game.spawnCreature(enemy));
+
+		enemy->entity = world.spawn(enemy->transform);
+		world.add(enemy->entity, PawnRef{enemy});
+		world.add(enemy->entity, Stamina{enemy->stamina, enemy->maxstamina, enemy->staminaRegenRate});
+		world.add(enemy->entity, SwordHits());
+		world.add(enemy->entity, Locomotion::Walker());
+	}
+
+	// The stamina and control systems from PlayMode::setupSystems, minus the player and processPawnControl
+	void setup_systems()
+	{
+		systems.add("stamina", [](ECS::World& w, float elapsed)
+			{
+				w.each<Stamina>([elapsed](ECS::Entity, Stamina& stamina)
+					{
+						stamina.current = std::min(stamina.current + stamina.regenRate * elapsed, stamina.max);
+					});
+			});
+
+		systems.add("control", [](ECS::World& w, float elapsed)
+			{
+				w.each<Locomotion::Walker, PawnRef>([elapsed](ECS::Entity, Locomotion::Walker& walker, PawnRef& ref)
+					{
+						Pawn& pawn = *ref.pawn;
+						walker.position = pawn.transform->position;
+						walker.radius = pawn.walkCollRad;
+						walker.at = pawn.at;
+						walker.move = pawn.pawn_control.move * elapsed;
+					});
+			});
+	}
+
+	// The same two passes the way PlayMode::update did them, going through the enemy id list
+	void old_update(float elapsed)
+	{
+		for(Game::CreatureID myEnemyID : enemiesId)
+		{
+			OldEnemy* enemyPtr = static_cast<OldEnemy*>(game.getCreature(myEnemyID));
+			enemyPtr->stamina += enemyPtr->staminaRegenRate * elapsed;
+			if(enemyPtr->stamina >= enemyPtr->maxstamina)
+			{
+				enemyPtr->stamina = enemyPtr->maxstamina;
+			}
+		}
+
+		walkers.clear();
+		for(Game::CreatureID myEnemyID : enemiesId)
+		{
+			OldEnemy* enemyPtr = static_cast<OldEnemy*>(game.getCreature(myEnemyID));
+			walkers.emplace_back();
+			Locomotion::Walker& walker = walkers.back();
+			walker.position = enemyPtr->transform->position;
+			walker.radius = enemyPtr->walkCollRad;
+			walker.at = enemyPtr->at;
+			walker.move = enemyPtr->pawn_control.move * elapsed;
+		}
+	}
+
+	// How many enemies' stamina or walker disagree between the two
+	size_t mismatches()
+	{
+		size_t result = 0;
+		size_t w = 0;
+		for(Game::CreatureID myEnemyID : enemiesId)
+		{
+			OldEnemy* enemyPtr = static_cast<OldEnemy*>(game.getCreature(myEnemyID));
+			Stamina* stamina = world.get<Stamina>(enemyPtr->entity);
+			Locomotion::Walker* walker = world.get<Locomotion::Walker>(enemyPtr->entity);
+			result += !(stamina && walker && stamina->current == enemyPtr->stamina && walker->move == walkers[w].move
+				&& walker->position == walkers[w].position);
+			w++;
+		}
+		return result;
+	}
+
+	Scene scene;
+	Game game;
+	std::list<Game::CreatureID> enemiesId;
+	std::vector<Locomotion::Walker> walkers; // What the old loop hands to locomotion
+
+	ECS::World world;
+	ECS::Scheduler systems;
+};
+
+static void pawn_systems()
+{
+	std::cout << "stamina and control passes over every enemy, ECS systems against the old enemy list loops" << std::endl;
+
+	for(size_t count : {1000, 4000, 16000})
+	{
+		Horde horde(count);
+
+		size_t const FRAMES = 200;
+		double systemSeconds = 0.0;
+		double oldSeconds = 0.0;
+		for(size_t f = 0; f < FRAMES; f++)
+		{
+			Clock::time_point start = Clock::now();
+			horde.systems.run(horde.world, 1.0f / 60.0f);
+			systemSeconds += seconds_since(start);
+
+			start = Clock::now();
+			horde.old_update(1.0f / 60.0f);
+			oldSeconds += seconds_since(start);
+		}
+
+		size_t mismatches = horde.mismatches();
+		std::cout << "  " << count << " enemies: systems " << 1e6 * systemSeconds / FRAMES << " us per frame ("
+				  << 1e9 * systemSeconds / FRAMES / count << " ns per enemy), old loops " << 1e6 * oldSeconds / FRAMES << " us ("
+				  << 1e9 * oldSeconds / FRAMES / count << " ns), " << mismatches << " enemies ended up differently" << std::endl;
+		if(mismatches)
+		{
+			failures++;
+		}
+	}
+}
+
+int main()
+{
+	slots_churn();
+	pawn_systems();
+
+	if(failures)
+	{
+		std::cout << failures << " failed" << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,160 @@
+// Timings for Scene's cached world matrices against rebuilding them up the parent chain on every read
+// Build with 'node Maekfile.js tests/bench-scene' and run it
+
+#include "Scene.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+static double seconds_since(Clock::time_point start)
+{
+	return std::chrono::duration< double >(Clock::now() - start).count();
+}
+
+// What the reads add up into, so neither loop gets optimized out
+static volatile float sink = 0.0f;
+
+// Roughly what a level looks like to the transforms: a pile of static props, plus pawns that are a body with a
+// wrist under it and a sword under that
+struct Level
+{
+	Level(size_t props, size_t pawns)
+	{
+		std::mt19937 rng(1);
+		std::uniform_real_distribution<float> place(-50.0f, 50.0f);
+		for(size_t i = 0; i < props; i++)
+		{
+			scene.transforms.emplace_back();
+			scene.transforms.back().position = glm::vec3(place(rng), place(rng), 0.0f);
+			all.push_back(&scene.transforms.back());
+		}
+		for(size_t i = 0; i < pawns; i++)
+		{
+			scene.transforms.emplace_back();
+			Scene::Transform* body = &scene.transforms.back();
+			body->position = glm::vec3(place(rng), place(rng), 1.2f);
+			scene.transforms.emplace_back();
+			Scene::Transform* wrist = &scene.transforms.back();
+			wrist->parent = body;
+			wrist->position = glm::vec3(0.5f, 0.0f, 0.3f);
+			scene.transforms.emplace_back();
+			Scene::Transform* sword = &scene.transforms.back();
+			sword->parent = wrist;
+			sword->position = glm::vec3(0.0f, 0.0f, 0.8f);
+
+			bodies.push_back(body);
+			wrists.push_back(wrist);
+			swords.push_back(sword);
+			all.push_back(body);
+			all.push_back(wrist);
+			all.push_back(sword);
+		}
+	}
+
+	// Every moving'th pawn walks a little and swings its wrist
+	void step(size_t moving, float t)
+	{
+		for(size_t i = 0; i < bodies.size(); i += moving)
+		{
+			bodies[i]->position.x += 0.01f;
+			wrists[i]->rotation = glm::quat(std::cos(t), 0.0f, 0.0f, std::sin(t));
+		}
+	}
+
+	Scene scene;
+	std::vector<Scene::Transform*> all;
+	std::vector<Scene::Transform*> bodies;
+	std::vector<Scene::Transform*> wrists;
+	std::vector<Scene::Transform*> swords;
+};
+
+// One frame's worth of reads: drawing wants every transform's local to world, and the collision engine wants
+// both directions for each body and sword
+static float frame_cached(Level const& level)
+{
+	level.scene.update_world_transforms();
+	float sum = 0.0f;
+	for(Scene::Transform const* t : level.all)
+	{
+		sum += t->get_local_to_world()[3].x;
+	}
+	for(size_t i = 0; i < level.bodies.size(); i++)
+	{
+		sum += level.bodies[i]->get_local_to_world()[3].y + level.bodies[i]->get_world_to_local()[3].y;
+		sum += level.swords[i]->get_local_to_world()[3].y + level.swords[i]->get_world_to_local()[3].y;
+	}
+	return sum;
+}
+
+static float frame_recursive(Level const& level)
+{
+	float sum = 0.0f;
+	for(Scene::Transform const* t : level.all)
+	{
+		sum += t->make_local_to_world()[3].x;
+	}
+	for(size_t i = 0; i < level.bodies.size(); i++)
+	{
+		sum += level.bodies[i]->make_local_to_world()[3].y + level.bodies[i]->make_world_to_local()[3].y;
+		sum += level.swords[i]->make_local_to_world()[3].y + level.swords[i]->make_world_to_local()[3].y;
+	}
+	return sum;
+}
+
+static void world_transforms()
+{
+	std::cout << "world transforms (1000 props, 200 pawns of body, wrist and sword)" << std::endl;
+
+	size_t const FRAMES = 2000;
+	for(size_t moving : {1, 10, 200})
+	{
+		Level level(1000, 200);
+
+		// Both ways, same motion
+		double cachedSeconds = 0.0;
+		double recursiveSeconds = 0.0;
+		for(size_t f = 0; f < FRAMES; f++)
+		{
+			level.step(moving, 0.01f * f);
+
+			Clock::time_point start = Clock::now();
+			sink = sink + frame_cached(level);
+			cachedSeconds += seconds_since(start);
+
+			start = Clock::now();
+			sink = sink + frame_recursive(level);
+			recursiveSeconds += seconds_since(start);
+		}
+
+		// Spot check that the cache agrees with the chain walk on the last frame
+		float worst = 0.0f;
+		for(Scene::Transform const* t : level.all)
+		{
+			glm::mat4x3 cached = t->get_local_to_world();
+			glm::mat4x3 made = t->make_local_to_world();
+			for(int c = 0; c < 4; c++)
+			{
+				worst = std::max(worst, glm::length(cached[c] - made[c]));
+			}
+		}
+
+		std::cout << "  " << 200 / moving << " of 200 pawns moving: update_world_transforms + reads " << 1e6 * cachedSeconds / FRAMES
+				  << " us, make_local_to_world on every read " << 1e6 * recursiveSeconds / FRAMES << " us (largest difference "
+				  << worst << ")" << std::endl;
+	}
+}
+
+int main()
+{
+	world_transforms();
+	return 0;
+}
@@ -0,0 +1,311 @@
+// Timings for WalkMesh on made up terrain, from about 1k to 1M triangles: finding the nearest point and walking
+// Build with 'node Maekfile.js tests/bench-walkmesh' and run it, it exits non-zero if the fast paths ever disagree with
+// the plain versions
+
+#include "WalkMesh.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtx/quaternion.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+static double seconds_since(Clock::time_point start)
+{
+	return std::chrono::duration< double >(Clock::now() - start).count();
+}
+
+static int failures = 0;
+
+// A side by side grid of quads, two triangles each, over rolling hills
+static WalkMesh terrain(uint32_t side)
+{
+	auto height = [](float x, float y) -> float
+		{
+			return 2.0f * std::sin(0.3f * x) * std::cos(0.2f * y);
+		};
+
+	std::vector<glm::vec3> vertices;
+	std::vector<glm::vec3> normals;
+	for(uint32_t y = 0; y <= side; y++)
+	{
+		for(uint32_t x = 0; x <= side; x++)
+		{
+			float fx = (float)x;
+			float fy = (float)y;
+			vertices.emplace_back(fx, fy, height(fx, fy));
+			float dx = height(fx + 0.01f, fy) - height(fx - 0.01f, fy);
+			float dy = height(fx, fy + 0.01f) - height(fx, fy - 0.01f);
+			normals.emplace_back(glm::normalize(glm::vec3(-dx / 0.02f, -dy / 0.02f, 1.0f)));
+		}
+	}
+
+	std::vector<glm::uvec3> triangles;
+	for(uint32_t y = 0; y < side; y++)
+	{
+		for(uint32_t x = 0; x < side; x++)
+		{
+			uint32_t a = y * (side + 1) + x;
+			uint32_t b = a + 1;
+			uint32_t c = a + (side + 1);
+			uint32_t d = c + 1;
+			triangles.emplace_back(a, b, d);
+			triangles.emplace_back(a, d, c);
+		}
+	}
+
+	return WalkMesh(vertices, normals, triangles);
+}
+
+static bool same(WalkPoint const& a, WalkPoint const& b)
+{
+	return a.triangle == b.triangle && a.indices == b.indices && a.weights == b.weights;
+}
+
+// The BVH against checking every triangle, for points scattered over and around the terrain
+static void nearest_walk_point()
+{
+	std::cout << "nearest_walk_point" << std::endl;
+
+	for(uint32_t side : {22, 71, 224, 708})
+	{
+		WalkMesh mesh = terrain(side);
+
+		std::mt19937 rng(1);
+		std::uniform_real_distribution<float> across(-0.1f * side, 1.1f * side);
+		std::uniform_real_distribution<float> up(-5.0f, 5.0f);
+
+		// The linear scan gets slow, so on big meshes only the first few points get answered both ways
+		size_t linearQueries = std::max<size_t>(20, 2000000 / mesh.triangles.size());
+		std::vector<glm::vec3> queries;
+		for(size_t i = 0; i < 10000; i++)
+		{
+			queries.emplace_back(across(rng), across(rng), up(rng));
+		}
+
+		std::vector<WalkPoint> fast(queries.size());
+		Clock::time_point start = Clock::now();
+		for(size_t i = 0; i < queries.size(); i++)
+		{
+			fast[i] = mesh.nearest_walk_point(queries[i]);
+		}
+		double bvhSeconds = seconds_since(start) / queries.size();
+
+		size_t mismatches = 0;
+		start = Clock::now();
+		for(size_t i = 0; i < linearQueries; i++)
+		{
+			mismatches += !same(fast[i], mesh.nearest_walk_point_linear(queries[i]));
+		}
+		double linearSeconds = seconds_since(start) / linearQueries;
+
+		std::cout << "  " << mesh.triangles.size() << " triangles: BVH " << 1e6 * bvhSeconds << " us per query, linear " << 1e6 * linearSeconds
+				  << " us (" << linearSeconds / bvhSeconds << "x), " << mismatches << " of " << linearQueries << " answers differ" << std::endl;
+		if(mismatches)
+		{
+			failures++;
+		}
+	}
+}
+
+// Counts what a container allocates, to see what the old edge map cost
+static size_t allocatedBytes = 0;
+
+template<typename T>
+struct CountingAllocator
+{
+	typedef T value_type;
+	CountingAllocator() = default;
+	template<typename U> CountingAllocator(CountingAllocator<U> const&) {}
+	T* allocate(size_t n)
+	{
+		allocatedBytes += n * sizeof(T);
+		return std::allocator<T>().allocate(n);
+	}
+	void deallocate(T* p, size_t n)
+	{
+		allocatedBytes -= n * sizeof(T);
+		std::allocator<T>().deallocate(p, n);
+	}
+	template<typename U> bool operator==(CountingAllocator<U> const&) const { return true; }
+	template<typename U> bool operator!=(CountingAllocator<U> const&) const { return false; }
+};
+
+// Same mixing as glm/gtx/hash.hpp's std::hash<glm::uvec2>, which the old map used
+struct EdgeHash
+{
+	size_t operator()(glm::uvec2 const& e) const
+	{
+		size_t seed = 0;
+		std::hash<uint32_t> hasher;
+		seed ^= hasher(e.x) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+		seed ^= hasher(e.y) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+		return seed;
+	}
+};
+
+// What WalkMesh had before adjacency: [a,b]->c, [b,c]->a and [c,a]->b for each triangle (a,b,c)
+typedef std::unordered_map<glm::uvec2, uint32_t, EdgeHash, std::equal_to<glm::uvec2>,
+	CountingAllocator<std::pair<glm::uvec2 const, uint32_t>>> NextVertex;
+
+static void build_next_vertex(WalkMesh const& mesh, NextVertex* next_vertex)
+{
+	next_vertex->reserve(mesh.triangles.size() * 3);
+	for(glm::uvec3 const& tri : mesh.triangles)
+	{
+		next_vertex->emplace(glm::uvec2(tri.x, tri.y), tri.z);
+		next_vertex->emplace(glm::uvec2(tri.y, tri.z), tri.x);
+		next_vertex->emplace(glm::uvec2(tri.z, tri.x), tri.y);
+	}
+}
+
+// WalkMesh::cross_edge as it was, looking up the far side of the edge in the map
+static bool cross_edge_map(WalkMesh const& mesh, NextVertex const& next_vertex, WalkPoint const& start, WalkPoint* end, glm::quat* rotation)
+{
+	glm::uvec2 opEdge = glm::uvec2(start.indices.y, start.indices.x);
+	auto opEdgeIt = next_vertex.find(opEdge);
+	if(opEdgeIt != next_vertex.end())
+	{
+		*end = WalkPoint(glm::uvec3(opEdge.x, opEdge.y, opEdgeIt->second), glm::vec3(start.weights.y, start.weights.x, 0.0f), -1U);
+		*rotation = glm::rotation(mesh.to_world_triangle_normal(start), mesh.to_world_triangle_normal(*end));
+		return true;
+	}
+	*end = start;
+	*rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+	return false;
+}
+
+// Locomotion::walk_one's loop, with the edge crossing handed in, returns how many edges it crossed
+template<typename Cross>
+static size_t walk(WalkMesh const& mesh, WalkPoint* at, glm::vec3 remain, Cross const& cross)
+{
+	size_t crossed = 0;
+	for(uint32_t iter = 0; iter < 10; ++iter)
+	{
+		if(remain == glm::vec3(0.0f)) break;
+		WalkPoint end;
+		float time;
+		mesh.walk_in_triangle(*at, remain, &end, &time);
+		*at = end;
+		if(time == 1.0f) break;
+		remain *= (1.0f - time);
+		glm::quat rotation;
+		if(cross(*at, &end, &rotation))
+		{
+			*at = end;
+			remain = rotation * remain;
+			crossed++;
+		}
+		else
+		{
+			glm::vec3 const& a = mesh.vertices[at->indices.x];
+			glm::vec3 const& b = mesh.vertices[at->indices.y];
+			glm::vec3 const& c = mesh.vertices[at->indices.z];
+			glm::vec3 along = glm::normalize(b - a);
+			glm::vec3 normal = glm::normalize(glm::cross(b - a, c - a));
+			glm::vec3 in = glm::cross(normal, along);
+			float d = glm::dot(remain, in);
+			remain += (d < 0.0f ? -1.25f * d : 0.01f * d) * in;
+		}
+	}
+	return crossed;
+}
+
+// The flat adjacency array against the old edge map, same walkers taking the same steps both ways
+static void edge_adjacency()
+{
+	std::cout << "edge adjacency against the old next_vertex map" << std::endl;
+
+	for(uint32_t side : {22, 224, 708})
+	{
+		WalkMesh mesh = terrain(side);
+
+		allocatedBytes = 0;
+		NextVertex next_vertex;
+		build_next_vertex(mesh, &next_vertex);
+		size_t mapBytes = allocatedBytes;
+		size_t adjacencyBytes = mesh.adjacency.capacity() * sizeof(uint32_t);
+
+		// 1000 walkers, each taking 100 steps of about two triangles in some direction
+		std::mt19937 rng(1);
+		std::uniform_real_distribution<float> across(0.0f, (float)side);
+		std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+		std::vector<WalkPoint> starts;
+		std::vector<glm::vec3> steps;
+		for(size_t i = 0; i < 1000; i++)
+		{
+			starts.push_back(mesh.nearest_walk_point(glm::vec3(across(rng), across(rng), 0.0f)));
+		}
+		for(size_t i = 0; i < 100; i++)
+		{
+			float a = angle(rng);
+			steps.emplace_back(2.0f * std::cos(a), 2.0f * std::sin(a), 0.0f);
+		}
+
+		auto run = [&](auto const& cross, std::vector<WalkPoint>* ends, size_t* crossed) -> double
+			{
+				*ends = starts;
+				*crossed = 0;
+				Clock::time_point start = Clock::now();
+				for(glm::vec3 const& step : steps)
+				{
+					for(WalkPoint& at : *ends)
+					{
+						*crossed += walk(mesh, &at, step, cross);
+					}
+				}
+				return seconds_since(start);
+			};
+
+		std::vector<WalkPoint> arrayEnds;
+		size_t arrayCrossed = 0;
+		double arraySeconds = run([&mesh](WalkPoint const& start, WalkPoint* end, glm::quat* rotation)
+			{
+				return mesh.cross_edge(start, end, rotation);
+			}, &arrayEnds, &arrayCrossed);
+
+		std::vector<WalkPoint> mapEnds;
+		size_t mapCrossed = 0;
+		double mapSeconds = run([&mesh, &next_vertex](WalkPoint const& start, WalkPoint* end, glm::quat* rotation)
+			{
+				return cross_edge_map(mesh, next_vertex, start, end, rotation);
+			}, &mapEnds, &mapCrossed);
+
+		size_t mismatches = (arrayCrossed != mapCrossed);
+		for(size_t i = 0; i < arrayEnds.size(); i++)
+		{
+			mismatches += !(arrayEnds[i].indices == mapEnds[i].indices && arrayEnds[i].weights == mapEnds[i].weights);
+		}
+
+		size_t walks = starts.size() * steps.size();
+		std::cout << "  " << mesh.triangles.size() << " triangles: adjacency " << adjacencyBytes / 1024 << " KiB, map " << mapBytes / 1024
+				  << " KiB; " << arrayCrossed << " edge crossings, adjacency " << 1e-6 * walks / arraySeconds << "M walks/s ("
+				  << 1e9 * arraySeconds / arrayCrossed << " ns of walking per crossing), map " << 1e-6 * walks / mapSeconds << "M walks/s ("
+				  << 1e9 * mapSeconds / mapCrossed << " ns), " << mismatches << " walkers ended up differently" << std::endl;
+		if(mismatches)
+		{
+			failures++;
+		}
+	}
+}
+
+int main()
+{
+	nearest_walk_point();
+	edge_adjacency();
+
+	if(failures)
+	{
+		std::cout << failures << " failed" << std::endl;
+		return 1;
+	}
+	return 0;
+}
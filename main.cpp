@@ -15,7 +15,6 @@
 
 //for screenshots:
 #include "load_save_png.hpp"
-#include "BehaviorTree.hpp"
 //Includes for libSDL:
 #include <SDL.h>
 
@@ -44,7 +43,6 @@ int main(int argc, char **argv) {
 	//when compiled on windows, unhandled exceptions don't have their message printed, which can make debugging simple issues difficult.
 	try {
 #endif
-	//BehaviorTreeTestCase();
 
 
 
@@ -0,0 +1,55 @@
+#include "null-GL.hpp"
+
+#include "GL.hpp"
+
+NullGLCalls null_gl_calls;
+
+extern "C" {
+
+GLenum APIENTRY glGetError(void) {
+	return GL_NO_ERROR;
+}
+
+void APIENTRY glUseProgram(GLuint program) {
+	if (program != 0) null_gl_calls.program_binds += 1;
+}
+
+void APIENTRY glBindVertexArray(GLuint array) {
+	if (array != 0) null_gl_calls.vao_binds += 1;
+}
+
+void APIENTRY glActiveTexture(GLenum texture) {
+}
+
+void APIENTRY glBindTexture(GLenum target, GLuint texture) {
+	null_gl_calls.texture_binds += 1;
+}
+
+void APIENTRY glUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat *value) {
+	null_gl_calls.uniform_uploads += 1;
+}
+
+void APIENTRY glUniformMatrix4x3fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat *value) {
+	null_gl_calls.uniform_uploads += 1;
+}
+
+void APIENTRY glUniformMatrix3fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat *value) {
+	null_gl_calls.uniform_uploads += 1;
+}
+
+void APIENTRY glBindBuffer(GLenum target, GLuint buffer) {
+}
+
+void APIENTRY glBufferData(GLenum target, GLsizeiptr size, const void *data, GLenum usage) {
+	null_gl_calls.buffer_uploads += 1;
+}
+
+void APIENTRY glDrawArrays(GLenum mode, GLint first, GLsizei count) {
+	null_gl_calls.draw_calls += 1;
+}
+
+void APIENTRY glDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instancecount) {
+	null_gl_calls.draw_calls += 1;
+}
+
+}
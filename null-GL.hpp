@@ -0,0 +1,22 @@
+#pragma once
+
+/*
+ * A do-nothing stand-in for the handful of GL entry points Scene::draw uses, so draws can be counted and timed
+ * without a context. Link null-GL.cpp into a tool instead of calling init_GL().
+ *
+ * Only works where GL entry points are plain functions (linux, macOS); on windows they're pointers set up by init_GL().
+ *
+ */
+
+#include <cstdint>
+
+//every call the stand-ins got, bucketed the same way as Scene::DrawStats:
+struct NullGLCalls {
+	uint32_t draw_calls = 0; //glDrawArrays + glDrawArraysInstanced
+	uint32_t program_binds = 0; //glUseProgram, not counting the unbind at the end of a draw
+	uint32_t vao_binds = 0; //glBindVertexArray, same
+	uint32_t texture_binds = 0; //glBindTexture
+	uint32_t uniform_uploads = 0; //glUniformMatrix*
+	uint32_t buffer_uploads = 0; //glBufferData
+};
+extern NullGLCalls null_gl_calls;
@@ -0,0 +1,112 @@
+#!/usr/bin/env python
+
+#Note: plain python, no blender needed, as per:
+#python collider-primitives.py <file.c> [mesh=kind ...]
+
+#Rewrites the prm0 chunk of a collmesh file (see export-collmeshes.py), fitting a sphere, capsule or box to each
+# named mesh's vertices the same way the exporter does for objects with a 'collider' property. Meshes that aren't
+# named keep whatever the file already said (a hull if it had no prm0 chunk). Any other chunks are kept as they were.
+
+import sys
+import struct
+
+if len(sys.argv) < 2:
+        print("\n\nUsage:\npython collider-primitives.py <file.c> [mesh=kind ...]\nSets the collider of each named mesh in the collmesh file to kind (hull, sphere, capsule or box).\n")
+        exit(1)
+
+filename = sys.argv[1]
+
+PRIMITIVE_KINDS = {'hull': 0, 'sphere': 1, 'capsule': 2, 'box': 3}
+
+wanted = {}
+for arg in sys.argv[2:]:
+        name, _, kind = arg.partition('=')
+        kind = kind.lower()
+        if kind not in PRIMITIVE_KINDS:
+                print("ERROR: '" + arg + "' should be mesh=kind, with kind one of " + str(list(PRIMITIVE_KINDS)))
+                exit(1)
+        wanted[name] = kind
+
+#fit a primitive around the mesh's vertices, returns (a, b, radius) as the engine wants them (same as export-collmeshes.py):
+def fit_primitive(kind, points):
+        lo = [min(p[i] for p in points) for i in range(3)]
+        hi = [max(p[i] for p in points) for i in range(3)]
+        center = [(lo[i] + hi[i]) / 2 for i in range(3)]
+        half = [(hi[i] - lo[i]) / 2 for i in range(3)]
+        if kind == 'box':
+                return (center, half, 0.0)
+        if kind == 'sphere':
+                radius = max(sum((p[i] - center[i]) ** 2 for i in range(3)) for p in points) ** 0.5
+                return (center, center, radius)
+        #capsule: runs along the longest side, as thick as the farthest vertex from that line, and with the segment
+        # long enough that every vertex is inside an end cap too:
+        axis = half.index(max(half))
+        along = [(p[axis] - center[axis], sum((p[i] - center[i]) ** 2 for i in range(3) if i != axis)) for p in points]
+        radius = max(d2 for _, d2 in along) ** 0.5
+        reach = max([abs(t) - max(radius * radius - d2, 0.0) ** 0.5 for t, d2 in along] + [0.0])
+        a = list(center)
+        b = list(center)
+        a[axis] -= reach
+        b[axis] += reach
+        return (a, b, radius)
+
+#-----------------
+
+def read_chunks(data):
+        chunks = []
+        at = 0
+        while at < len(data):
+                magic, length = struct.unpack('4sI', data[at:at + 8])
+                chunks.append((magic, data[at + 8:at + 8 + length]))
+                at += 8 + length
+        return chunks
+
+chunks = read_chunks(open(filename, 'rb').read())
+magics = [magic for magic, _ in chunks]
+#the loader only looks for prm0 right after adj0, so that has to be there first:
+for required in (b'p...', b'str0', b'idxA', b'adj0'):
+        if required not in magics:
+                print("ERROR: '" + filename + "' has no " + required.decode() + " chunk.")
+                exit(1)
+
+positions = dict(chunks)[b'p...']
+strings = dict(chunks)[b'str0']
+index = dict(chunks)[b'idxA']
+old = dict(chunks).get(b'prm0', b'')
+
+vertices = [struct.unpack('fff', positions[i:i + 12]) for i in range(0, len(positions), 12)]
+
+primitives = b''
+for m in range(0, len(index), 20):
+        name_begin, name_end, vertex_begin, vertex_end, _ = struct.unpack('IIIIf', index[m:m + 20])
+        name = strings[name_begin:name_end].decode('utf8')
+        entry = m // 20 * 32
+        if name not in wanted:
+                primitives += old[entry:entry + 32] if len(old) >= entry + 32 else struct.pack('I7f', 0, *([0.0] * 7))
+                continue
+        kind = wanted.pop(name)
+        if kind == 'hull':
+                primitives += struct.pack('I7f', 0, *([0.0] * 7))
+        else:
+                a, b, radius = fit_primitive(kind, vertices[vertex_begin:vertex_end])
+                primitives += struct.pack('I', PRIMITIVE_KINDS[kind]) + struct.pack('fff', *a) + struct.pack('fff', *b) + struct.pack('f', radius)
+        print("'" + name + "': " + kind)
+
+if wanted:
+        print("ERROR: '" + filename + "' has no mesh named " + ", ".join("'" + name + "'" for name in wanted))
+        exit(1)
+
+if b'prm0' in magics:
+        chunks[magics.index(b'prm0')] = (b'prm0', primitives)
+else:
+        chunks.insert(magics.index(b'adj0') + 1, (b'prm0', primitives))
+
+blob = open(filename, 'wb')
+for magic, data in chunks:
+        blob.write(struct.pack('4s', magic))
+        blob.write(struct.pack('I', len(data)))
+        blob.write(data)
+wrote = blob.tell()
+blob.close()
+
+print("Wrote " + str(wrote) + " bytes [" + str(len(primitives) + 8) + " bytes of primitives] to '" + filename + "'")
@@ -98,6 +98,41 @@ strings = b''
 #index gives offsets into the data (and names) for each mesh:
 index = b''
 
+#adjacency gives, for every vertex in the same order as positions, a neighbor count followed by
+# that many neighbor indices (relative to the start of its own mesh); used for hill-climbing support queries
+# (these are the mesh's own edges, hull-adjacency.py replaces them with the convex hull's after export):
+adjacency = b''
+
+#primitives gives, for every mesh in the same order as index, a kind (0 hull, 1 sphere, 2 capsule, 3 box) and its
+# shape in mesh space; set a custom property 'collider' = 'sphere' / 'capsule' / 'box' on the object to get one
+# (collider-primitives.py does the same after export, for files where the objects don't have it):
+primitives = b''
+PRIMITIVE_KINDS = {'hull': 0, 'sphere': 1, 'capsule': 2, 'box': 3}
+
+#fit a primitive around the mesh's vertices, returns (a, b, radius) as the engine wants them:
+def fit_primitive(kind, points):
+        lo = [min(p[i] for p in points) for i in range(3)]
+        hi = [max(p[i] for p in points) for i in range(3)]
+        center = [(lo[i] + hi[i]) / 2 for i in range(3)]
+        half = [(hi[i] - lo[i]) / 2 for i in range(3)]
+        if kind == 'box':
+                return (center, half, 0.0)
+        if kind == 'sphere':
+                radius = max(sum((p[i] - center[i]) ** 2 for i in range(3)) for p in points) ** 0.5
+                return (center, center, radius)
+        #capsule: runs along the longest side, as thick as the farthest vertex from that line, and with the segment
+        # long enough that every vertex is inside an end cap too (a box's corners are as far out as the radius, so
+        # the caps can't round them off and the segment has to run all the way to the ends):
+        axis = half.index(max(half))
+        along = [(p[axis] - center[axis], sum((p[i] - center[i]) ** 2 for i in range(3) if i != axis)) for p in points]
+        radius = max(d2 for _, d2 in along) ** 0.5
+        reach = max([abs(t) - max(radius * radius - d2, 0.0) ** 0.5 for t, d2 in along] + [0.0])
+        a = list(center)
+        b = list(center)
+        a[axis] -= reach
+        b[axis] += reach
+        return (a, b, radius)
+
 position_count = 0
 
 for obj in bpy.data.objects:
@@ -137,8 +172,28 @@ for obj in bpy.data.objects:
 
         vertex_end = position_count
 
+        neighbors = [[] for _ in mesh.vertices]
+        for edge in mesh.edges:
+                a, b = edge.vertices
+                neighbors[a].append(b)
+                neighbors[b].append(a)
+        for n in neighbors:
+                adjacency += struct.pack('I', len(n))
+                adjacency += struct.pack(str(len(n)) + 'I', *n)
+
         contRad = farthestSoFar ** 0.5
 
+        kind = str(obj.get('collider', 'hull')).lower()
+        if kind not in PRIMITIVE_KINDS:
+                print("ERROR: Object '" + obj.name + "' has unknown collider '" + kind + "', expected one of " + str(list(PRIMITIVE_KINDS)))
+                exit(1)
+        if kind == 'hull':
+                primitives += struct.pack('I', 0) + struct.pack('fff', 0.0, 0.0, 0.0) + struct.pack('fff', 0.0, 0.0, 0.0) + struct.pack('f', 0.0)
+        else:
+                a, b, radius = fit_primitive(kind, [vertex.co for vertex in mesh.vertices])
+                print("  as a " + kind)
+                primitives += struct.pack('I', PRIMITIVE_KINDS[kind]) + struct.pack('fff', *a) + struct.pack('fff', *b) + struct.pack('f', radius)
+
         #record mesh name, vertex range
         name_begin = len(strings)
         strings += bytes(name, "utf8")
@@ -163,10 +218,14 @@ def write_chunk(magic, data):
 write_chunk(b'p...', positions)
 write_chunk(b'str0', strings)
 write_chunk(b'idxA', index)
+write_chunk(b'adj0', adjacency)
+write_chunk(b'prm0', primitives)
 wrote = blob.tell()
 blob.close()
 
 print("Wrote " + str(wrote) + " bytes [== " +
         str(len(positions)+8) + " bytes of positions + " +
         str(len(strings)+8) + " bytes of strings + " +
-        str(len(index)+8) + " bytes of index] to '" + outfile + "'")
+        str(len(index)+8) + " bytes of index + " +
+        str(len(adjacency)+8) + " bytes of adjacency + " +
+        str(len(primitives)+8) + " bytes of primitives] to '" + outfile + "'")
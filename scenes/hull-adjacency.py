@@ -0,0 +1,165 @@
+#!/usr/bin/env python
+
+#Note: plain python, no blender needed, as per:
+#python hull-adjacency.py <file.c>
+
+#Rewrites the adj0 chunk of a collmesh file (see export-collmeshes.py) with the edge graph of each mesh's convex hull,
+# which is what CollideMesh::climb needs: a mesh's own edges only work if every vertex is on the hull and the
+# mesh is already convex. Files exported before adj0 existed get one added right after the index, any other chunks
+# are kept as they were.
+
+import sys
+import struct
+
+if len(sys.argv) != 2:
+        print("\n\nUsage:\npython hull-adjacency.py <file.c>\nReplaces the adjacency chunk of the collmesh file with one computed from each mesh's convex hull.\n")
+        exit(1)
+
+filename = sys.argv[1]
+
+def sub(a, b):
+        return (a[0] - b[0], a[1] - b[1], a[2] - b[2])
+
+def dot(a, b):
+        return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]
+
+def cross(a, b):
+        return (a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0])
+
+#incremental hull, returns outward facing triangles as (a, b, c) index triples, or None if the points are flat:
+def hull_faces(points, eps):
+        n = len(points)
+        if n < 4:
+                return None
+
+        #starting tetrahedron out of points that are far apart:
+        i0 = min(range(n), key=lambda i: points[i])
+        i1 = max(range(n), key=lambda i: dot(sub(points[i], points[i0]), sub(points[i], points[i0])))
+        line = sub(points[i1], points[i0])
+        def off_line(i):
+                c = cross(line, sub(points[i], points[i0]))
+                return dot(c, c)
+        i2 = max(range(n), key=off_line)
+        normal = cross(line, sub(points[i2], points[i0]))
+        i3 = max(range(n), key=lambda i: abs(dot(normal, sub(points[i], points[i0]))))
+        if off_line(i2) <= eps * eps or abs(dot(normal, sub(points[i3], points[i0]))) <= eps * (dot(normal, normal) ** 0.5):
+                return None
+
+        faces = []
+        def add_face(a, b, c):
+                nrm = cross(sub(points[b], points[a]), sub(points[c], points[a]))
+                length = dot(nrm, nrm) ** 0.5
+                nrm = (nrm[0] / length, nrm[1] / length, nrm[2] / length)
+                faces.append(((a, b, c), nrm, dot(nrm, points[a])))
+
+        #orient the tetrahedron so its faces look away from i3:
+        if dot(normal, sub(points[i3], points[i0])) > 0:
+                i1, i2 = i2, i1
+        add_face(i0, i1, i2)
+        add_face(i0, i3, i1)
+        add_face(i1, i3, i2)
+        add_face(i2, i3, i0)
+
+        for p in range(n):
+                if p in (i0, i1, i2, i3):
+                        continue
+                visible = [f for f in faces if dot(f[1], points[p]) - f[2] > eps]
+                if not visible:
+                        continue
+                #edges of the visible region that a hidden face shares are the horizon, the new faces fan out from them:
+                edges = set()
+                for f in visible:
+                        a, b, c = f[0]
+                        for e in ((a, b), (b, c), (c, a)):
+                                if (e[1], e[0]) in edges:
+                                        edges.remove((e[1], e[0]))
+                                else:
+                                        edges.add(e)
+                faces = [f for f in faces if not (dot(f[1], points[p]) - f[2] > eps)]
+                for a, b in edges:
+                        add_face(a, b, p)
+
+        return faces
+
+#neighbors of every vertex, indexed within the mesh:
+def hull_adjacency(points):
+        n = len(points)
+        scale = max([abs(c) for p in points for c in p] + [1.0])
+        eps = 1e-5 * scale
+
+        faces = hull_faces(points, eps)
+        if faces is None:
+                #flat (or tiny) meshes: everything neighbors everything, so climbing is one look at every vertex
+                return [[j for j in range(n) if j != i] for i in range(n)]
+
+        neighbors = [set() for _ in range(n)]
+        on_hull = set()
+        for (a, b, c), _, _ in faces:
+                on_hull.update((a, b, c))
+                for x, y in ((a, b), (b, c), (c, a)):
+                        neighbors[x].add(y)
+                        neighbors[y].add(x)
+
+        #vertices that aren't hull corners (inside, on a face, or a copy of another vertex) can step straight to any
+        # corner, so climbing from one never gets stuck; the ones lying on a face are also neighbors of that face's
+        # corners, so climbing can find them when they tie with the face:
+        corners = sorted(on_hull)
+        for v in range(n):
+                if v in on_hull:
+                        continue
+                neighbors[v].update(corners)
+                for (a, b, c), nrm, offset in faces:
+                        if abs(dot(nrm, points[v]) - offset) <= eps:
+                                for x in (a, b, c):
+                                        neighbors[x].add(v)
+
+        return [sorted(s) for s in neighbors]
+
+#-----------------
+
+def read_chunks(data):
+        chunks = []
+        at = 0
+        while at < len(data):
+                magic, length = struct.unpack('4sI', data[at:at + 8])
+                chunks.append((magic, data[at + 8:at + 8 + length]))
+                at += 8 + length
+        return chunks
+
+chunks = read_chunks(open(filename, 'rb').read())
+magics = [magic for magic, _ in chunks]
+for required in (b'p...', b'str0', b'idxA'):
+        if required not in magics:
+                print("ERROR: '" + filename + "' has no " + required.decode() + " chunk.")
+                exit(1)
+
+positions = dict(chunks)[b'p...']
+strings = dict(chunks)[b'str0']
+index = dict(chunks)[b'idxA']
+
+vertices = [struct.unpack('fff', positions[i:i + 12]) for i in range(0, len(positions), 12)]
+
+adjacency = b''
+for m in range(0, len(index), 20):
+        name_begin, name_end, vertex_begin, vertex_end, _ = struct.unpack('IIIIf', index[m:m + 20])
+        name = strings[name_begin:name_end].decode('utf8')
+        neighbors = hull_adjacency(vertices[vertex_begin:vertex_end])
+        for n in neighbors:
+                adjacency += struct.pack('I', len(n))
+                adjacency += struct.pack(str(len(n)) + 'I', *n)
+        print("'" + name + "': " + str(vertex_end - vertex_begin) + " vertices, " + str(sum(len(n) for n in neighbors)) + " neighbor entries")
+
+if b'adj0' in magics:
+        chunks[magics.index(b'adj0')] = (b'adj0', adjacency)
+else:
+        chunks.insert(magics.index(b'idxA') + 1, (b'adj0', adjacency))
+
+blob = open(filename, 'wb')
+for magic, data in chunks:
+        blob.write(struct.pack('4s', magic))
+        blob.write(struct.pack('I', len(data)))
+        blob.write(data)
+wrote = blob.tell()
+blob.close()
+
+print("Wrote " + str(wrote) + " bytes [" + str(len(adjacency) + 8) + " bytes of adjacency] to '" + filename + "'")
@@ -0,0 +1,280 @@
+// Enemy AI on the simulation clock: cooldowns, boss swings and parries, react agreeing with tick, nearest allies, and
+// that ten simulated minutes of a crowd runs headless in a small fraction of the real thing
+// Build with 'node Maekfile.js tests/test-ai' and run it, it exits non-zero if anything's off
+
+#include "BT.hpp"
+#include "SimClock.hpp"
+#include "WorkerPool.hpp"
+
+#include <glm/glm.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+static int failures = 0;
+
+static void check(bool ok, std::string const& what)
+{
+	std::cout << (ok ? "  ok    " : "  FAIL  ") << what << std::endl;
+	if(!ok)
+	{
+		failures++;
+	}
+}
+
+static float const STEP = 1.0f / 120.0f;
+
+// Puts the player straight along x from the agent
+static void sense(BT::Agent& agent, float distance, bool attacking)
+{
+	agent.hasPlayer = true;
+	agent.playerAttacking = attacking;
+	agent.toPlayer = glm::vec3(distance, 0.0f, 0.0f);
+	agent.distanceToPlayer = distance;
+	agent.bearingToPlayer = 0.0f;
+}
+
+// What the pawn gets, then cleared the way PlayMode does
+struct Decision
+{
+	glm::vec3 move;
+	uint8_t attack;
+	uint8_t parry;
+};
+
+static Decision take(BT::Agent& agent)
+{
+	Decision d{agent.move, agent.attack, agent.parry};
+	agent.move = glm::vec3(0.0f);
+	agent.attack = 0;
+	agent.parry = 0;
+	return d;
+}
+
+int main()
+{
+	std::cout << "cooldowns" << std::endl;
+	{
+		// Soldier standing in reach for ten minutes, swings as soon as it can and then every 5 simulated seconds
+		BT::Agent soldier(&BT::Tree::soldier(), 2);
+		SimClock clock;
+		std::vector<double> swings;
+		bool alwaysVertical = true;
+		for(int s = 0; s < 600 * 120; s++)
+		{
+			clock.advance(STEP);
+			sense(soldier, 3.0f, false);
+			BT::tick(soldier, clock);
+			Decision d = take(soldier);
+			if(d.attack)
+			{
+				swings.push_back(clock.now);
+				alwaysVertical = alwaysVertical && d.attack == 1;
+			}
+		}
+		check(!swings.empty() && swings.front() == (double)STEP, "first swing on the first step");
+		bool spaced = true;
+		for(size_t i = 1; i < swings.size(); i++)
+		{
+			double gap = swings[i] - swings[i - 1];
+			spaced = spaced && gap > 5.0 && gap < 5.0 + 1.5 * STEP;
+		}
+		check(spaced, "swings are just over 5 simulated seconds apart, to the step");
+		check(swings.size() == 120, "120 swings in 10 simulated minutes");
+		check(alwaysVertical, "vertical soldier always swings vertically");
+	}
+
+	std::cout << "walking" << std::endl;
+	{
+		BT::Agent soldier(&BT::Tree::soldier(), 1);
+		SimClock clock;
+		clock.advance(STEP);
+		sense(soldier, 10.0f, false);
+		BT::tick(soldier, clock);
+		Decision d = take(soldier);
+		check(d.move.x > 0.0f && d.attack == 0, "closes in from 10 away without swinging");
+
+		sense(soldier, 30.0f, false);
+		BT::tick(soldier, clock);
+		d = take(soldier);
+		check(d.move == glm::vec3(0.0f) && d.attack == 0, "ignores a player 30 away");
+
+		soldier.hasPlayer = false;
+		BT::tick(soldier, clock);
+		d = take(soldier);
+		check(d.move == glm::vec3(0.0f) && d.attack == 0, "does nothing without a player");
+	}
+
+	std::cout << "boss" << std::endl;
+	{
+		BT::Agent boss(&BT::Tree::boss(), 0);
+		SimClock clock;
+		std::vector<uint8_t> swings;
+		for(int s = 0; s < 16 * 120; s++)
+		{
+			clock.advance(STEP);
+			sense(boss, 3.0f, false);
+			BT::tick(boss, clock);
+			Decision d = take(boss);
+			if(d.attack)
+			{
+				swings.push_back(d.attack);
+			}
+		}
+		check(swings == std::vector<uint8_t>({2, 1, 2, 1}), "alternates horizontal and vertical swings");
+
+		sense(boss, 3.0f, true);
+		BT::tick(boss, clock);
+		Decision d = take(boss);
+		check(d.parry == 1 && d.attack == 0, "parries a player attacking up close");
+		BT::tick(boss, clock);
+		d = take(boss);
+		check(d.parry == 1, "keeps parrying, the parry has no cooldown");
+
+		sense(boss, 10.0f, true);
+		BT::tick(boss, clock);
+		d = take(boss);
+		check(d.parry == 0 && d.move == glm::vec3(0.0f), "doesn't parry or walk while the player swings from 10 away");
+	}
+
+	std::cout << "react" << std::endl;
+	{
+		// Same scripted ten minutes for both, react has to come out exactly like tick every step
+		BT::Tree const* trees[3] = {&BT::Tree::boss(), &BT::Tree::soldier(), &BT::Tree::soldier()};
+		bool same = true;
+		size_t swings = 0;
+		for(int type = 0; type < 3; type++)
+		{
+			BT::Agent polled(trees[type], type);
+			BT::Agent reacting(trees[type], type);
+			SimClock clock;
+			for(int s = 0; s < 600 * 120; s++)
+			{
+				clock.advance(STEP);
+				// Walks in and out of every band, and the player swings for a second out of every seven
+				float distance = 12.0f + 11.0f * std::sin(clock.now * 0.3);
+				bool attacking = (s / 120) % 7 == 0;
+				sense(polled, distance, attacking);
+				sense(reacting, distance, attacking);
+				polled.tookHit = reacting.tookHit = (s % 997 == 0);
+				BT::tick(polled, clock);
+				BT::react(reacting, clock);
+				Decision a = take(polled);
+				Decision b = take(reacting);
+				same = same && a.move == b.move && a.attack == b.attack && a.parry == b.parry;
+				swings += (a.attack != 0);
+			}
+		}
+		check(swings > 0, "the script gets them swinging");
+		check(same, "react decides exactly what tick does");
+	}
+
+	std::cout << "allies" << std::endl;
+	{
+		// Nearest ally from the cell sort against checking every pair, with some empty slots mixed in
+		WorkerPool pool(0);
+		BT::Crowd crowd;
+		crowd.allyRange = 10.0f;
+		uint32_t seed = 1;
+		auto next = [&seed]() -> float
+			{
+				seed = seed * 1664525u + 1013904223u;
+				return (float)(seed >> 8) / (float)(1u << 24);
+			};
+		for(int i = 0; i < 2000; i++)
+		{
+			crowd.add(glm::vec3(400.0f * next() - 200.0f, 400.0f * next() - 200.0f, next()), i % 7 != 0);
+		}
+		crowd.sense(glm::vec3(0.0f), pool);
+
+		bool same = true;
+		bool emptyIgnored = true;
+		size_t found = 0;
+		for(size_t i = 0; i < crowd.size(); i++)
+		{
+			float best = crowd.allyRange * crowd.allyRange;
+			size_t bestAt = i;
+			for(size_t j = 0; j < crowd.size() && crowd.present[i]; j++)
+			{
+				if(j == i || !crowd.present[j]) continue;
+				glm::vec3 d = glm::vec3(crowd.x[j] - crowd.x[i], crowd.y[j] - crowd.y[i], crowd.z[j] - crowd.z[i]);
+				float d2 = glm::dot(d, d);
+				if(d2 < best || (d2 == best && bestAt == i))
+				{
+					best = d2;
+					bestAt = j;
+				}
+			}
+			same = same && crowd.ally[i] == bestAt;
+			emptyIgnored = emptyIgnored && (crowd.ally[i] == i || crowd.present[crowd.ally[i]]) && (crowd.present[i] || crowd.ally[i] == i);
+			found += (bestAt != i);
+		}
+		check(found > 1000, "most agents have somebody within range");
+		check(same, "nearest ally from the cells matches checking every pair");
+		check(emptyIgnored, "empty slots are nobody's ally and have none");
+
+		BT::Agent agent;
+		crowd.apply(0, agent);
+		check(crowd.ally[0] == 0 && agent.distanceToAlly == std::numeric_limits<float>::infinity() && agent.toAlly == glm::vec3(0.0f),
+			"an empty slot senses no ally");
+	}
+
+	std::cout << "headless" << std::endl;
+	{
+		// A crowd of enemies running their trees for 10 simulated minutes, like PlayMode's think without the pawns
+		WorkerPool pool(0);
+		SimClock clock;
+		std::vector<BT::Agent> agents;
+		for(int i = 0; i < 16; i++)
+		{
+			agents.emplace_back(i % 3 == 0 ? &BT::Tree::boss() : &BT::Tree::soldier(), i % 3);
+		}
+		std::vector<BT::Agent*> thinkers;
+		for(BT::Agent& agent : agents)
+		{
+			thinkers.push_back(&agent);
+		}
+		std::vector<glm::vec3> positions(agents.size());
+		for(size_t i = 0; i < positions.size(); i++)
+		{
+			positions[i] = glm::vec3(0.5f * i, 3.0f, 0.0f);
+		}
+
+		BT::Crowd crowd;
+		size_t swings = 0;
+		auto start = std::chrono::steady_clock::now();
+		for(int s = 0; s < 600 * 120; s++)
+		{
+			clock.advance(STEP);
+			crowd.clear();
+			for(glm::vec3 const& p : positions)
+			{
+				crowd.add(p);
+			}
+			crowd.sense(glm::vec3(0.0f), pool);
+			BT::think(crowd, thinkers, true, (s / 120) % 7 == 0, clock, pool);
+			for(size_t i = 0; i < agents.size(); i++)
+			{
+				Decision d = take(agents[i]);
+				positions[i] += d.move * STEP;
+				swings += (d.attack != 0);
+			}
+		}
+		double seconds = std::chrono::duration< double >(std::chrono::steady_clock::now() - start).count();
+		std::cout << "  16 agents, " << clock.now << " simulated seconds in " << seconds << " real seconds" << std::endl;
+		check(swings > 0, "they get close enough to swing");
+		check(seconds < 0.5, "10 simulated minutes take under half a second");
+	}
+
+	if(failures)
+	{
+		std::cout << failures << " failed" << std::endl;
+		return 1;
+	}
+	std::cout << "all passed" << std::endl;
+	return 0;
+}
@@ -0,0 +1,616 @@
+// Known convex-convex answers for the GJK / EPA narrow phase, run through the public CollisionEngine API
+// Build with 'node Maekfile.js tests/test-collisions' and run it, it exits non-zero if anything's off
+
+#include "Collisions.hpp"
+#include "Scene.hpp"
+#include "data_path.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+static int failures = 0;
+
+static void check(bool ok, std::string const& what)
+{
+	std::cout << (ok ? "  ok    " : "  FAIL  ") << what << std::endl;
+	if(!ok)
+	{
+		failures++;
+	}
+}
+
+static bool close(float a, float b, float tolerance)
+{
+	return std::abs(a - b) <= tolerance;
+}
+
+static bool close(glm::vec3 const& a, glm::vec3 const& b, float tolerance)
+{
+	return glm::length(a - b) <= tolerance;
+}
+
+static std::vector<glm::vec3> box(glm::vec3 const& half)
+{
+	std::vector<glm::vec3> vertices;
+	for(int i = 0; i < 8; i++)
+	{
+		vertices.emplace_back((i & 1) ? half.x : -half.x, (i & 2) ? half.y : -half.y, (i & 4) ? half.z : -half.z);
+	}
+	return vertices;
+}
+
+// Latitude / longitude points on a sphere, as a hull, so it goes through GJK and not the sphere primitive
+static std::vector<glm::vec3> ball(float radius)
+{
+	std::vector<glm::vec3> vertices;
+	int const rings = 24;
+	int const segments = 48;
+	vertices.emplace_back(0.0f, 0.0f, radius);
+	vertices.emplace_back(0.0f, 0.0f, -radius);
+	for(int r = 1; r < rings; r++)
+	{
+		float phi = 3.14159265f * r / rings;
+		for(int s = 0; s < segments; s++)
+		{
+			float theta = 2.0f * 3.14159265f * s / segments;
+			vertices.emplace_back(radius * std::sin(phi) * std::cos(theta), radius * std::sin(phi) * std::sin(theta), radius * std::cos(phi));
+		}
+	}
+	return vertices;
+}
+
+// A pill along z, segment from -half to half: the ball's points pushed out to each end, top half up and bottom half down
+static std::vector<glm::vec3> pill(float half, float radius)
+{
+	std::vector<glm::vec3> vertices = ball(radius);
+	for(glm::vec3& v : vertices)
+	{
+		v.z += (v.z >= 0.0f) ? half : -half;
+	}
+	return vertices;
+}
+
+static CollidePrimitive primitive(CollidePrimitive::Kind kind, glm::vec3 const& a, glm::vec3 const& b, float radius)
+{
+	CollidePrimitive p;
+	p.kind = kind;
+	p.a = a;
+	p.b = b;
+	p.radius = radius;
+	return p;
+}
+
+// What a's callback heard from one update with a and b placed as given
+struct Result
+{
+	bool hit = false;
+	Contact contact;
+};
+
+static Result collide(CollideMesh const& ma, glm::vec3 const& pa, CollideMesh const& mb, glm::vec3 const& pb)
+{
+	Scene scene;
+	scene.transforms.emplace_back();
+	Scene::Transform* ta = &scene.transforms.back();
+	scene.transforms.emplace_back();
+	Scene::Transform* tb = &scene.transforms.back();
+	ta->position = pa;
+	tb->position = pb;
+	scene.update_world_transforms();
+
+	Result result;
+	WorkerPool pool(0);
+	CollisionEngine engine(pool);
+	// Player sword against enemy body is one of the pairs the layer matrix checks, and neither is a primitive
+	engine.registerCollider(Game::CreatureID(), ta, &ma, ma.containingRadius,
+		[&result](CollisionEvent const& e)
+		{
+			result.hit = true;
+			result.contact = e.contact;
+		}, CollisionEngine::Layer::PLAYER_SWORD_LAYER);
+	engine.registerCollider(Game::CreatureID(), tb, &mb, mb.containingRadius, [](CollisionEvent const&) {}, CollisionEngine::Layer::ENEMY_BODY_LAYER);
+	engine.update(0.0f);
+	return result;
+}
+
+// What a's callback heard from the second of two updates, a moving from pa0 to pa1 in between while b sits still
+struct SweepResult
+{
+	bool hit = false;
+	bool earlyHit = false; // Already touching at pa0, which makes the sweep meaningless
+	Contact contact;
+	float toi = 1.0f;
+};
+
+static SweepResult sweep(CollideMesh const& ma, glm::vec3 const& pa0, glm::vec3 const& pa1, bool continuous, CollideMesh const& mb, glm::vec3 const& pb)
+{
+	Scene scene;
+	scene.transforms.emplace_back();
+	Scene::Transform* ta = &scene.transforms.back();
+	scene.transforms.emplace_back();
+	Scene::Transform* tb = &scene.transforms.back();
+	ta->position = pa0;
+	tb->position = pb;
+	scene.update_world_transforms();
+
+	SweepResult result;
+	bool second = false;
+	WorkerPool pool(0);
+	CollisionEngine engine(pool);
+	engine.registerCollider(Game::CreatureID(), ta, &ma, ma.containingRadius,
+		[&result, &second](CollisionEvent const& e)
+		{
+			if(!second)
+			{
+				result.earlyHit = true;
+				return;
+			}
+			result.hit = true;
+			result.contact = e.contact;
+			result.toi = e.toi;
+		}, CollisionEngine::Layer::PLAYER_SWORD_LAYER, continuous);
+	engine.registerCollider(Game::CreatureID(), tb, &mb, mb.containingRadius, [](CollisionEvent const&) {}, CollisionEngine::Layer::ENEMY_BODY_LAYER);
+	engine.update(0.0f);
+
+	ta->position = pa1;
+	scene.update_world_transforms();
+	second = true;
+	engine.update(1.0f / 60.0f);
+	return result;
+}
+
+// Index of the first vertex with the largest dot(v, d), what every support kernel is supposed to find
+static uint32_t argmax(std::vector<glm::vec3> const& vertices, glm::vec3 const& d)
+{
+	float best = -std::numeric_limits<float>::infinity();
+	uint32_t bestIdx = 0;
+	for(uint32_t i = 0; i < (uint32_t)vertices.size(); i++)
+	{
+		float dist = glm::dot(vertices[i], d);
+		if(dist > best)
+		{
+			best = dist;
+			bestIdx = i;
+		}
+	}
+	return bestIdx;
+}
+
+static std::vector<glm::vec3> moved(std::vector<glm::vec3> vertices, glm::vec3 const& by)
+{
+	for(glm::vec3& v : vertices)
+	{
+		v += by;
+	}
+	return vertices;
+}
+
+// Two 48-gon caps, hand built with their hull edges: around each cap and straight down the side
+// The caps are exactly flat, so looking straight up or down ties a whole face
+static CollideMesh cylinder()
+{
+	int const segments = 48;
+	std::vector<glm::vec3> vertices;
+	std::vector<uint32_t> adjacencyStart;
+	std::vector<uint32_t> adjacency;
+	for(int cap = 0; cap < 2; cap++)
+	{
+		for(int s = 0; s < segments; s++)
+		{
+			float theta = 2.0f * 3.14159265f * s / segments;
+			vertices.emplace_back(std::cos(theta), std::sin(theta), cap ? -1.0f : 1.0f);
+			adjacencyStart.push_back((uint32_t)adjacency.size());
+			adjacency.push_back(cap * segments + (s + 1) % segments);
+			adjacency.push_back(cap * segments + (s + segments - 1) % segments);
+			adjacency.push_back((1 - cap) * segments + s);
+		}
+	}
+	adjacencyStart.push_back((uint32_t)adjacency.size());
+	return CollideMesh(vertices, std::sqrt(2.0f), adjacencyStart, adjacency);
+}
+
+// Climbing from random starts against the linear kernel, over random directions plus whatever extra ones are given
+// Counts directions where they found different vertices (by position, so duplicated vertices don't count)
+static size_t climb_mismatches(CollideMesh const& mesh, std::vector<glm::vec3> directions)
+{
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	std::uniform_int_distribution<uint32_t> start(0, (uint32_t)mesh.vertices.size() - 1);
+	for(int i = 0; i < 1000; i++)
+	{
+		directions.emplace_back(unit(rng), unit(rng), unit(rng));
+	}
+
+	Collider c(Game::CreatureID(), nullptr, &mesh, mesh.containingRadius, false);
+	size_t wrong = 0;
+	for(glm::vec3 const& d : directions)
+	{
+		uint32_t hint = start(rng);
+		wrong += !(c.farthest(d, &hint) == c.farthest(d));
+	}
+	return wrong;
+}
+
+int main()
+{
+	CollideMesh const unitBox(box(glm::vec3(1.0f)), std::sqrt(3.0f));
+	CollideMesh const longBox(box(glm::vec3(2.0f, 0.5f, 0.5f)), std::sqrt(4.5f));
+	CollideMesh const unitBall(ball(1.0f), 1.0f);
+
+	std::cout << "box / box" << std::endl;
+	{
+		Result r = collide(unitBox, glm::vec3(0.0f), unitBox, glm::vec3(1.5f, 0.0f, 0.0f));
+		check(r.hit, "face overlap hits");
+		check(close(r.contact.depth, 0.5f, 1e-3f), "face overlap depth 0.5");
+		check(close(r.contact.normal, glm::vec3(1.0f, 0.0f, 0.0f), 1e-3f), "face overlap normal points from a to b");
+	}
+	{
+		Result r = collide(unitBox, glm::vec3(0.0f), unitBox, glm::vec3(0.2f, 1.7f, 0.1f));
+		check(r.hit, "offset overlap hits");
+		check(close(r.contact.depth, 0.3f, 1e-3f), "offset overlap takes the shallowest axis");
+		check(close(r.contact.normal, glm::vec3(0.0f, 1.0f, 0.0f), 1e-3f), "offset overlap normal along y");
+	}
+	{
+		Result r = collide(unitBox, glm::vec3(0.0f), unitBox, glm::vec3(0.0f, 0.0f, -0.25f));
+		check(r.hit, "deep overlap hits");
+		check(close(r.contact.depth, 1.75f, 1e-3f), "deep overlap depth 1.75");
+		check(close(r.contact.normal, glm::vec3(0.0f, 0.0f, -1.0f), 1e-3f), "deep overlap normal along -z");
+	}
+	{
+		Result r = collide(unitBox, glm::vec3(0.0f), longBox, glm::vec3(2.5f, 0.0f, 1.2f));
+		check(r.hit, "long box poking into a corner hits");
+		check(close(r.contact.depth, 0.3f, 1e-3f), "long box depth 0.3 (z beats x)");
+		check(close(r.contact.normal, glm::vec3(0.0f, 0.0f, 1.0f), 1e-3f), "long box normal along z");
+	}
+	{
+		Result r = collide(unitBox, glm::vec3(0.0f), unitBox, glm::vec3(2.01f, 0.0f, 0.0f));
+		check(!r.hit, "gap of 0.01 misses");
+	}
+	{
+		Result r = collide(unitBox, glm::vec3(0.0f), unitBox, glm::vec3(2.5f, 2.5f, 0.0f));
+		check(!r.hit, "diagonal gap misses");
+	}
+	{
+		// Faces exactly touching: GJK ends on a flat simplex with the origin on its boundary, which EPA has to
+		// grow into a tetrahedron before it can expand anything
+		Result r = collide(unitBox, glm::vec3(0.0f), unitBox, glm::vec3(2.0f, 0.0f, 0.0f));
+		check(r.hit, "touching faces count as a hit");
+		check(close(r.contact.depth, 0.0f, 1e-3f), "touching faces have no depth");
+		check(std::abs(r.contact.normal.x) > 0.999f, "touching faces normal along x");
+	}
+
+	// A faceted ball's depth is good to about the facet size, but its normal isn't: tilting the normal a few degrees
+	// only changes the depth by 1 - cos of that, so EPA is free to stop anywhere in there
+	std::cout << "ball / ball" << std::endl;
+	{
+		Result r = collide(unitBall, glm::vec3(0.0f), unitBall, glm::vec3(0.0f, 1.5f, 0.0f));
+		check(r.hit, "overlap hits");
+		check(close(r.contact.depth, 0.5f, 0.02f), "overlap depth about 0.5");
+		check(glm::dot(r.contact.normal, glm::vec3(0.0f, 1.0f, 0.0f)) > 0.98f, "overlap normal within 10 degrees of y");
+	}
+	{
+		glm::vec3 offset = glm::normalize(glm::vec3(1.0f, 1.0f, 1.0f)) * 1.0f;
+		Result r = collide(unitBall, glm::vec3(0.0f), unitBall, offset);
+		check(r.hit, "diagonal overlap hits");
+		check(close(r.contact.depth, 1.0f, 0.03f), "diagonal overlap depth about 1");
+		check(glm::dot(r.contact.normal, glm::normalize(offset)) > 0.98f, "diagonal overlap normal within 10 degrees of the centers");
+	}
+	{
+		Result r = collide(unitBall, glm::vec3(0.0f), unitBall, glm::vec3(2.05f, 0.0f, 0.0f));
+		check(!r.hit, "apart misses");
+	}
+
+	std::cout << "ball / box" << std::endl;
+	{
+		Result r = collide(unitBall, glm::vec3(0.0f), unitBox, glm::vec3(0.0f, 0.0f, 1.8f));
+		check(r.hit, "ball into a face hits");
+		check(close(r.contact.depth, 0.2f, 0.02f), "ball into a face depth about 0.2");
+		check(close(r.contact.normal, glm::vec3(0.0f, 0.0f, 1.0f), 0.02f), "ball into a face normal along z");
+	}
+	{
+		// The box corner is sqrt(3) - 1 past the ball's reach along the diagonal
+		Result r = collide(unitBall, glm::vec3(0.0f), unitBox, glm::vec3(1.8f, 1.8f, 1.8f));
+		check(!r.hit, "ball near a corner misses");
+	}
+
+	// The same shapes as primitives: two primitives take the closed form, a primitive against a hull still goes
+	// through GJK on the primitive's vertices, so mixed pairs have to agree with both
+	std::cout << "primitives" << std::endl;
+	{
+		CollideMesh const sphere(ball(1.0f), 1.0f, {}, {}, primitive(CollidePrimitive::SPHERE, glm::vec3(0.0f), glm::vec3(0.0f), 1.0f));
+		CollideMesh const capsule(pill(1.0f, 0.5f), 1.5f, {}, {},
+			primitive(CollidePrimitive::CAPSULE, glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 0.0f, 1.0f), 0.5f));
+		CollideMesh const cube(box(glm::vec3(1.0f)), std::sqrt(3.0f), {}, {}, primitive(CollidePrimitive::BOX, glm::vec3(0.0f), glm::vec3(1.0f), 0.0f));
+		CollideMesh const hullPill(pill(1.0f, 0.5f), 1.5f);
+
+		Result r = collide(sphere, glm::vec3(0.0f), sphere, glm::vec3(0.0f, 1.5f, 0.0f));
+		check(r.hit && close(r.contact.depth, 0.5f, 1e-4f) && close(r.contact.normal, glm::vec3(0.0f, 1.0f, 0.0f), 1e-4f), "sphere / sphere exact depth and normal");
+		r = collide(capsule, glm::vec3(0.0f), capsule, glm::vec3(0.8f, 0.0f, 1.5f));
+		check(r.hit && close(r.contact.depth, 0.2f, 1e-4f) && close(r.contact.normal, glm::vec3(1.0f, 0.0f, 0.0f), 1e-4f), "capsule / capsule side by side depth 0.2 along x");
+		r = collide(capsule, glm::vec3(0.0f), cube, glm::vec3(0.0f, 0.0f, 2.2f));
+		check(r.hit && close(r.contact.depth, 0.3f, 1e-4f) && close(r.contact.normal, glm::vec3(0.0f, 0.0f, 1.0f), 1e-4f), "capsule end into a box face depth 0.3");
+		r = collide(cube, glm::vec3(0.0f), cube, glm::vec3(0.2f, 1.7f, 0.1f));
+		check(r.hit && close(r.contact.depth, 0.3f, 1e-4f) && close(r.contact.normal, glm::vec3(0.0f, 1.0f, 0.0f), 1e-4f), "box / box takes the shallowest axis");
+		check(!collide(sphere, glm::vec3(0.0f), cube, glm::vec3(1.8f, 1.8f, 1.8f)).hit, "sphere near a box corner misses");
+		check(!collide(capsule, glm::vec3(0.0f), capsule, glm::vec3(1.05f, 0.0f, 0.0f)).hit, "capsules 0.05 apart miss");
+
+		r = collide(sphere, glm::vec3(0.0f), unitBox, glm::vec3(0.0f, 0.0f, 1.8f));
+		check(r.hit && close(r.contact.depth, 0.2f, 0.02f) && close(r.contact.normal, glm::vec3(0.0f, 0.0f, 1.0f), 0.02f), "sphere / hull box depth about 0.2");
+		check(!collide(sphere, glm::vec3(0.0f), unitBox, glm::vec3(1.8f, 1.8f, 1.8f)).hit, "sphere / hull box near a corner misses");
+		r = collide(capsule, glm::vec3(0.0f), unitBox, glm::vec3(1.3f, 0.0f, 0.5f));
+		check(r.hit && close(r.contact.depth, 0.2f, 0.02f) && close(r.contact.normal, glm::vec3(1.0f, 0.0f, 0.0f), 0.02f), "capsule side / hull box depth about 0.2");
+		check(!collide(capsule, glm::vec3(0.0f), unitBox, glm::vec3(0.0f, 0.0f, 2.6f)).hit, "capsule end / hull box 0.1 apart misses");
+		r = collide(cube, glm::vec3(0.0f), unitBall, glm::vec3(1.5f, 0.0f, 0.0f));
+		check(r.hit && close(r.contact.depth, 0.5f, 0.02f) && glm::dot(r.contact.normal, glm::vec3(1.0f, 0.0f, 0.0f)) > 0.98f, "box / hull ball depth about 0.5");
+		check(!collide(cube, glm::vec3(0.0f), unitBall, glm::vec3(1.8f, 1.8f, 1.8f)).hit, "box / hull ball off the corner misses");
+
+		// The pill hull is the capsule give or take its facets, so hit or miss can only differ right at the surface
+		std::mt19937 rng(1);
+		std::uniform_real_distribution<float> place(-2.5f, 2.5f);
+		size_t differ = 0;
+		size_t hits = 0;
+		for(int i = 0; i < 200; i++)
+		{
+			glm::vec3 at(place(rng), place(rng), place(rng));
+			Result exact = collide(capsule, glm::vec3(0.0f), cube, at);
+			bool mixed = collide(hullPill, glm::vec3(0.0f), cube, at).hit;
+			hits += exact.hit;
+			differ += (exact.hit != mixed) && exact.contact.depth > 0.02f;
+		}
+		check(hits > 20 && differ == 0, "capsule / box agrees with capsule hull / box (" + std::to_string(hits) + " of 200 touching)");
+	}
+	{
+		// What the game collides with, primitives from scenes/collider-primitives.py: boxes that hold every vertex
+		CollideMeshes meshes(data_path("../dist/sword.c"));
+		for(char const* name : {"EnemyCollMesh", "PlayerCollMesh", "EnemySwordCollMesh", "EnemySwordBrokenCollMesh"})
+		{
+			CollidePrimitive const& p = meshes.lookup(name).primitive;
+			bool inside = true;
+			for(glm::vec3 const& v : meshes.lookup(name).vertices)
+			{
+				glm::vec3 out = glm::abs(v - p.a) - p.b;
+				inside = inside && std::max(out.x, std::max(out.y, out.z)) <= 1e-4f;
+			}
+			check(p.kind == CollidePrimitive::BOX && inside, std::string(name) + " from dist/sword.c is a box around its vertices");
+		}
+		check(meshes.lookup("PlayerSwordCollMesh").primitive.kind == CollidePrimitive::HULL, "PlayerSwordCollMesh from dist/sword.c stays a hull");
+	}
+
+	// Queries answer from the last update's broad phase, layer masks pick what they see, and the nearest hit wins
+	std::cout << "queries" << std::endl;
+	{
+		Scene scene;
+		auto place = [&scene](glm::vec3 const& at) -> Scene::Transform*
+			{
+				scene.transforms.emplace_back();
+				scene.transforms.back().position = at;
+				return &scene.transforms.back();
+			};
+		// Far enemy registered first, so the nearest hit can't just be the first one found
+		Scene::Transform* farBox = place(glm::vec3(10.0f, 0.0f, 0.0f));
+		Scene::Transform* nearBox = place(glm::vec3(5.0f, 0.0f, 0.0f));
+		Scene::Transform* playerBox = place(glm::vec3(3.0f, 0.0f, 0.0f));
+		scene.update_world_transforms();
+
+		WorkerPool pool(0);
+		CollisionEngine engine(pool);
+		auto quiet = [](CollisionEvent const&) {};
+		CollisionEngine::ID farID = engine.registerCollider(Game::CreatureID(), farBox, &unitBox, unitBox.containingRadius, quiet, CollisionEngine::ENEMY_BODY_LAYER);
+		CollisionEngine::ID nearID = engine.registerCollider(Game::CreatureID(), nearBox, &unitBox, unitBox.containingRadius, quiet, CollisionEngine::ENEMY_BODY_LAYER);
+		CollisionEngine::ID playerID = engine.registerCollider(Game::CreatureID(), playerBox, &unitBox, unitBox.containingRadius, quiet, CollisionEngine::PLAYER_BODY_LAYER);
+
+		CollisionEngine::QueryHit hit;
+		check(!engine.raycast(glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), 100.0f, CollisionEngine::ALL_LAYERS, &hit), "nothing to hit before the first update");
+		engine.update(0.0f);
+
+		CollisionEngine::LayerMask enemies = CollisionEngine::layer_mask(CollisionEngine::ENEMY_BODY_LAYER);
+		bool ok = engine.raycast(glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), 100.0f, CollisionEngine::ALL_LAYERS, &hit);
+		check(ok && hit.id == playerID && hit.transform == playerBox && close(hit.distance, 2.0f, 1e-3f), "ray hits the nearest box first, on any layer");
+		ok = engine.raycast(glm::vec3(0.0f), glm::vec3(2.0f, 0.0f, 0.0f), 100.0f, enemies, &hit);
+		check(ok && hit.id == nearID && hit.layer == CollisionEngine::ENEMY_BODY_LAYER && close(hit.distance, 4.0f, 1e-3f),
+			"ray masked to enemies goes past the player to the nearer enemy (direction not unit)");
+		check(ok && close(hit.point, glm::vec3(4.0f, 0.0f, 0.0f), 1e-3f) && close(hit.normal, glm::vec3(-1.0f, 0.0f, 0.0f), 1e-3f), "ray hit point and normal on the near face");
+		ok = engine.raycast(glm::vec3(20.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f), 100.0f, enemies, &hit);
+		check(ok && hit.id == farID && close(hit.distance, 9.0f, 1e-3f), "ray from the other side hits the far enemy first");
+		check(!engine.raycast(glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), 3.5f, enemies, &hit), "ray that stops short misses");
+		check(!engine.raycast(glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f), 100.0f, CollisionEngine::ALL_LAYERS, &hit), "ray pointing away misses");
+		check(!engine.raycast(glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), 100.0f, CollisionEngine::layer_mask(CollisionEngine::PLAYER_SWORD_LAYER), &hit),
+			"ray masked to an empty layer misses");
+		check(!engine.raycast(glm::vec3(0.0f, 1.4f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), 100.0f, enemies, &hit), "ray passing 0.4 over the boxes misses");
+
+		ok = engine.sweepSphere(glm::vec3(0.0f, 1.4f, 0.0f), 0.5f, glm::vec3(1.0f, 0.0f, 0.0f), 100.0f, enemies, &hit);
+		check(ok && hit.id == nearID && close(hit.distance, 4.0f - std::sqrt(0.25f - 0.16f), 1e-2f), "ball catches the near enemy's top edge where the ray missed");
+		ok = engine.sweepSphere(glm::vec3(0.0f), 0.5f, glm::vec3(1.0f, 0.0f, 0.0f), 100.0f, CollisionEngine::ALL_LAYERS, &hit);
+		check(ok && hit.id == playerID && close(hit.distance, 1.5f, 1e-2f) && close(hit.normal, glm::vec3(-1.0f, 0.0f, 0.0f), 1e-2f),
+			"ball sweep stops half its radius short of the nearest face");
+		ok = engine.sweepSphere(glm::vec3(5.0f, 0.0f, 0.0f), 0.5f, glm::vec3(1.0f, 0.0f, 0.0f), 100.0f, enemies, &hit);
+		check(ok && hit.id == nearID && hit.distance == 0.0f, "ball starting inside an enemy hits it at distance 0");
+		check(!engine.sweepSphere(glm::vec3(0.0f, 1.6f, 0.0f), 0.5f, glm::vec3(1.0f, 0.0f, 0.0f), 100.0f, enemies, &hit), "ball passing 0.1 over the boxes misses");
+		check(!engine.sweepSphere(glm::vec3(0.0f), 0.5f, glm::vec3(1.0f, 0.0f, 0.0f), 1.4f, CollisionEngine::ALL_LAYERS, &hit), "ball that stops short misses");
+
+		std::vector<CollisionEngine::QueryHit> hits;
+		size_t added = engine.overlapSphere(glm::vec3(7.5f, 0.0f, 0.0f), 1.6f, CollisionEngine::ALL_LAYERS, &hits);
+		bool both = (added == 2 && hits.size() == 2) && ((hits[0].id == nearID && hits[1].id == farID) || (hits[0].id == farID && hits[1].id == nearID));
+		check(both, "overlap between the enemies finds both");
+		check(both && close(std::min(hits[0].point.x, hits[1].point.x), 6.0f, 1e-3f) && close(std::max(hits[0].point.x, hits[1].point.x), 9.0f, 1e-3f),
+			"overlap points are on the facing sides");
+		check(engine.overlapSphere(glm::vec3(7.5f, 0.0f, 0.0f), 1.4f, CollisionEngine::ALL_LAYERS, &hits) == 0 && hits.size() == 2,
+			"overlap that doesn't reach adds nothing");
+		check(engine.overlapSphere(glm::vec3(4.0f, 0.0f, 0.0f), 0.5f, CollisionEngine::layer_mask(CollisionEngine::PLAYER_BODY_LAYER), &hits) == 1 &&
+			hits.back().id == playerID, "overlap masked to the player skips the enemy it also touches");
+		check(engine.overlapSphere(glm::vec3(5.0f, 0.2f, 0.0f), 0.1f, enemies, &hits) == 1 && hits.back().id == nearID &&
+			hits.back().normal == glm::vec3(0.0f), "overlap centered inside a box has no normal");
+
+		// Moved since the last update: queries still see the old spot until the next one
+		nearBox->position = glm::vec3(5.0f, 50.0f, 0.0f);
+		scene.update_world_transforms();
+		ok = engine.raycast(glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), 100.0f, enemies, &hit);
+		check(ok && hit.id == nearID, "queries see the last update, not where things are now");
+		engine.update(0.0f);
+		ok = engine.raycast(glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), 100.0f, enemies, &hit);
+		check(ok && hit.id == farID, "after the next update the ray goes on to the far enemy");
+	}
+
+	// Unregistering moves the last collider on the layer into the hole, its pairs have to keep going as if nothing happened
+	std::cout << "unregister" << std::endl;
+	{
+		struct Heard
+		{
+			std::vector<CollisionEvent::Phase> phases;
+			std::vector<Scene::Transform*> others;
+		};
+
+		Scene scene;
+		std::vector<Scene::Transform*> t;
+		for(int i = 0; i < 4; i++)
+		{
+			scene.transforms.emplace_back();
+			t.push_back(&scene.transforms.back());
+		}
+		// Swords a, b and c in that order on one layer, c on top of body x, a and b off on their own
+		t[0]->position = glm::vec3(100.0f, 0.0f, 0.0f);
+		t[1]->position = glm::vec3(200.0f, 0.0f, 0.0f);
+		t[2]->position = glm::vec3(1.5f, 0.0f, 0.0f);
+		t[3]->position = glm::vec3(0.0f);
+		scene.update_world_transforms();
+
+		WorkerPool pool(0);
+		CollisionEngine engine(pool);
+		std::vector<Heard> heard(4);
+		std::vector<CollisionEngine::ID> ids;
+		bool dropB = false;
+		for(int i = 0; i < 4; i++)
+		{
+			ids.push_back(engine.registerCollider(Game::CreatureID(), t[i], &unitBox, unitBox.containingRadius,
+				[&, i](CollisionEvent const& e)
+				{
+					heard[i].phases.push_back(e.phase);
+					heard[i].others.push_back(e.otherTransform);
+					if(dropB)
+					{
+						engine.unregisterCollider(ids[1]);
+						dropB = false;
+					}
+				}, (i < 3) ? CollisionEngine::Layer::PLAYER_SWORD_LAYER : CollisionEngine::Layer::ENEMY_BODY_LAYER));
+		}
+
+		engine.update(0.0f);
+		check(heard[2].phases.size() == 1 && heard[2].phases[0] == CollisionEvent::BEGIN, "c begins touching x");
+
+		// c gets swapped into a's slot, then b goes from inside a callback while events are going out
+		engine.unregisterCollider(ids[0]);
+		dropB = true;
+		engine.update(0.0f);
+		check(heard[2].phases.size() == 2 && heard[2].phases[1] == CollisionEvent::STAY, "c stays touching after moving slots (no second BEGIN)");
+		check(heard[3].phases.size() == 2 && heard[3].phases[1] == CollisionEvent::STAY && heard[3].others[1] == t[2], "x still sees c as c");
+
+		t[2]->position = glm::vec3(10.0f, 0.0f, 0.0f);
+		scene.update_world_transforms();
+		engine.update(0.0f);
+		check(heard[2].phases.size() == 3 && heard[2].phases[2] == CollisionEvent::END && heard[2].others[2] == t[3], "c gets END from x when it leaves");
+		check(heard[3].phases.size() == 3 && heard[3].phases[2] == CollisionEvent::END && heard[3].others[2] == t[2], "x gets END from c");
+		check(heard[0].phases.empty() && heard[1].phases.empty(), "a and b never heard anything");
+
+		// b is gone now, so c (the only sword left) is who touches x from here on
+		t[1]->position = glm::vec3(0.0f, 1.5f, 0.0f);
+		t[2]->position = glm::vec3(1.5f, 0.0f, 0.0f);
+		scene.update_world_transforms();
+		engine.update(0.0f);
+		check(heard[1].phases.empty(), "b unregistered from a callback stays gone");
+		check(heard[2].phases.size() == 4 && heard[2].phases[3] == CollisionEvent::BEGIN, "c touching x again is a new BEGIN");
+		engine.unregisterCollider(ids[0]);
+		engine.unregisterCollider(ids[1]);
+		engine.update(0.0f);
+		check(heard[2].phases.size() == 5 && heard[2].phases[4] == CollisionEvent::STAY, "unregistering ids twice does nothing");
+	}
+
+	// A small box going straight through a thin plate in one update, which the discrete test never sees
+	std::cout << "continuous" << std::endl;
+	{
+		CollideMesh const plate(box(glm::vec3(1.0f, 1.0f, 0.02f)), std::sqrt(2.0004f));
+		CollideMesh const bullet(box(glm::vec3(0.1f)), std::sqrt(0.03f));
+
+		SweepResult discrete = sweep(bullet, glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f, 0.0f, -3.0f), false, plate, glm::vec3(0.0f));
+		check(!discrete.earlyHit && !discrete.hit, "discrete collider tunnels through the plate");
+
+		SweepResult through = sweep(bullet, glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f, 0.0f, -3.0f), true, plate, glm::vec3(0.0f));
+		check(!through.earlyHit && through.hit, "continuous collider hits the plate");
+		// Touches once it has come 3 - 0.1 - 0.02 of the 6
+		check(close(through.toi, 2.88f / 6.0f, 0.01f), "time of impact about 0.48");
+		check(glm::dot(through.contact.normal, glm::vec3(0.0f, 0.0f, -1.0f)) > 0.99f, "normal points down into the plate");
+
+		SweepResult edge = sweep(bullet, glm::vec3(1.05f, 0.0f, 3.0f), glm::vec3(1.05f, 0.0f, -3.0f), true, plate, glm::vec3(0.0f));
+		check(edge.hit, "clipping the plate's edge by 0.05 hits");
+
+		SweepResult nearMiss = sweep(bullet, glm::vec3(1.15f, 0.0f, 3.0f), glm::vec3(1.15f, 0.0f, -3.0f), true, plate, glm::vec3(0.0f));
+		check(!nearMiss.earlyHit && !nearMiss.hit, "passing 0.05 outside the plate's edge misses");
+
+		SweepResult diagonalMiss = sweep(bullet, glm::vec3(1.15f, 1.15f, 3.0f), glm::vec3(1.15f, 1.15f, -3.0f), true, plate, glm::vec3(0.0f));
+		check(!diagonalMiss.hit, "passing just off the plate's corner misses");
+
+		SweepResult stopsShort = sweep(bullet, glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f, 0.0f, 0.2f), true, plate, glm::vec3(0.0f));
+		check(!stopsShort.hit, "stopping 0.08 short of the plate misses");
+	}
+
+	// Straight to Collider::farthest, with no hint so it's whichever linear kernel this cpu gets
+	std::cout << "support" << std::endl;
+	{
+		CollideMesh const behind(moved(box(glm::vec3(1.0f)), glm::vec3(-5.0f, 0.0f, 0.0f)), 6.0f);
+		Collider c(Game::CreatureID(), nullptr, &behind, behind.containingRadius, false);
+		check(c.farthest(glm::vec3(1.0f, 0.0f, 0.0f)) == glm::vec3(-4.0f, -1.0f, -1.0f), "mesh all behind the origin still gives its farthest vertex");
+		check(c.farthest(glm::vec3(0.0f)) == behind.vertices[0], "zero direction ties everything, gives vertex 0");
+	}
+	{
+		Collider c(Game::CreatureID(), nullptr, &unitBox, unitBox.containingRadius, false);
+		check(c.farthest(glm::vec3(0.0f, 1.0f, 0.0f)) == unitBox.vertices[2], "face square to d gives its lowest index vertex");
+	}
+	{
+		// Lots of ties across SIMD lanes, and enough vertices to go round the kernel loops many times
+		CollideMesh const offBall(moved(ball(1.0f), glm::vec3(0.3f, -2.0f, 0.7f)), 3.0f);
+		Collider c(Game::CreatureID(), nullptr, &offBall, offBall.containingRadius, false);
+		std::mt19937 rng(1);
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+		size_t wrong = 0;
+		for(int i = 0; i < 1000; i++)
+		{
+			glm::vec3 d = (i % 4 == 0) ? glm::vec3(0.0f, 0.0f, (i % 8 == 0) ? 1.0f : -1.0f) : glm::vec3(unit(rng), unit(rng), unit(rng));
+			wrong += !(c.farthest(d) == offBall.vertices[argmax(offBall.vertices, d)]);
+		}
+		check(wrong == 0, "kernel matches a plain argmax over 1000 directions");
+	}
+
+	// Climbing has to land on exactly what the linear kernels find, ties and all
+	std::cout << "climb" << std::endl;
+	{
+		CollideMesh const cyl = cylinder();
+		check(cyl.can_climb(), "cylinder climbs");
+		check(climb_mismatches(cyl, {glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 0.0f, 2.5f)}) == 0,
+			"cylinder climb matches the kernel, including flat caps");
+	}
+	{
+		// What the game collides with, adjacency from scenes/hull-adjacency.py
+		CollideMeshes meshes(data_path("../dist/sword.c"));
+		for(char const* name : {"EnemyCollMesh", "PlayerCollMesh"})
+		{
+			CollideMesh const& mesh = meshes.lookup(name);
+			check(mesh.can_climb(), std::string(name) + " from dist/sword.c climbs");
+			check(climb_mismatches(mesh, {glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f)}) == 0,
+				std::string(name) + " climb matches the kernel");
+		}
+	}
+
+	if(failures)
+	{
+		std::cout << failures << " failed" << std::endl;
+		return 1;
+	}
+	std::cout << "all passed" << std::endl;
+	return 0;
+}